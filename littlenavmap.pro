@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui sql xml network svg printsupport
+QT       += core gui sql xml network svg printsupport concurrent
 
 # axcontainer axserver concurrent core dbus declarative designer gui help multimedia
 # multimediawidgets network opengl printsupport qml qmltest x11extras quick script scripttools
@@ -178,7 +178,21 @@ SOURCES += src/main.cpp\
     src/common/mapflags.cpp \
     src/common/elevationprovider.cpp \
     src/mapgui/mappaintership.cpp \
-    src/mapgui/mappaintervehicle.cpp
+    src/mapgui/mappaintervehicle.cpp \
+    src/common/stringpool.cpp \
+    src/common/sqlrecordbinding.cpp \
+    src/common/memorycache.cpp \
+    src/common/symbolatlas.cpp \
+    src/common/labelplacement.cpp \
+    src/mapgui/mappaintprofiler.cpp \
+    src/common/geometrybatch.cpp \
+    src/common/greatcirclecache.cpp \
+    src/connect/simdatahub.cpp \
+    src/connect/simdatarecorder.cpp \
+    src/connect/simdatagenerator.cpp \
+    src/common/aiaircraftindex.cpp \
+    src/connect/simdatacodec.cpp \
+    src/common/trackjournal.cpp
 
 HEADERS  += src/gui/mainwindow.h \
     src/search/columnlist.h \
@@ -261,7 +275,22 @@ HEADERS  += src/gui/mainwindow.h \
     src/common/mapflags.h \
     src/common/elevationprovider.h \
     src/mapgui/mappaintership.h \
-    src/mapgui/mappaintervehicle.h
+    src/mapgui/mappaintervehicle.h \
+    src/common/stringpool.h \
+    src/common/sqlrecordbinding.h \
+    src/common/memorycache.h \
+    src/common/symbolatlas.h \
+    src/common/labelplacement.h \
+    src/mapgui/mappaintprofiler.h \
+    src/common/geometrybatch.h \
+    src/common/greatcirclecache.h \
+    src/common/latestvaluebuffer.h \
+    src/connect/simdatahub.h \
+    src/connect/simdatarecorder.h \
+    src/connect/simdatagenerator.h \
+    src/common/aiaircraftindex.h \
+    src/connect/simdatacodec.h \
+    src/common/trackjournal.h
 
 FORMS    += src/gui/mainwindow.ui \
     src/db/databasedialog.ui \
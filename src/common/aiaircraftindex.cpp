@@ -0,0 +1,137 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "common/aiaircraftindex.h"
+
+#include "fs/sc/simconnectaircraft.h"
+
+#include <algorithm>
+
+using atools::fs::sc::SimConnectAircraft;
+
+void AiAircraftIndex::update(const QVector<SimConnectAircraft>& aircraft)
+{
+  cells.clear();
+  positions.clear();
+  positions.reserve(aircraft.size());
+  generation++;
+
+  for(int i = 0; i < aircraft.size(); i++)
+  {
+    const atools::geo::Pos& pos = aircraft.at(i).getPosition();
+    positions.append(std::make_pair(pos.getLonX(), pos.getLatY()));
+
+    if(pos.isValid())
+      cells[cellRow(pos.getLatY()) * NUM_COLUMNS + cellColumn(pos.getLonX())].append(i);
+  }
+}
+
+void AiAircraftIndex::clear()
+{
+  cells.clear();
+  positions.clear();
+  generation++;
+}
+
+int AiAircraftIndex::cellColumn(float lonX)
+{
+  return std::min(std::max(static_cast<int>((lonX + 180.f) / CELL_SIZE_DEG), 0), NUM_COLUMNS - 1);
+}
+
+int AiAircraftIndex::cellRow(float latY)
+{
+  return std::min(std::max(static_cast<int>((latY + 90.f) / CELL_SIZE_DEG), 0), NUM_ROWS - 1);
+}
+
+template<typename FUNC>
+void AiAircraftIndex::forEachInRect(float west, float north, float east, float south, FUNC func) const
+{
+  if(cells.isEmpty())
+    return;
+
+  bool crossesDateLine = west > east;
+  auto contains = [ = ](const std::pair<float, float>& pos) -> bool
+                  {
+                    if(pos.second > north || pos.second < south)
+                      return false;
+
+                    if(crossesDateLine)
+                      return pos.first >= west || pos.first <= east;
+                    else
+                      return pos.first >= west && pos.first <= east;
+                  };
+
+  int rowMin = cellRow(south), rowMax = cellRow(north);
+  int colWest = cellColumn(west), colEast = cellColumn(east);
+  int numColumns = crossesDateLine ? NUM_COLUMNS - colWest + colEast + 1 : colEast - colWest + 1;
+
+  if((rowMax - rowMin + 1) * numColumns > cells.size())
+  {
+    // Large rectangle - less work to check all occupied cells
+    for(const QVector<int>& cell : cells)
+    {
+      for(int index : cell)
+      {
+        if(contains(positions.at(index)) && !func(index))
+          return;
+      }
+    }
+  }
+  else
+  {
+    for(int row = rowMin; row <= rowMax; row++)
+    {
+      for(int c = 0; c < numColumns; c++)
+      {
+        auto it = cells.constFind(row * NUM_COLUMNS + (colWest + c) % NUM_COLUMNS);
+        if(it != cells.constEnd())
+        {
+          for(int index : it.value())
+          {
+            if(contains(positions.at(index)) && !func(index))
+              return;
+          }
+        }
+      }
+    }
+  }
+}
+
+void AiAircraftIndex::getIndexes(float west, float north, float east, float south, QVector<int>& indexes) const
+{
+  indexes.clear();
+  forEachInRect(west, north, east, south, [&indexes](int index) -> bool
+                {
+                  indexes.append(index);
+                  return true;
+                });
+
+  // Keep order of the AI list
+  std::sort(indexes.begin(), indexes.end());
+}
+
+bool AiAircraftIndex::hasAircraft(float west, float north, float east, float south) const
+{
+  bool found = false;
+  forEachInRect(west, north, east, south, [&found](int) -> bool
+                {
+                  found = true;
+                  return false;
+                });
+  return found;
+}
@@ -0,0 +1,85 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_AIAIRCRAFTINDEX_H
+#define LITTLENAVMAP_AIAIRCRAFTINDEX_H
+
+#include <QHash>
+#include <QVector>
+
+#include <utility>
+
+namespace atools {
+namespace fs {
+namespace sc {
+class SimConnectAircraft;
+}
+}
+}
+
+/*
+ * Grid index for the positions of AI aircraft and ships of one simulator packet.
+ * Rebuilt for each packet and used for visibility checks and mouse over lookups instead of scanning
+ * all AI vehicles.
+ */
+class AiAircraftIndex
+{
+public:
+  /* Rebuild the grid for the AI list of a new packet */
+  void update(const QVector<atools::fs::sc::SimConnectAircraft>& aircraft);
+  void clear();
+
+  /* Get indexes into the AI list of all vehicles inside the rectangle.
+   * Rectangle can cross the anti-meridian (west > east). */
+  void getIndexes(float west, float north, float east, float south, QVector<int>& indexes) const;
+
+  /* true if any vehicle is inside the rectangle */
+  bool hasAircraft(float west, float north, float east, float south) const;
+
+  /* Incremented with each update. Used to detect changes for dependent caches. */
+  quint32 getGeneration() const
+  {
+    return generation;
+  }
+
+  int size() const
+  {
+    return positions.size();
+  }
+
+private:
+  /* Call func for each index inside the rectangle until it returns false */
+  template<typename FUNC>
+  void forEachInRect(float west, float north, float east, float south, FUNC func) const;
+
+  static int cellColumn(float lonX);
+  static int cellRow(float latY);
+
+  static Q_DECL_CONSTEXPR float CELL_SIZE_DEG = 1.f;
+  static Q_DECL_CONSTEXPR int NUM_COLUMNS = 360;
+  static Q_DECL_CONSTEXPR int NUM_ROWS = 180;
+
+  /* Maps cell (row * NUM_COLUMNS + column) to indexes into positions */
+  QHash<int, QVector<int> > cells;
+
+  /* Longitude and latitude of each vehicle, invalid positions are not in the grid */
+  QVector<std::pair<float, float> > positions;
+  quint32 generation = 0;
+};
+
+#endif // LITTLENAVMAP_AIAIRCRAFTINDEX_H
@@ -17,22 +17,36 @@
 
 #include "common/aircrafttrack.h"
 
+#include "common/constants.h"
+#include "common/trackjournal.h"
 #include "settings/settings.h"
 #include "atools.h"
 #include "geo/calculations.h"
 
 #include <QDataStream>
 #include <QDateTime>
-#include <QFile>
+#include <QDebug>
 
 AircraftTrack::AircraftTrack()
+  : levels(NUM_LEVELS - 1)
 {
+  maxTrackEntries = atools::settings::Settings::instance().getAndStoreValue(
+    lnm::OPTIONS_AIRCRAFT_TRACK_MAX_ENTRIES, 20000).toInt();
 
+  // Pruning removes whole chunks and keeps at least one
+  if(maxTrackEntries < MIN_TRACK_ENTRIES)
+  {
+    qWarning() << Q_FUNC_INFO << lnm::OPTIONS_AIRCRAFT_TRACK_MAX_ENTRIES << maxTrackEntries
+               << "is too small. Using" << MIN_TRACK_ENTRIES;
+    maxTrackEntries = MIN_TRACK_ENTRIES;
+  }
+  journal = new TrackJournal;
 }
 
 AircraftTrack::~AircraftTrack()
 {
-
+  // Writes pending positions
+  delete journal;
 }
 
 namespace at {
@@ -53,52 +67,57 @@ QDataStream& operator<<(QDataStream& dataStream, const at::AircraftTrackPos& tra
 
 void AircraftTrack::saveState()
 {
-  QFile trackFile(atools::settings::Settings::getConfigFilename(".track"));
+  // Everything else is already in the journal
+  journal->flush();
+}
 
-  if(trackFile.open(QIODevice::WriteOnly))
-  {
-    QDataStream out(&trackFile);
-    out.setVersion(QDataStream::Qt_5_5);
-    out.setFloatingPointPrecision(QDataStream::SinglePrecision);
+void AircraftTrack::restoreState()
+{
+  clearPositions();
 
-    out << FILE_MAGIC_NUMBER << FILE_VERSION << *this;
-    trackFile.close();
-  }
-  else
-    qWarning() << "Cannot write track" << trackFile.fileName() << ":" << trackFile.errorString();
+  // Verify the file format before reading the real track
+  if(atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_TRACK_JOURNAL_CHECK, false).toBool())
+    qInfo() << Q_FUNC_INFO << "Track journal format check" << (TrackJournal::checkFormat() ? "passed" : "failed");
+
+  QVector<at::AircraftTrackPos> positions;
+  journal->open(atools::settings::Settings::getConfigFilename(".track"), positions);
+
+  for(const at::AircraftTrackPos& trackPos : positions)
+    appendInternal(trackPos);
+
+  // Keep only the newest positions if capacity was reduced
+  while(numPositions > maxTrackEntries && chunks.size() > 1)
+    removeFirstChunk();
+
+  compactJournal();
 }
 
-void AircraftTrack::restoreState()
+void AircraftTrack::clearTrack()
 {
-  clear();
+  clearPositions();
+  journal->clear();
+}
 
-  QFile trackFile(atools::settings::Settings::getConfigFilename(".track"));
-  if(trackFile.exists())
-  {
-    if(trackFile.open(QIODevice::ReadOnly))
-    {
-      quint32 magic;
-      quint16 version;
-      QDataStream in(&trackFile);
-      in.setVersion(QDataStream::Qt_5_5);
-      in.setFloatingPointPrecision(QDataStream::SinglePrecision);
-      in >> magic;
-
-      if(magic == FILE_MAGIC_NUMBER)
-      {
-        in >> version;
-        if(version == FILE_VERSION)
-          in >> *this;
-        else
-          qWarning() << "Cannot read track" << trackFile.fileName() << ". Invalid version number:" << version;
-      }
-      else
-        qWarning() << "Cannot read track" << trackFile.fileName() << ". Invalid magic number:" << magic;
+void AircraftTrack::clearPositions()
+{
+  chunks.clear();
+  numPositions = 0;
+  maxAltitude = 0.f;
+  distanceMeter = 0.f;
+  boundingRect = atools::geo::Rect();
+  clearLevels();
+}
 
-      trackFile.close();
-    }
-    else
-      qWarning() << "Cannot read track" << trackFile.fileName() << ":" << trackFile.errorString();
+void AircraftTrack::compactJournal()
+{
+  // Journal keeps pruned positions - rewrite it once it is about twice as large as the track
+  if(journal->getNumPositions() > std::max(numPositions * 2, CHUNK_SIZE))
+  {
+    QVector<QVector<at::AircraftTrackPos> > positions;
+    positions.reserve(chunks.size());
+    for(const Chunk& chunk : chunks)
+      positions.append(chunk.positions);
+    journal->compact(positions);
   }
 }
 
@@ -110,7 +129,10 @@ bool AircraftTrack::appendTrackPos(const atools::geo::Pos& pos, const QDateTime&
   long timeDiff = onGround ? MIN_POSITION_TIME_DIFF_GROUND_MS : MIN_POSITION_TIME_DIFF_MS;
 
   if(isEmpty())
-    append({pos, timestamp.toTime_t(), onGround});
+  {
+    appendInternal({pos, timestamp.toTime_t(), onGround});
+    journal->append(last());
+  }
   else
   {
     long time = timestamp.toMSecsSinceEpoch();
@@ -120,28 +142,145 @@ bool AircraftTrack::appendTrackPos(const atools::geo::Pos& pos, const QDateTime&
     {
       if(pos.distanceMeterTo(last().pos) > atools::geo::nmToMeter(MAX_POINT_DISTANCE_NM))
       {
-        clear();
+        clearTrack();
         pruned = true;
       }
-      else
+      else if(numPositions >= maxTrackEntries && chunks.size() > 1)
       {
-        if(size() > MAX_TRACK_ENTRIES)
-        {
-          for(int i = 0; i < PRUNE_TRACK_ENTRIES; i++)
-            removeFirst();
-          pruned = true;
-        }
+        removeFirstChunk();
+        compactJournal();
+        pruned = true;
       }
-      append({pos, timestamp.toTime_t(), onGround});
+      appendInternal({pos, timestamp.toTime_t(), onGround});
+      journal->append(last());
     }
   }
   return pruned;
 }
 
-float AircraftTrack::getMaxAltitude() const
+void AircraftTrack::appendInternal(const at::AircraftTrackPos& trackPos)
+{
+  float dist = isEmpty() ? 0.f : last().pos.distanceMeterTo(trackPos.pos);
+
+  if(chunks.isEmpty() || chunks.last().positions.size() >= CHUNK_SIZE)
+  {
+    chunks.append(Chunk());
+    chunks.last().positions.reserve(CHUNK_SIZE);
+    chunks.last().linkDistanceMeter = dist;
+  }
+  else
+    chunks.last().distanceMeter += dist;
+
+  Chunk& chunk = chunks.last();
+  chunk.positions.append(trackPos);
+  numPositions++;
+
+  // Update aggregates of chunk and whole track
+  float alt = trackPos.pos.getAltitude();
+  if(chunk.positions.size() == 1)
+  {
+    chunk.maxAltitude = alt;
+    chunk.boundingRect = atools::geo::Rect(trackPos.pos);
+  }
+  else
+  {
+    chunk.maxAltitude = std::max(chunk.maxAltitude, alt);
+    chunk.boundingRect.extend(trackPos.pos);
+  }
+
+  if(numPositions == 1)
+  {
+    maxAltitude = alt;
+    boundingRect = atools::geo::Rect(trackPos.pos);
+  }
+  else
+  {
+    maxAltitude = std::max(maxAltitude, alt);
+    boundingRect.extend(trackPos.pos);
+  }
+  distanceMeter += dist;
+
+  appendToLevels(trackPos.pos, chunk);
+}
+
+void AircraftTrack::removeFirstChunk()
 {
-  float maxAlt = 0.f;
-  for(const at::AircraftTrackPos& trackPos : *this)
-    maxAlt = std::max(maxAlt, trackPos.pos.getAltitude());
-  return maxAlt;
+  const Chunk& first = chunks.first();
+
+  // Remove points this chunk contributed to the levels - these are always at the beginning
+  for(int i = 0; i < levels.size(); i++)
+  {
+    atools::geo::LineString& level = levels[i];
+    level.erase(level.begin(), level.begin() + std::min(first.levelCounts[i], level.size()));
+  }
+
+  numPositions -= first.positions.size();
+  chunks.removeFirst();
+
+  if(!chunks.isEmpty())
+    // First position is not connected to anything anymore
+    chunks.first().linkDistanceMeter = 0.f;
+
+  updateAggregates();
+  generation++;
+}
+
+void AircraftTrack::updateAggregates()
+{
+  // Combine values of all chunks instead of all positions
+  maxAltitude = 0.f;
+  distanceMeter = 0.f;
+  boundingRect = atools::geo::Rect();
+  for(int i = 0; i < chunks.size(); i++)
+  {
+    const Chunk& chunk = chunks.at(i);
+    if(i == 0)
+    {
+      maxAltitude = chunk.maxAltitude;
+      boundingRect = chunk.boundingRect;
+    }
+    else
+    {
+      maxAltitude = std::max(maxAltitude, chunk.maxAltitude);
+      boundingRect.extend(chunk.boundingRect);
+    }
+    distanceMeter += chunk.distanceMeter + chunk.linkDistanceMeter;
+  }
+}
+
+int AircraftTrack::getLevelForTolerance(float toleranceMeter) const
+{
+  int level = 0;
+  while(level < NUM_LEVELS - 1 && getLevelToleranceMeter(level + 1) <= toleranceMeter)
+    level++;
+  return level;
+}
+
+float AircraftTrack::getLevelToleranceMeter(int level)
+{
+  if(level == 0)
+    return 0.f;
+  else
+    return LEVEL_BASE_TOLERANCE_METER * (1 << (level - 1));
+}
+
+void AircraftTrack::clearLevels()
+{
+  for(atools::geo::LineString& level : levels)
+    level.clear();
+  generation++;
+}
+
+void AircraftTrack::appendToLevels(const atools::geo::Pos& pos, Chunk& chunk)
+{
+  // Add point to each level where it is far enough away from the last one
+  for(int i = 0; i < levels.size(); i++)
+  {
+    atools::geo::LineString& level = levels[i];
+    if(level.isEmpty() || level.last().distanceMeterTo(pos) >= getLevelToleranceMeter(i + 1))
+    {
+      level.append(pos);
+      chunk.levelCounts[i]++;
+    }
+  }
 }
@@ -19,6 +19,10 @@
 #define LITTLENAVMAP_AIRCRAFTTRACK_H
 
 #include "geo/pos.h"
+#include "geo/linestring.h"
+#include "geo/rect.h"
+
+#include <QVector>
 
 namespace at {
 /* Track position. Can be converted to QVariant and thus be saved to settings */
@@ -37,24 +41,38 @@ QDataStream& operator<<(QDataStream& dataStream, const at::AircraftTrackPos& obj
 Q_DECLARE_TYPEINFO(at::AircraftTrackPos, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(at::AircraftTrackPos);
 
+class TrackJournal;
+
 /*
- * Stores the track of the flight simulator aircraft
+ * Stores the track of the flight simulator aircraft.
+ *
+ * Positions are kept in a ring of fixed size chunks. Appending is constant time and pruning drops the
+ * oldest chunk once the configurable capacity is exceeded. Chunks provide contiguous read access.
+ * Maximum altitude, bounding rectangle and total distance are updated when adding or pruning.
+ *
+ * New positions are written to a journal file as they arrive so that a crash does not lose the flight.
+ *
+ * Additionally keeps a pyramid of simplified line strings which is updated when adding positions.
+ * Level 0 contains all positions and is read from the chunks. Each further level drops points closer than a
+ * tolerance doubling with each level. Painters can pick a level matching the zoom distance so that long tracks do not
+ * cost more than short ones.
  */
-class AircraftTrack :
-  private QList<at::AircraftTrackPos>
+class AircraftTrack
 {
+  /* Owns the journal */
+  Q_DISABLE_COPY(AircraftTrack)
+
 public:
   AircraftTrack();
   ~AircraftTrack();
 
-  /* Saves and restores track into a separate file (little_navmap.track) */
+  /* Track is written continuously into a journal file (little_navmap.track).
+   * Saving writes only pending positions and restoring reads the journal. */
   void saveState();
   void restoreState();
 
-  void clearTrack()
-  {
-    clear();
-  }
+  /* Remove all positions from memory and journal */
+  void clearTrack();
 
   /*
    * Add a track position. Accurracy depends on the ground flag which will cause more
@@ -63,22 +81,193 @@ public:
    */
   bool appendTrackPos(const atools::geo::Pos& pos, const QDateTime& timestamp, bool onGround);
 
-  float getMaxAltitude() const;
+  float getMaxAltitude() const
+  {
+    return maxAltitude;
+  }
+
+  const atools::geo::Rect& getBoundingRect() const
+  {
+    return boundingRect;
+  }
+
+  /* Sum of distances between all positions */
+  float getDistanceMeter() const
+  {
+    return distanceMeter;
+  }
+
+  /* Number of simplification levels */
+  static Q_DECL_CONSTEXPR int NUM_LEVELS = 14;
+
+  /* Number of points in a simplification level. Level 0 contains all positions. */
+  int getLevelSize(int level) const
+  {
+    return level == 0 ? numPositions : levels.at(level - 1).size();
+  }
+
+  /* Point of the simplified track for level where consecutive points are at least getLevelToleranceMeter apart.
+   * The last track position is not always contained in levels above 0. */
+  const atools::geo::Pos& getLevelPos(int level, int index) const
+  {
+    return level == 0 ? at(index).pos : levels.at(level - 1).at(index);
+  }
+
+  /* Coarsest level having a tolerance not larger than the given value */
+  int getLevelForTolerance(float toleranceMeter) const;
+
+  /* Minimum distance between points in a level. 0 for level 0. */
+  static float getLevelToleranceMeter(int level);
+
+  /* Changes whenever positions are removed. Levels are only appended to otherwise. */
+  quint32 getGeneration() const
+  {
+    return generation;
+  }
+
+  bool isEmpty() const
+  {
+    return numPositions == 0;
+  }
+
+  int size() const
+  {
+    return numPositions;
+  }
+
+  const at::AircraftTrackPos& at(int index) const
+  {
+    return chunks.at(index / CHUNK_SIZE).positions.at(index % CHUNK_SIZE);
+  }
+
+  const at::AircraftTrackPos& first() const
+  {
+    return chunks.first().positions.first();
+  }
+
+  const at::AircraftTrackPos& last() const
+  {
+    return chunks.last().positions.last();
+  }
+
+  /* Contiguous blocks of positions in chronological order. All but the last one contain CHUNK_SIZE entries. */
+  int getNumChunks() const
+  {
+    return chunks.size();
+  }
+
+  const QVector<at::AircraftTrackPos>& getChunk(int index) const
+  {
+    return chunks.at(index).positions;
+  }
+
+  /* Forward iterator for range based loops */
+  class const_iterator
+  {
+  public:
+    const_iterator(const AircraftTrack *trackParam, int indexParam)
+      : track(trackParam), index(indexParam)
+    {
+    }
+
+    const at::AircraftTrackPos& operator*() const
+    {
+      return track->at(index);
+    }
+
+    const at::AircraftTrackPos *operator->() const
+    {
+      return &track->at(index);
+    }
+
+    const_iterator& operator++()
+    {
+      index++;
+      return *this;
+    }
+
+    bool operator==(const const_iterator& other) const
+    {
+      return index == other.index;
+    }
+
+    bool operator!=(const const_iterator& other) const
+    {
+      return index != other.index;
+    }
+
+  private:
+    const AircraftTrack *track;
+    int index;
+  };
+
+  const_iterator begin() const
+  {
+    return const_iterator(this, 0);
+  }
 
-  /* Pull only needed methods into public space */
-  using QList::isEmpty;
-  using QList::first;
-  using QList::last;
-  using QList::size;
-  using QList::at;
-  using QList::begin;
-  using QList::end;
+  const_iterator end() const
+  {
+    return const_iterator(this, numPositions);
+  }
+
+  /* Number of positions in each chunk and also the number of positions removed at once when pruning */
+  static Q_DECL_CONSTEXPR int CHUNK_SIZE = 1024;
+
+  /* Smaller values of the maximum number of track points are raised to this */
+  static Q_DECL_CONSTEXPR int MIN_TRACK_ENTRIES = CHUNK_SIZE * 2;
 
 private:
-  /* Maximum number of track points. If exceeded entries will be removed from beginning of the list */
-  static Q_DECL_CONSTEXPR int MAX_TRACK_ENTRIES = 20000;
-  /* Number of entries to remove at once */
-  static Q_DECL_CONSTEXPR int PRUNE_TRACK_ENTRIES = 200;
+  struct Chunk
+  {
+    QVector<at::AircraftTrackPos> positions;
+    float maxAltitude = 0.f;
+    atools::geo::Rect boundingRect;
+    /* Distance between positions within this chunk */
+    float distanceMeter = 0.f;
+    /* Distance from the last position of the previous chunk to the first of this one */
+    float linkDistanceMeter = 0.f;
+    /* Number of points this chunk added to each simplification level starting with level 1 */
+    int levelCounts[NUM_LEVELS - 1] = {};
+  };
+
+  /* Clear positions and levels but not the journal */
+  void clearPositions();
+
+  /* Rewrite journal in background if it contains too many removed positions. Passes the implicitly shared
+   * chunks to avoid copying the track. */
+  void compactJournal();
+
+  /* Append without checking distance or time and update aggregates and levels */
+  void appendInternal(const at::AircraftTrackPos& trackPos);
+
+  /* Remove the oldest chunk including its points in all levels */
+  void removeFirstChunk();
+  void updateAggregates();
+
+  void clearLevels();
+
+  /* Add point to all levels above 0 where it is far enough from the previous point and count the points in chunk */
+  void appendToLevels(const atools::geo::Pos& pos, Chunk& chunk);
+
+  /* Point distance in level 1 - doubled for each following level */
+  static Q_DECL_CONSTEXPR float LEVEL_BASE_TOLERANCE_METER = 25.f;
+
+  QList<Chunk> chunks;
+  int numPositions = 0;
+
+  float maxAltitude = 0.f, distanceMeter = 0.f;
+  atools::geo::Rect boundingRect;
+
+  /* Simplification levels 1 to NUM_LEVELS - 1. Level 0 is not stored separately. */
+  QVector<atools::geo::LineString> levels;
+  quint32 generation = 0;
+
+  TrackJournal *journal = nullptr;
+
+  /* Maximum number of track points. If exceeded the oldest chunk of CHUNK_SIZE points will be removed, so the track
+   * shrinks by 1024 points at once. Configurable in settings and at least MIN_TRACK_ENTRIES. */
+  int maxTrackEntries = 20000;
 
   /* Minimum time difference between recordings */
   static Q_DECL_CONSTEXPR int MIN_POSITION_TIME_DIFF_MS = 1000;
@@ -86,11 +275,6 @@ private:
 
   /* Clear track if aircraft jumps too far */
   static Q_DECL_CONSTEXPR int MAX_POINT_DISTANCE_NM = 1000;
-
-  static Q_DECL_CONSTEXPR quint32 FILE_MAGIC_NUMBER = 0x5B6C1A2B;
-
-  /* Version 2 to adds timstamp and single floating point precision */
-  static Q_DECL_CONSTEXPR quint16 FILE_VERSION = 2;
 };
 
 #endif // LITTLENAVMAP_AIRCRAFTTRACK_H
@@ -119,6 +119,8 @@ const QString SEARCHTAB_NAV_VIEW_DIST_WIDGET = "SearchPaneNav/WidgetDistView";
 const QString SETTINGS_INFOQUERY = "Settings/InfoQuery";
 const QString SETTINGS_MAPQUERY = "Settings/MapQuery";
 const QString SETTINGS_DATABASE = "Settings/Database";
+const QString SETTINGS_CACHE = "Settings/Cache";
+const QString SETTINGS_MAPPAINTLAYER = "Settings/MapPaintLayer";
 
 const QString APPROACHTREE_WIDGET = "ApproachTree/Widget";
 const QString APPROACHTREE_SELECTED_WIDGET = "ApproachTree/WidgetSelected";
@@ -145,7 +147,14 @@ const QString OPTIONS_DIALOG_WARN_STYLE = "OptionsDialog/StyleWarning";
 const QString OPTIONS_LANGUAGE = "Options/Language";
 const QString OPTIONS_MARBLE_DEBUG = "Options/MarbleDebug";
 const QString OPTIONS_CONNECTCLIENT_DEBUG = "Options/ConnectClientDebug";
+const QString OPTIONS_CONNECTCLIENT_DELTA_FORMAT = "Options/ConnectClientDeltaFormat";
 const QString OPTIONS_DATAREADER_DEBUG = "Options/DataReaderDebug";
+const QString OPTIONS_TRAFFIC_GENERATOR_UPDATE_MS = "Options/TrafficGeneratorUpdateMs";
+const QString OPTIONS_SIM_EXTRAPOLATION_MS = "Options/SimExtrapolationUpdateMs";
+const QString OPTIONS_SIM_DATA_CODEC_CHECK = "Options/SimDataCodecCheck";
+const QString OPTIONS_TRACK_JOURNAL_CHECK = "Options/TrackJournalCheck";
+/* Maximum number of track points. Minimum is 2048. The oldest 1024 points are dropped at once if exceeded. */
+const QString OPTIONS_AIRCRAFT_TRACK_MAX_ENTRIES = "Options/AircraftTrackMaxEntries";
 const QString OPTIONS_VERSION = "Options/Version";
 
 /* File dialog patterns */
@@ -20,8 +20,11 @@
 #include "atools.h"
 #include "geo/pos.h"
 #include "geo/line.h"
+#include "geo/linestring.h"
+#include "geo/calculations.h"
 
 #include <marble/ViewportParams.h>
+#include <marble/Quaternion.h>
 
 #include <QLineF>
 
@@ -30,6 +33,9 @@ using namespace atools::geo;
 
 const QSize CoordinateConverter::DEFAULT_WTOS_SIZE(100, 100);
 
+/* Latitude limit of the Mercator projection (85.05 degree) */
+static const double MERCATOR_MAX_LAT_RAD = std::atan(std::sinh(M_PI));
+
 CoordinateConverter::CoordinateConverter(const ViewportParams *viewportParams)
   : viewport(viewportParams)
 {
@@ -189,6 +195,120 @@ QPoint CoordinateConverter::wToS(const Marble::GeoDataCoordinates& coords, const
   }
 }
 
+/* Normalize a longitude difference in radians to -PI to PI */
+static inline double wrapLonRad(double dLon)
+{
+  if(dLon > M_PI)
+    return dLon - 2. * M_PI;
+  else if(dLon < -M_PI)
+    return dLon + 2. * M_PI;
+  else
+    return dLon;
+}
+
+int CoordinateConverter::wToS(const atools::geo::LineString& coords, QPolygonF& points, QVector<bool> *visible,
+                              const QSize& size, QVector<bool> *hidden) const
+{
+  int num = coords.size();
+  points.resize(num);
+  if(visible != nullptr)
+    visible->resize(num);
+  if(hidden != nullptr)
+    hidden->resize(num);
+
+  Marble::Projection projection = viewport->projection();
+  if(projection != Marble::Spherical && projection != Marble::Mercator)
+  {
+    // Fall back to Marble for each point
+    int numHidden = 0;
+    for(int i = 0; i < num; i++)
+    {
+      bool isHidden;
+      double x, y;
+      bool vis = wToS(coords.at(i), x, y, size, &isHidden);
+      points[i] = QPointF(x, y);
+      if(visible != nullptr)
+        (*visible)[i] = vis;
+      if(hidden != nullptr)
+        (*hidden)[i] = isHidden;
+      if(isHidden)
+        numHidden++;
+    }
+    return numHidden;
+  }
+
+  // Structure of arrays for the calculation loops
+  QVector<double> lon(num), lat(num), xs(num), ys(num);
+  QVector<char> hiddenFlags(num, 0);
+  for(int i = 0; i < num; i++)
+  {
+    lon[i] = atools::geo::toRadians(static_cast<double>(coords.at(i).getLonX()));
+    lat[i] = atools::geo::toRadians(static_cast<double>(coords.at(i).getLatY()));
+  }
+
+  const double width = viewport->width(), height = viewport->height();
+  const double radius = viewport->radius();
+  const double centerX = width / 2., centerY = height / 2.;
+
+  if(projection == Marble::Spherical)
+  {
+    // Orthographic projection - rotate unit vectors by planet axis like Marble does
+    const Marble::matrix& m = viewport->planetAxisMatrix();
+    for(int i = 0; i < num; i++)
+    {
+      double cosLat = std::cos(lat[i]);
+      double vx = cosLat * std::sin(lon[i]), vy = std::sin(lat[i]), vz = cosLat * std::cos(lon[i]);
+
+      double rx = m[0][0] * vx + m[1][0] * vy + m[2][0] * vz;
+      double ry = m[0][1] * vx + m[1][1] * vy + m[2][1] * vz;
+      double rz = m[0][2] * vx + m[1][2] * vy + m[2][2] * vz;
+
+      xs[i] = centerX + radius * rx;
+      ys[i] = centerY - radius * ry;
+      hiddenFlags[i] = rz < 0.;
+    }
+  }
+  else
+  {
+    // Mercator projection - repeating horizontally every 4 * radius pixels
+    const double rad2Pixel = 2. * radius / M_PI;
+    const double centerLon = viewport->centerLongitude();
+    const double centerLatInv = std::atanh(std::sin(viewport->centerLatitude()));
+    // Use the repetition of the first position closest to the center and place all other positions relative to
+    // it. This keeps line strings crossing the anti-meridian in one piece.
+    const double firstLon = num > 0 ? lon[0] : 0.;
+    const double firstDLon = wrapLonRad(firstLon - centerLon);
+    for(int i = 0; i < num; i++)
+    {
+      double dLon = firstDLon + wrapLonRad(lon[i] - firstLon);
+
+      double la = std::max(-MERCATOR_MAX_LAT_RAD, std::min(MERCATOR_MAX_LAT_RAD, lat[i]));
+      xs[i] = centerX + dLon * rad2Pixel;
+      ys[i] = centerY - (std::atanh(std::sin(la)) - centerLatInv) * rad2Pixel;
+    }
+  }
+
+  // Visibility check including object size
+  const double halfWidth = size.width() / 2., halfHeight = size.height() / 2.;
+  int numHidden = 0;
+  for(int i = 0; i < num; i++)
+  {
+    points[i] = QPointF(xs[i], ys[i]);
+
+    if(hiddenFlags[i])
+      numHidden++;
+
+    if(hidden != nullptr)
+      (*hidden)[i] = hiddenFlags[i];
+
+    if(visible != nullptr)
+      (*visible)[i] = !hiddenFlags[i] &&
+                      xs[i] + halfWidth >= 0. && xs[i] < width + halfWidth &&
+                      ys[i] + halfHeight >= 0. && ys[i] < height + halfHeight;
+  }
+  return numHidden;
+}
+
 bool CoordinateConverter::sToW(int x, int y, Marble::GeoDataCoordinates& coords) const
 {
   qreal lon, lat;
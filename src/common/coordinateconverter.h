@@ -21,7 +21,9 @@
 #include <marble/GeoDataCoordinates.h>
 
 #include <QPoint>
+#include <QPolygonF>
 #include <QSize>
+#include <QVector>
 
 namespace Marble {
 class ViewportParams;
@@ -31,6 +33,7 @@ namespace atools {
 namespace geo {
 class Pos;
 class Line;
+class LineString;
 }
 }
 
@@ -103,6 +106,23 @@ public:
   bool wToS(const atools::geo::Line& coords, QLineF& line, const QSize& size = DEFAULT_WTOS_SIZE,
             bool *isHidden = nullptr) const;
 
+  /*
+   * Convert all positions of a line string to screen coordinates at once. Calculates the spherical and Mercator
+   * projections directly in tight loops instead of going through the viewport for each point.
+   * Other projections fall back to wToS.
+   * Spherical gives the same result as calling wToS for each position. Mercator uses the repetition of the first
+   * position closest to the center of the screen and places all following positions within half a world width
+   * of it. Line strings crossing the anti-meridian are therefore not split like they are by single wToS calls.
+   * @param coords world coordinates
+   * @param points screen coordinates for all positions. Values for hidden positions are undefined.
+   * @param visible if not null receives true for each position that is visible and not hidden
+   * @param size estimated screen size for visibility check
+   * @param hidden if not null receives true for each position that is hidden behind the globe
+   * @return number of positions hidden behind the globe
+   */
+  int wToS(const atools::geo::LineString& coords, QPolygonF& points, QVector<bool> *visible = nullptr,
+           const QSize& size = DEFAULT_WTOS_SIZE, QVector<bool> *hidden = nullptr) const;
+
   bool sToW(int x, int y, Marble::GeoDataCoordinates& coords) const;
 
   /* Converte screen to world coordinates */
@@ -111,6 +131,17 @@ public:
   atools::geo::Pos sToW(const QPoint& point) const;
   atools::geo::Pos sToW(const QPointF& point) const;
 
+  const Marble::ViewportParams *getViewport() const
+  {
+    return viewport;
+  }
+
+  /* Use a different viewport for all following conversions */
+  void setViewport(const Marble::ViewportParams *viewportParams)
+  {
+    viewport = viewportParams;
+  }
+
   /* Shortcuts for more readable code */
   static Q_DECL_CONSTEXPR Marble::GeoDataCoordinates::Unit DEG = Marble::GeoDataCoordinates::Degree;
   static Q_DECL_CONSTEXPR Marble::GeoDataCoordinates::BearingType INITBRG =
@@ -0,0 +1,61 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "common/geometrybatch.h"
+
+#include <QPainter>
+
+void GeometryBatch::flush(QPainter *painter)
+{
+  for(const Run& run : runs)
+  {
+    painter->setPen(run.pen);
+    if(run.polygon)
+    {
+      painter->setBrush(run.brush);
+      for(const QPolygonF& polygon : run.polygons)
+        painter->drawPolygon(polygon);
+    }
+    else
+    {
+      painter->setBrush(Qt::NoBrush);
+      painter->drawLines(run.lines);
+    }
+  }
+
+  clear();
+}
+
+void GeometryBatch::clear()
+{
+  runs.clear();
+}
+
+QVector<QLineF>& GeometryBatch::lineRun(const QPen& pen)
+{
+  if(runs.isEmpty() || runs.last().polygon || runs.last().pen != pen)
+    runs.append({false, pen, QBrush(), QVector<QLineF>(), QVector<QPolygonF>()});
+  return runs.last().lines;
+}
+
+QVector<QPolygonF>& GeometryBatch::polygonRun(const QPen& pen, const QBrush& brush)
+{
+  if(runs.isEmpty() || !runs.last().polygon || runs.last().pen != pen || runs.last().brush != brush)
+    runs.append({true, pen, brush, QVector<QLineF>(), QVector<QPolygonF>()});
+  return runs.last().polygons;
+}
@@ -0,0 +1,83 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_GEOMETRYBATCH_H
+#define LITTLENAVMAP_GEOMETRYBATCH_H
+
+#include <QBrush>
+#include <QLineF>
+#include <QPen>
+#include <QPolygonF>
+#include <QVector>
+
+class QPainter;
+
+/*
+ * Collects screen coordinate lines and polygons during a painter pass and draws consecutive elements
+ * sharing the same pen and brush with as few calls as possible. This avoids switching painter state for
+ * each segment.
+ *
+ * Elements are drawn in the order they were added. Only consecutive elements are merged into one run,
+ * so overlapping geometry keeps its z-order.
+ */
+class GeometryBatch
+{
+public:
+  void addLine(const QPen& pen, const QLineF& line)
+  {
+    lineRun(pen).append(line);
+  }
+
+  void addLine(const QPen& pen, const QPointF& p1, const QPointF& p2)
+  {
+    lineRun(pen).append(QLineF(p1, p2));
+  }
+
+  void addPolygon(const QPen& pen, const QBrush& brush, const QPolygonF& polygon)
+  {
+    polygonRun(pen, brush).append(polygon);
+  }
+
+  /* Draw all collected geometry and clear the batch. Pen and brush of the painter are changed. */
+  void flush(QPainter *painter);
+
+  void clear();
+
+  bool isEmpty() const
+  {
+    return runs.isEmpty();
+  }
+
+private:
+  /* Consecutive lines or polygons having the same pen and brush */
+  struct Run
+  {
+    bool polygon;
+    QPen pen;
+    QBrush brush;
+    QVector<QLineF> lines;
+    QVector<QPolygonF> polygons;
+  };
+
+  QVector<QLineF>& lineRun(const QPen& pen);
+  QVector<QPolygonF>& polygonRun(const QPen& pen, const QBrush& brush);
+
+  QVector<Run> runs;
+};
+
+#endif // LITTLENAVMAP_GEOMETRYBATCH_H
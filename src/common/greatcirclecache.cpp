@@ -0,0 +1,107 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "common/greatcirclecache.h"
+
+#include "geo/calculations.h"
+
+using atools::geo::LineString;
+using atools::geo::Pos;
+
+uint qHash(const GreatCircleCache::Key& key)
+{
+  return qHash(key.lonX1) ^ (qHash(key.latY1) << 1) ^ (qHash(key.lonX2) << 2) ^ (qHash(key.latY2) << 3);
+}
+
+GreatCircleCache::GreatCircleCache()
+{
+  lines.setMaxCost(MAX_POINTS);
+}
+
+GreatCircleCache& GreatCircleCache::instance()
+{
+  static GreatCircleCache cache;
+  return cache;
+}
+
+const QVector<LineString>& GreatCircleCache::getLine(const Pos& pos1, const Pos& pos2)
+{
+  Key key = {pos1.getLonX(), pos1.getLatY(), pos2.getLonX(), pos2.getLatY()};
+
+  QVector<LineString> *line = lines.object(key);
+  if(line == nullptr)
+  {
+    line = new QVector<LineString>(createLine(pos1, pos2));
+
+    int numPoints = 0;
+    for(const LineString& part : *line)
+      numPoints += part.size();
+
+    if(!lines.insert(key, line, numPoints))
+    {
+      // Too large for the cache - object was deleted
+      tempLine = createLine(pos1, pos2);
+      return tempLine;
+    }
+  }
+  return *line;
+}
+
+void GreatCircleCache::clear()
+{
+  lines.clear();
+}
+
+QVector<LineString> GreatCircleCache::createLine(const Pos& pos1, const Pos& pos2)
+{
+  QVector<LineString> line;
+  if(!pos1.isValid() || !pos2.isValid())
+    return line;
+
+  float distanceMeter = pos1.distanceMeterTo(pos2);
+  int numSegments = std::max(1, static_cast<int>(std::ceil(distanceMeter /
+                                                           atools::geo::nmToMeter(SEGMENT_LENGTH_NM))));
+
+  LineString part;
+  part.append(pos1);
+  for(int i = 1; i <= numSegments; i++)
+  {
+    Pos pos = i == numSegments ? pos2 : pos1.interpolate(pos2, distanceMeter, static_cast<float>(i) / numSegments);
+    const Pos& last = part.last();
+
+    float lonDiff = pos.getLonX() - last.getLonX();
+    if(std::abs(lonDiff) > 180.f)
+    {
+      // Crossing the anti-meridian - calculate latitude at the crossing and start a new part
+      float lastLon = last.getLonX() < 0.f ? last.getLonX() + 360.f : last.getLonX();
+      float lon = pos.getLonX() < 0.f ? pos.getLonX() + 360.f : pos.getLonX();
+      float fraction = std::abs(lon - lastLon) > 0.f ? (180.f - lastLon) / (lon - lastLon) : 0.f;
+      float lat = last.getLatY() + (pos.getLatY() - last.getLatY()) * fraction;
+
+      float sign = last.getLonX() < 0.f ? -1.f : 1.f;
+      part.append(Pos(180.f * sign, lat));
+      line.append(part);
+
+      part.clear();
+      part.append(Pos(-180.f * sign, lat));
+    }
+    part.append(pos);
+  }
+  line.append(part);
+  return line;
+}
@@ -0,0 +1,79 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_GREATCIRCLECACHE_H
+#define LITTLENAVMAP_GREATCIRCLECACHE_H
+
+#include "geo/linestring.h"
+
+#include <QCache>
+#include <QVector>
+
+/*
+ * Global cache of densified great circle lines for route legs and airway segments.
+ *
+ * A line is split into points not farther apart than SEGMENT_LENGTH_NM so that it can be drawn as a polyline
+ * in screen coordinates. Lines crossing the anti-meridian are split into two parts ending at +/-180 degree.
+ * Entries are keyed by the line endpoints, so changed routes or airways simply do not hit old entries
+ * which are dropped once the cache is full.
+ *
+ * Not thread safe. Use from the GUI thread only.
+ */
+class GreatCircleCache
+{
+public:
+  static GreatCircleCache& instance();
+
+  /* Get the densified line from pos1 to pos2 split at the anti-meridian.
+   * The reference is valid until the next call. */
+  const QVector<atools::geo::LineString>& getLine(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2);
+
+  void clear();
+
+private:
+  struct Key
+  {
+    bool operator==(const Key& other) const
+    {
+      return lonX1 == other.lonX1 && latY1 == other.latY1 && lonX2 == other.lonX2 && latY2 == other.latY2;
+    }
+
+    float lonX1, latY1, lonX2, latY2;
+  };
+
+  friend uint qHash(const GreatCircleCache::Key& key);
+
+  GreatCircleCache();
+
+  /* Densify and split line */
+  static QVector<atools::geo::LineString> createLine(const atools::geo::Pos& pos1, const atools::geo::Pos& pos2);
+
+  /* Maximum distance between points of a densified line */
+  static Q_DECL_CONSTEXPR float SEGMENT_LENGTH_NM = 20.f;
+
+  /* Maximum number of cached points */
+  static Q_DECL_CONSTEXPR int MAX_POINTS = 500000;
+
+  /* Cost is number of points */
+  QCache<Key, QVector<atools::geo::LineString> > lines;
+
+  /* Returned for invalid or uncacheable lines */
+  QVector<atools::geo::LineString> tempLine;
+};
+
+#endif // LITTLENAVMAP_GREATCIRCLECACHE_H
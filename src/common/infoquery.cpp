@@ -26,24 +26,15 @@ using atools::sql::SqlDatabase;
 using atools::sql::SqlRecord;
 using atools::sql::SqlRecordVector;
 
+/* Approximate memory used by a record. Assumes short strings or numbers in all fields. */
+static qint64 recordBytes(const SqlRecord& record)
+{
+  return static_cast<qint64>(sizeof(SqlRecord)) + record.count() * 48;
+}
+
 InfoQuery::InfoQuery(SqlDatabase *sqlDb)
   : db(sqlDb)
 {
-  atools::settings::Settings& settings = atools::settings::Settings::instance();
-  airportCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "AirportCache", 100).toInt());
-  vorCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "VorCache", 100).toInt());
-  ndbCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "NdbCache", 100).toInt());
-  waypointCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "WaypointCache", 100).toInt());
-  airwayCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "AirwayCache", 100).toInt());
-  runwayEndCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "RunwayEndCache", 100).toInt());
-  ilsCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "IlsCache", 100).toInt());
-  comCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "ComCache", 100).toInt());
-  runwayCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "RunwayCache", 100).toInt());
-  helipadCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "HelipadCache", 100).toInt());
-  startCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "StartCache", 100).toInt());
-  approachCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "ApproachCache", 100).toInt());
-  transitionCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "TransitionCache", 100).toInt());
-  airportSceneryCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_INFOQUERY + "AirportSceneryCache", 100).toInt());
 }
 
 InfoQuery::~InfoQuery()
@@ -147,7 +138,7 @@ atools::sql::SqlRecordVector InfoQuery::getAirwayWaypointInformation(const QStri
 
 /* Get a record from the cache of get it from a database query */
 template<typename ID>
-const SqlRecord *InfoQuery::cachedRecord(QCache<ID, SqlRecord>& cache, SqlQuery *query, ID id)
+const SqlRecord *InfoQuery::cachedRecord(memcache::MemoryCache<ID, SqlRecord>& cache, SqlQuery *query, ID id)
 {
   SqlRecord *rec = cache.object(id);
   if(rec != nullptr)
@@ -167,11 +158,11 @@ const SqlRecord *InfoQuery::cachedRecord(QCache<ID, SqlRecord>& cache, SqlQuery
     {
       // Insert it into the cache
       rec = new SqlRecord(query->record());
-      cache.insert(id, rec);
+      cache.insert(id, rec, recordBytes(*rec));
     }
     else
       // Add empty record to indicate nothing found for this id
-      cache.insert(id, new SqlRecord());
+      cache.insert(id, new SqlRecord(), static_cast<qint64>(sizeof(SqlRecord)));
   }
   query->finish();
   return rec;
@@ -179,7 +170,7 @@ const SqlRecord *InfoQuery::cachedRecord(QCache<ID, SqlRecord>& cache, SqlQuery
 
 /* Get a record vector from the cache of get it from a database query */
 template<typename ID>
-const SqlRecordVector *InfoQuery::cachedRecordVector(QCache<ID, SqlRecordVector>& cache,
+const SqlRecordVector *InfoQuery::cachedRecordVector(memcache::MemoryCache<ID, SqlRecordVector>& cache,
                                                      SqlQuery *query, ID id)
 {
   SqlRecordVector *rec = cache.object(id);
@@ -203,7 +194,10 @@ const SqlRecordVector *InfoQuery::cachedRecordVector(QCache<ID, SqlRecordVector>
       rec->append(query->record());
 
     // Insert it into the cache
-    cache.insert(id, rec);
+    qint64 bytes = static_cast<qint64>(sizeof(SqlRecordVector));
+    for(const SqlRecord& r : *rec)
+      bytes += recordBytes(r);
+    cache.insert(id, rec, bytes);
 
     if(rec->isEmpty())
       return nullptr;
@@ -18,7 +18,8 @@
 #ifndef LITTLENAVMAP_INFOQUERY_H
 #define LITTLENAVMAP_INFOQUERY_H
 
-#include <QCache>
+#include "common/memorycache.h"
+
 #include <QObject>
 
 namespace atools {
@@ -89,26 +90,29 @@ public:
 
 private:
   template<typename ID>
-  static const atools::sql::SqlRecord *cachedRecord(QCache<ID,
-                                                           atools::sql::SqlRecord>& cache,
+  static const atools::sql::SqlRecord *cachedRecord(memcache::MemoryCache<ID, atools::sql::SqlRecord>& cache,
                                                     atools::sql::SqlQuery *query,
                                                     ID id);
 
   template<typename ID>
-  static const atools::sql::SqlRecordVector *cachedRecordVector(QCache<ID,
-                                                                       atools::sql::SqlRecordVector>& cache,
+  static const atools::sql::SqlRecordVector *cachedRecordVector(memcache::MemoryCache<ID,
+                                                                                      atools::sql::SqlRecordVector>& cache,
                                                                 atools::sql::SqlQuery *query,
                                                                 ID id);
 
   /* Caches */
-  QCache<int, atools::sql::SqlRecord> airportCache,
-                                      vorCache, ndbCache, waypointCache, airwayCache, runwayEndCache,
-                                      ilsCache;
-
-  QCache<int, atools::sql::SqlRecordVector> comCache, runwayCache, helipadCache, startCache, approachCache,
-                                            transitionCache;
-
-  QCache<QString, atools::sql::SqlRecordVector> airportSceneryCache;
+  memcache::MemoryCache<int, atools::sql::SqlRecord> airportCache{"InfoQuery Airport"}, vorCache{"InfoQuery VOR"},
+                                                     ndbCache{"InfoQuery NDB"}, waypointCache{"InfoQuery Waypoint"},
+                                                     airwayCache{"InfoQuery Airway"},
+                                                     runwayEndCache{"InfoQuery Runway End"}, ilsCache{"InfoQuery ILS"};
+
+  memcache::MemoryCache<int, atools::sql::SqlRecordVector> comCache{"InfoQuery COM"}, runwayCache{"InfoQuery Runway"},
+                                                           helipadCache{"InfoQuery Helipad"},
+                                                           startCache{"InfoQuery Start"},
+                                                           approachCache{"InfoQuery Approach"},
+                                                           transitionCache{"InfoQuery Transition"};
+
+  memcache::MemoryCache<QString, atools::sql::SqlRecordVector> airportSceneryCache{"InfoQuery Airport Scenery"};
 
   atools::sql::SqlDatabase *db;
 
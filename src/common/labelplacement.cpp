@@ -0,0 +1,126 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "common/labelplacement.h"
+
+#include <QFontMetricsF>
+#include <QStringList>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+LabelPlacement::LabelPlacement()
+{
+}
+
+void LabelPlacement::clear()
+{
+  // Keep allocated vectors in cells for the next frame
+  for(QVector<int>& cell : cells)
+    cell.clear();
+  rects.clear();
+  priorities.clear();
+  candidates.clear();
+  numHidden = 0;
+}
+
+bool LabelPlacement::place(const QRectF& rect, int priority)
+{
+  int left = qFloor(rect.left() / CELL_SIZE), right = qFloor(rect.right() / CELL_SIZE);
+  int top = qFloor(rect.top() / CELL_SIZE), bottom = qFloor(rect.bottom() / CELL_SIZE);
+
+  if(priority < PRIORITY_ROUTE)
+  {
+    for(int cy = top; cy <= bottom; cy++)
+    {
+      for(int cx = left; cx <= right; cx++)
+      {
+        auto it = cells.constFind(cellKey(cx, cy));
+        if(it != cells.constEnd())
+        {
+          for(int index : it.value())
+          {
+            if(priorities.at(index) >= priority && rects.at(index).intersects(rect))
+            {
+              numHidden++;
+              return false;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  int index = rects.size();
+  rects.append(rect);
+  priorities.append(priority);
+  for(int cy = top; cy <= bottom; cy++)
+  {
+    for(int cx = left; cx <= right; cx++)
+      cells[cellKey(cx, cy)].append(index);
+  }
+  return true;
+}
+
+void LabelPlacement::submit(const QRectF& rect, int priority, const std::function<void(QPainter *painter)>& draw)
+{
+  candidates.append({rect, priority, draw});
+}
+
+void LabelPlacement::resolve(QPainter *painter)
+{
+  std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& c1, const Candidate& c2) -> bool
+                   {
+                     return c1.priority > c2.priority;
+                   });
+
+  for(const Candidate& candidate : candidates)
+  {
+    if(place(candidate.rect, candidate.priority))
+      candidate.draw(painter);
+  }
+  candidates.clear();
+}
+
+QRectF LabelPlacement::estimateTextRect(const QFontMetricsF& metrics, const QStringList& texts, float x,
+                                        float y, bool alignRight, bool alignCenter)
+{
+  int maxLength = 0;
+  for(const QString& text : texts)
+    maxLength = std::max(maxLength, text.length());
+
+  qreal width = maxLength * metrics.averageCharWidth();
+  qreal height = texts.size() * (metrics.height() - 1.);
+
+  qreal left = x;
+  if(alignRight)
+    left -= width;
+  else if(alignCenter)
+    left -= width / 2.;
+
+  return QRectF(left, y - height / 2., width, height);
+}
+
+QRectF LabelPlacement::rotatedRect(const QPointF& center, float width, float height, float rotateDeg)
+{
+  qreal angle = qDegreesToRadians(static_cast<qreal>(rotateDeg));
+  qreal w = std::abs(width * std::cos(angle)) + std::abs(height * std::sin(angle));
+  qreal h = std::abs(width * std::sin(angle)) + std::abs(height * std::cos(angle));
+  return QRectF(center.x() - w / 2., center.y() - h / 2., w, h);
+}
@@ -0,0 +1,121 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_LABELPLACEMENT_H
+#define LITTLENAVMAP_LABELPLACEMENT_H
+
+#include <QHash>
+#include <QRectF>
+#include <QVector>
+
+#include <functional>
+
+class QFontMetricsF;
+class QPainter;
+class QStringList;
+
+/*
+ * Frame local index of text labels placed on the map. Labels are checked using a cheap estimated bounding
+ * rectangle before any text layout is done and skipped if they overlap an already placed label of the same
+ * or higher priority.
+ *
+ * Labels of the static layers are submitted as candidates while the layers are painted and resolved in order of
+ * priority once all layers are done. This makes the result independent of the painter order. Accepted labels
+ * are drawn on top of all static layers. Route labels are placed directly and always drawn.
+ *
+ * Rectangles are kept in a spatial hash of square screen cells. Each cell holds the indexes of all
+ * rectangles touching it.
+ */
+class LabelPlacement
+{
+public:
+  /* A label is only hidden by labels having the same or a higher priority */
+  enum Priority
+  {
+    PRIORITY_AIRWAY,
+    PRIORITY_NAVAID,
+    PRIORITY_AIRPORT,
+    PRIORITY_ROUTE /* Always drawn */
+  };
+
+  LabelPlacement();
+
+  /* Remove all labels and candidates. Called at the start of each frame. */
+  void clear();
+
+  /* Reserve the rectangle if it does not overlap any other label with the same or higher priority.
+   * Returns false if the label should not be drawn. */
+  bool place(const QRectF& rect, int priority);
+
+  /* Add a candidate for resolve(). draw is called with the target painter if the label is accepted and has to
+   * capture all needed painter state. */
+  void submit(const QRectF& rect, int priority, const std::function<void(QPainter *painter)>& draw);
+
+  /* Place all candidates in order of descending priority and draw the accepted ones. Candidates having the
+   * same priority keep their submission order. Removes all candidates. */
+  void resolve(QPainter *painter);
+
+  /* true if labels with this priority have to be submitted as candidates instead of being placed directly */
+  static bool isDeferred(int priority)
+  {
+    return priority < PRIORITY_ROUTE;
+  }
+
+  /* Estimate bounding rectangle of a block of text lines centered vertically at y using the average
+   * character width. Alignment is right of x (default), left of x or centered. */
+  static QRectF estimateTextRect(const QFontMetricsF& metrics, const QStringList& texts, float x, float y,
+                                 bool alignRight, bool alignCenter);
+
+  /* Axis aligned bounding rectangle of a text with the given size rotated around its center */
+  static QRectF rotatedRect(const QPointF& center, float width, float height, float rotateDeg);
+
+  /* Number of labels placed and hidden since last call of clear() */
+  int getNumPlaced() const
+  {
+    return rects.size();
+  }
+
+  int getNumHidden() const
+  {
+    return numHidden;
+  }
+
+private:
+  /* Size of the hash cells in pixel */
+  static Q_DECL_CONSTEXPR int CELL_SIZE = 64;
+
+  static quint32 cellKey(int cellX, int cellY)
+  {
+    return static_cast<quint32>(cellX + 0x8000) << 16 | static_cast<quint32>(cellY + 0x8000);
+  }
+
+  struct Candidate
+  {
+    QRectF rect;
+    int priority;
+    std::function<void(QPainter *painter)> draw;
+  };
+
+  QHash<quint32, QVector<int> > cells;
+  QVector<QRectF> rects;
+  QVector<int> priorities;
+  QVector<Candidate> candidates;
+  int numHidden = 0;
+};
+
+#endif // LITTLENAVMAP_LABELPLACEMENT_H
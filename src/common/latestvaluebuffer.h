@@ -0,0 +1,72 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_LATESTVALUEBUFFER_H
+#define LITTLENAVMAP_LATESTVALUEBUFFER_H
+
+#include <atomic>
+
+/*
+ * Lock free buffer keeping only the latest value written by a producer thread.
+ *
+ * The producer replaces any value not fetched yet by the consumer. The consumer takes ownership of the latest value.
+ * Writing and taking never block and intermediate values are dropped.
+ * Values are allocated on the heap so no copies are done when taking.
+ */
+template<typename TYPE>
+class LatestValueBuffer
+{
+public:
+  LatestValueBuffer()
+  {
+  }
+
+  ~LatestValueBuffer()
+  {
+    delete pending.exchange(nullptr);
+  }
+
+  LatestValueBuffer(const LatestValueBuffer& other) = delete;
+  LatestValueBuffer& operator=(const LatestValueBuffer& other) = delete;
+
+  /* Store a copy of value and drop any value not taken yet.
+   * Returns true if the buffer was empty before, i.e. the consumer has to be notified. */
+  bool write(const TYPE& value)
+  {
+    TYPE *old = pending.exchange(new TYPE(value));
+    delete old;
+    return old == nullptr;
+  }
+
+  /* Take the latest value or return null if nothing was written since the last call. Caller takes ownership. */
+  TYPE *take()
+  {
+    return pending.exchange(nullptr);
+  }
+
+  /* Drop value not taken yet */
+  void clear()
+  {
+    delete pending.exchange(nullptr);
+  }
+
+private:
+  std::atomic<TYPE *> pending {nullptr};
+};
+
+#endif // LITTLENAVMAP_LATESTVALUEBUFFER_H
@@ -16,6 +16,7 @@
 *****************************************************************************/
 
 #include "common/mapcolors.h"
+#include "common/symbolatlas.h"
 
 #include "mapgui/mapquery.h"
 #include "options/optiondata.h"
@@ -41,6 +42,7 @@ QColor ilsSymbolColor(Qt::darkGreen);
 
 QColor ilsTextColor(0, 30, 0);
 QColor waypointSymbolColor(200, 0, 200);
+QColor aiVehicleClusterColor(Qt::black);
 QPen airwayVictorPen(QColor(150, 150, 150), 1.5);
 QPen airwayJetPen(QColor(100, 100, 100), 1.5);
 QPen airwayBothPen(QColor(100, 100, 100), 1.5);
@@ -407,6 +409,9 @@ void syncPen(QSettings& settings, const QString& key, QPen& pen)
 
 void syncColors()
 {
+  // Pre-rendered symbols use the old colors
+  SymbolAtlas::instance().clear();
+
   QString filename = atools::settings::Settings::instance().getConfigFilename("_mapstyle.ini");
 
   QSettings colorSettings(filename, QSettings::IniFormat);
@@ -426,6 +431,10 @@ void syncColors()
   syncColor(colorSettings, "WaypointColor", waypointSymbolColor);
   colorSettings.endGroup();
 
+  colorSettings.beginGroup("Vehicle");
+  syncColor(colorSettings, "AiClusterColor", aiVehicleClusterColor);
+  colorSettings.endGroup();
+
   colorSettings.beginGroup("Airway");
   syncPen(colorSettings, "VictorPen", airwayVictorPen);
   syncPen(colorSettings, "JetPen", airwayJetPen);
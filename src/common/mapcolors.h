@@ -50,6 +50,7 @@ extern QColor markerSymbolColor;
 extern QColor ilsSymbolColor;
 extern QColor ilsTextColor;
 extern QColor waypointSymbolColor;
+extern QColor aiVehicleClusterColor;
 extern QPen airwayVictorPen;
 extern QPen airwayJetPen;
 extern QPen airwayBothPen;
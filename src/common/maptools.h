@@ -21,10 +21,13 @@
 #include "common/coordinateconverter.h"
 #include "geo/calculations.h"
 #include "common/mapflags.h"
+#include "common/maptypes.h"
 #include "geo/pos.h"
 
+#include <QHash>
 #include <QList>
 #include <QSet>
+#include <QVector>
 #include <algorithm>
 #include <functional>
 
@@ -172,6 +175,62 @@ void insertSortedByTowerDistance(const CoordinateConverter& conv, QList<TYPE>& l
   list.insert(it, type);
 }
 
+/*
+ * Group objects into a grid of cells with cellSizeDeg degrees. Each cell is represented by the object
+ * having the highest priority. No object is dropped - the count of a cluster gives the number of objects in the cell.
+ * @param list objects to group. QList or QVector.
+ * @param clusters result with indexes into list
+ * @param filter clustering ignores objects where this returns false
+ * @param priority object with the highest value is used as representative of a cell
+ */
+template<typename TYPE, typename LIST>
+void clusterObjects(const LIST& list, float cellSizeDeg, QList<map::MapObjectCluster>& clusters,
+                    std::function<bool(const TYPE&)> filter, std::function<int(const TYPE&)> priority)
+{
+  clusters.clear();
+  if(list.isEmpty() || !(cellSizeDeg > 0.f))
+    return;
+
+  // Maps grid cell to index in clusters
+  QHash<quint64, int> cells;
+  QVector<int> priorities;
+
+  for(int i = 0; i < list.size(); i++)
+  {
+    const TYPE& obj = list.at(i);
+    if(!filter(obj))
+      continue;
+
+    const atools::geo::Pos pos = obj.getPosition();
+    quint64 column = static_cast<quint64>((pos.getLonX() + 180.f) / cellSizeDeg);
+    quint64 row = static_cast<quint64>((pos.getLatY() + 90.f) / cellSizeDeg);
+    quint64 cell = (row << 32) | column;
+    int prio = priority(obj);
+
+    auto it = cells.constFind(cell);
+    if(it == cells.constEnd())
+    {
+      cells.insert(cell, clusters.size());
+      clusters.append({pos, i, 1});
+      priorities.append(prio);
+    }
+    else
+    {
+      int clusterIndex = it.value();
+      map::MapObjectCluster& cluster = clusters[clusterIndex];
+      cluster.count++;
+
+      if(prio > priorities.at(clusterIndex))
+      {
+        // More important object found - use as new representative
+        cluster.position = pos;
+        cluster.index = i;
+        priorities[clusterIndex] = prio;
+      }
+    }
+  }
+}
+
 } // namespace maptools
 
 #endif // LITTLENAVMAP_MAPTOOLS_H
@@ -573,6 +573,26 @@ struct MapAirspace
 
 };
 
+/* Grid cell of airports or navaids aggregated for low zoom levels.
+ * Refers to the most important object in the cell which is used as representative. */
+struct MapObjectCluster
+{
+  atools::geo::Pos position; /* Position of the representative object */
+  int index; /* Index of the representative object in the cache list */
+  int count; /* Number of objects in the cell including the representative */
+
+  bool isValid() const
+  {
+    return position.isValid();
+  }
+
+  const atools::geo::Pos& getPosition() const
+  {
+    return position;
+  }
+
+};
+
 /* Mixed search result for e.g. queries on a bounding rectangle for map display or for all get nearest methods */
 struct MapSearchResult
 {
@@ -781,6 +801,7 @@ Q_DECLARE_TYPEINFO(map::MapUserpoint, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(map::MapSearchResult, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(map::PosCourse, Q_PRIMITIVE_TYPE);
 Q_DECLARE_TYPEINFO(map::MapAirspace, Q_MOVABLE_TYPE);
+Q_DECLARE_TYPEINFO(map::MapObjectCluster, Q_MOVABLE_TYPE);
 
 Q_DECLARE_TYPEINFO(map::RangeMarker, Q_MOVABLE_TYPE);
 Q_DECLARE_METATYPE(map::RangeMarker);
@@ -18,14 +18,20 @@
 #include "common/maptypesfactory.h"
 
 #include <cmath>
-#include "sql/sqlrecord.h"
+#include "common/sqlrecordbinding.h"
 #include "geo/calculations.h"
 #include "common/maptypes.h"
+#include "common/stringpool.h"
 
 using namespace atools::geo;
-using atools::sql::SqlRecord;
 using namespace map;
 
+/* Get a string sharing its data with the global pool. Used only for idents, regions, types and airway names. */
+static inline QString internStr(const SqlRecordBinding& record, const char *name)
+{
+  return StringPool::instance().intern(record.valueStr(name));
+}
+
 MapTypesFactory::MapTypesFactory()
 {
 
@@ -36,7 +42,7 @@ MapTypesFactory::~MapTypesFactory()
 
 }
 
-void MapTypesFactory::fillAirport(const SqlRecord& record, map::MapAirport& airport, bool complete)
+void MapTypesFactory::fillAirport(const SqlRecordBinding& record, map::MapAirport& airport, bool complete)
 {
   fillAirportBase(record, airport, complete);
 
@@ -58,7 +64,7 @@ void MapTypesFactory::fillAirport(const SqlRecord& record, map::MapAirport& airp
     airport.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), 0.f);
 }
 
-void MapTypesFactory::fillAirportForOverview(const SqlRecord& record, map::MapAirport& airport)
+void MapTypesFactory::fillAirportForOverview(const SqlRecordBinding& record, map::MapAirport& airport)
 {
   fillAirportBase(record, airport, true);
 
@@ -66,7 +72,7 @@ void MapTypesFactory::fillAirportForOverview(const SqlRecord& record, map::MapAi
   airport.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), 0.f);
 }
 
-void MapTypesFactory::fillRunway(const atools::sql::SqlRecord& record, map::MapRunway& runway,
+void MapTypesFactory::fillRunway(const SqlRecordBinding& record, map::MapRunway& runway,
                                  bool overview)
 {
   if(!overview)
@@ -107,7 +113,7 @@ void MapTypesFactory::fillRunway(const atools::sql::SqlRecord& record, map::MapR
   runway.secondaryPosition = Pos(record.valueFloat("secondary_lonx"), record.valueFloat("secondary_laty"));
 }
 
-void MapTypesFactory::fillRunwayEnd(const atools::sql::SqlRecord& record, MapRunwayEnd& end)
+void MapTypesFactory::fillRunwayEnd(const SqlRecordBinding& record, MapRunwayEnd& end)
 {
   end.name = record.valueStr("name");
   end.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"));
@@ -117,14 +123,14 @@ void MapTypesFactory::fillRunwayEnd(const atools::sql::SqlRecord& record, MapRun
     end.heading = atools::geo::opposedCourseDeg(end.heading);
 }
 
-void MapTypesFactory::fillAirportBase(const SqlRecord& record, map::MapAirport& ap, bool complete)
+void MapTypesFactory::fillAirportBase(const SqlRecordBinding& record, map::MapAirport& ap, bool complete)
 {
   ap.id = record.valueInt("airport_id");
 
   if(complete)
   {
     ap.towerFrequency = record.valueInt("tower_frequency");
-    ap.ident = record.valueStr("ident");
+    ap.ident = internStr(record, "ident");
     ap.name = record.valueStr("name");
     ap.longestRunwayLength = record.valueInt("longest_runway_length");
     ap.longestRunwayHeading = static_cast<int>(std::round(record.valueFloat("longest_runway_heading")));
@@ -136,7 +142,7 @@ void MapTypesFactory::fillAirportBase(const SqlRecord& record, map::MapAirport&
   }
 }
 
-map::MapAirportFlags MapTypesFactory::fillAirportFlags(const SqlRecord& record, bool overview)
+map::MapAirportFlags MapTypesFactory::fillAirportFlags(const SqlRecordBinding& record, bool overview)
 {
   MapAirportFlags flags = 0;
   flags |= airportFlag(record, "num_helipad", AP_HELIPAD);
@@ -186,7 +192,7 @@ map::MapAirportFlags MapTypesFactory::fillAirportFlags(const SqlRecord& record,
   return flags;
 }
 
-map::MapAirportFlags MapTypesFactory::airportFlag(const SqlRecord& record, const QString& field,
+map::MapAirportFlags MapTypesFactory::airportFlag(const SqlRecordBinding& record, const char *field,
                                                   map::MapAirportFlags flag)
 {
   if(record.isNull(field) || record.valueInt(field) == 0)
@@ -195,7 +201,7 @@ map::MapAirportFlags MapTypesFactory::airportFlag(const SqlRecord& record, const
     return flag;
 }
 
-void MapTypesFactory::fillVor(const SqlRecord& record, map::MapVor& vor)
+void MapTypesFactory::fillVor(const SqlRecordBinding& record, map::MapVor& vor)
 {
   fillVorBase(record, vor);
 
@@ -203,7 +209,7 @@ void MapTypesFactory::fillVor(const SqlRecord& record, map::MapVor& vor)
   vor.hasDme = !record.isNull("dme_altitude");
 }
 
-void MapTypesFactory::fillVorFromNav(const SqlRecord& record, map::MapVor& vor)
+void MapTypesFactory::fillVorFromNav(const SqlRecordBinding& record, map::MapVor& vor)
 {
   fillVorBase(record, vor);
 
@@ -262,23 +268,24 @@ void MapTypesFactory::fillVorFromNav(const SqlRecord& record, map::MapVor& vor)
   vor.frequency /= 10;
 }
 
-void MapTypesFactory::fillVorBase(const SqlRecord& record, map::MapVor& vor)
+void MapTypesFactory::fillVorBase(const SqlRecordBinding& record, map::MapVor& vor)
 {
   vor.id = record.valueInt("vor_id");
-  vor.ident = record.valueStr("ident");
-  vor.region = record.valueStr("region");
+  vor.ident = internStr(record, "ident");
+  vor.region = internStr(record, "region");
   vor.name = atools::capString(record.valueStr("name"));
 
   // Check also for types from the nav_search table and VORTACs
   QString type = record.valueStr("type");
+  StringPool& pool = StringPool::instance();
   if(type == "VH" || type == "VTH")
-    vor.type = "H";
+    vor.type = pool.intern("H");
   else if(type == "VL" || type == "VTL")
-    vor.type = "L";
+    vor.type = pool.intern("L");
   else if(type == "VT" || type == "VTT")
-    vor.type = "T";
+    vor.type = pool.intern("T");
   else
-    vor.type = type;
+    vor.type = pool.intern(type);
 
   vor.tacan = type == "TC";
   vor.vortac = type.startsWith("VT");
@@ -292,13 +299,13 @@ void MapTypesFactory::fillVorBase(const SqlRecord& record, map::MapVor& vor)
                      record.valueFloat("altitude"));
 }
 
-void MapTypesFactory::fillNdb(const SqlRecord& record, map::MapNdb& ndb)
+void MapTypesFactory::fillNdb(const SqlRecordBinding& record, map::MapNdb& ndb)
 {
   ndb.id = record.valueInt("ndb_id");
-  ndb.ident = record.valueStr("ident");
-  ndb.region = record.valueStr("region");
+  ndb.ident = internStr(record, "ident");
+  ndb.region = internStr(record, "region");
   ndb.name = atools::capString(record.valueStr("name"));
-  ndb.type = record.valueStr("type");
+  ndb.type = internStr(record, "type");
   ndb.frequency = record.valueInt("frequency");
   ndb.range = record.valueInt("range");
   ndb.magvar = record.valueFloat("mag_var");
@@ -306,36 +313,36 @@ void MapTypesFactory::fillNdb(const SqlRecord& record, map::MapNdb& ndb)
                      record.valueFloat("altitude"));
 }
 
-void MapTypesFactory::fillWaypoint(const SqlRecord& record, map::MapWaypoint& waypoint)
+void MapTypesFactory::fillWaypoint(const SqlRecordBinding& record, map::MapWaypoint& waypoint)
 {
   waypoint.id = record.valueInt("waypoint_id");
-  waypoint.ident = record.valueStr("ident");
-  waypoint.region = record.valueStr("region");
+  waypoint.ident = internStr(record, "ident");
+  waypoint.region = internStr(record, "region");
   // waypoint.airportIdent = record.valueStr("region");
-  waypoint.type = record.valueStr("type");
+  waypoint.type = internStr(record, "type");
   waypoint.magvar = record.valueFloat("mag_var");
   waypoint.hasVictorAirways = record.valueInt("num_victor_airway") > 0;
   waypoint.hasJetAirways = record.valueInt("num_jet_airway") > 0;
   waypoint.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"));
 }
 
-void MapTypesFactory::fillWaypointFromNav(const SqlRecord& record, map::MapWaypoint& waypoint)
+void MapTypesFactory::fillWaypointFromNav(const SqlRecordBinding& record, map::MapWaypoint& waypoint)
 {
   waypoint.id = record.valueInt("waypoint_id");
-  waypoint.ident = record.valueStr("ident");
-  waypoint.region = record.valueStr("region");
-  waypoint.type = record.valueStr("type");
+  waypoint.ident = internStr(record, "ident");
+  waypoint.region = internStr(record, "region");
+  waypoint.type = internStr(record, "type");
   waypoint.magvar = record.valueFloat("mag_var");
   waypoint.hasVictorAirways = record.valueInt("waypoint_num_victor_airway") > 0;
   waypoint.hasJetAirways = record.valueInt("waypoint_num_jet_airway") > 0;
   waypoint.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"));
 }
 
-void MapTypesFactory::fillAirway(const SqlRecord& record, map::MapAirway& airway)
+void MapTypesFactory::fillAirway(const SqlRecordBinding& record, map::MapAirway& airway)
 {
   airway.id = record.valueInt("airway_id");
   airway.type = airwayTypeFromString(record.valueStr("airway_type"));
-  airway.name = record.valueStr("airway_name");
+  airway.name = internStr(record, "airway_name");
   airway.minAltitude = record.valueInt("minimum_altitude");
   airway.fragment = record.valueInt("airway_fragment_no");
   airway.sequence = record.valueInt("sequence_no");
@@ -355,19 +362,19 @@ void MapTypesFactory::fillAirway(const SqlRecord& record, map::MapAirway& airway
   airway.bounding = Rect(west, north, east, south);
 }
 
-void MapTypesFactory::fillMarker(const SqlRecord& record, map::MapMarker& marker)
+void MapTypesFactory::fillMarker(const SqlRecordBinding& record, map::MapMarker& marker)
 {
   marker.id = record.valueInt("marker_id");
-  marker.type = record.valueStr("type");
+  marker.type = internStr(record, "type");
   marker.heading = static_cast<int>(std::round(record.valueFloat("heading")));
   marker.position = Pos(record.valueFloat("lonx"),
                         record.valueFloat("laty"));
 }
 
-void MapTypesFactory::fillIls(const SqlRecord& record, map::MapIls& ils)
+void MapTypesFactory::fillIls(const SqlRecordBinding& record, map::MapIls& ils)
 {
   ils.id = record.valueInt("ils_id");
-  ils.ident = record.valueStr("ident");
+  ils.ident = internStr(record, "ident");
   ils.name = record.valueStr("name");
   ils.heading = record.valueFloat("loc_heading");
   ils.width = record.valueFloat("loc_width");
@@ -389,11 +396,11 @@ void MapTypesFactory::fillIls(const SqlRecord& record, map::MapIls& ils)
   ils.bounding.extend(ils.pos2);
 }
 
-void MapTypesFactory::fillParking(const SqlRecord& record, map::MapParking& parking)
+void MapTypesFactory::fillParking(const SqlRecordBinding& record, map::MapParking& parking)
 {
   parking.id = record.valueInt("parking_id");
   parking.airportId = record.valueInt("airport_id");
-  parking.type = record.valueStr("type");
+  parking.type = internStr(record, "type");
   parking.name = record.valueStr("name");
   parking.airlineCodes = record.valueStr("airline_codes");
 
@@ -405,28 +412,28 @@ void MapTypesFactory::fillParking(const SqlRecord& record, map::MapParking& park
   parking.radius = static_cast<int>(std::round(record.valueFloat("radius")));
 }
 
-void MapTypesFactory::fillStart(const SqlRecord& record, map::MapStart& start)
+void MapTypesFactory::fillStart(const SqlRecordBinding& record, map::MapStart& start)
 {
   start.id = record.valueInt("start_id");
   start.airportId = record.valueInt("airport_id");
-  start.type = record.valueStr("type");
+  start.type = internStr(record, "type");
   start.runwayName = record.valueStr("runway_name");
   start.helipadNumber = record.valueInt("number");
   start.position = Pos(record.valueFloat("lonx"), record.valueFloat("laty"), record.valueFloat("altitude"));
   start.heading = static_cast<int>(std::roundf(record.valueFloat("heading")));
 }
 
-void MapTypesFactory::fillAirspace(const SqlRecord& record, map::MapAirspace& airspace)
+void MapTypesFactory::fillAirspace(const SqlRecordBinding& record, map::MapAirspace& airspace)
 {
   airspace.id = record.valueInt("boundary_id");
 
   airspace.type = map::airspaceTypeFromDatabase(record.valueStr("type"));
   airspace.name = record.valueStr("name");
-  airspace.comType = record.valueStr("com_type");
+  airspace.comType = internStr(record, "com_type");
   airspace.comFrequency = record.valueInt("com_frequency");
   airspace.comName = record.valueStr("com_name");
-  airspace.minAltitudeType = record.valueStr("min_altitude_type");
-  airspace.maxAltitudeType = record.valueStr("max_altitude_type");
+  airspace.minAltitudeType = internStr(record, "min_altitude_type");
+  airspace.maxAltitudeType = internStr(record, "max_altitude_type");
   airspace.maxAltitude = record.valueInt("max_altitude");
   airspace.minAltitude = record.valueInt("min_altitude");
 
@@ -19,13 +19,7 @@
 #define LITTLENAVMAP_MAPTYPESFACTORY_H
 
 #include "common/mapflags.h"
-
-namespace atools {
-namespace sql {
-
-class SqlRecord;
-}
-}
+#include "common/sqlrecordbinding.h"
 
 namespace map {
 struct MapAirport;
@@ -57,6 +51,8 @@ struct MapMarker;
 /*
  * Create all map objects (namespace maptypes) from sql records. The sql records can be
  * a result from sql queries or manually built.
+ * A SqlRecord can be passed directly for single rows. Bulk loads should pass a SqlRecordBinding which is kept
+ * for the query to avoid resolving column names for each row.
  */
 class MapTypesFactory
 {
@@ -69,42 +65,42 @@ public:
    * @param complete if false only id and position are present in the record. Used for creating the object
    * based on incomplete records in the search.
    */
-  void fillAirport(const atools::sql::SqlRecord& record, map::MapAirport& airport, bool complete);
+  void fillAirport(const SqlRecordBinding& record, map::MapAirport& airport, bool complete);
 
   /* Populate airport from queries based on the overview tables airport_medium and airport_large. */
-  void fillAirportForOverview(const atools::sql::SqlRecord& record, map::MapAirport& airport);
+  void fillAirportForOverview(const SqlRecordBinding& record, map::MapAirport& airport);
 
   /*
    * @param overview if true fill only fields needed for airport overview symbol (white filled runways)
    */
-  void fillRunway(const atools::sql::SqlRecord& record, map::MapRunway& runway, bool overview);
-  void fillRunwayEnd(const atools::sql::SqlRecord& record, map::MapRunwayEnd& end);
+  void fillRunway(const SqlRecordBinding& record, map::MapRunway& runway, bool overview);
+  void fillRunwayEnd(const SqlRecordBinding& record, map::MapRunwayEnd& end);
 
-  void fillVor(const atools::sql::SqlRecord& record, map::MapVor& vor);
-  void fillVorFromNav(const atools::sql::SqlRecord& record, map::MapVor& vor);
+  void fillVor(const SqlRecordBinding& record, map::MapVor& vor);
+  void fillVorFromNav(const SqlRecordBinding& record, map::MapVor& vor);
 
-  void fillNdb(const atools::sql::SqlRecord& record, map::MapNdb& ndb);
+  void fillNdb(const SqlRecordBinding& record, map::MapNdb& ndb);
 
-  void fillWaypoint(const atools::sql::SqlRecord& record, map::MapWaypoint& waypoint);
-  void fillWaypointFromNav(const atools::sql::SqlRecord& record, map::MapWaypoint& waypoint);
+  void fillWaypoint(const SqlRecordBinding& record, map::MapWaypoint& waypoint);
+  void fillWaypointFromNav(const SqlRecordBinding& record, map::MapWaypoint& waypoint);
 
-  void fillAirway(const atools::sql::SqlRecord& record, map::MapAirway& airway);
-  void fillMarker(const atools::sql::SqlRecord& record, map::MapMarker& marker);
-  void fillIls(const atools::sql::SqlRecord& record, map::MapIls& ils);
+  void fillAirway(const SqlRecordBinding& record, map::MapAirway& airway);
+  void fillMarker(const SqlRecordBinding& record, map::MapMarker& marker);
+  void fillIls(const SqlRecordBinding& record, map::MapIls& ils);
 
-  void fillParking(const atools::sql::SqlRecord& record, map::MapParking& parking);
-  void fillStart(const atools::sql::SqlRecord& record, map::MapStart& start);
+  void fillParking(const SqlRecordBinding& record, map::MapParking& parking);
+  void fillStart(const SqlRecordBinding& record, map::MapStart& start);
 
-  void fillAirspace(const atools::sql::SqlRecord& record, map::MapAirspace& airspace);
+  void fillAirspace(const SqlRecordBinding& record, map::MapAirspace& airspace);
 
 private:
-  void fillVorBase(const atools::sql::SqlRecord& record, map::MapVor& vor);
+  void fillVorBase(const SqlRecordBinding& record, map::MapVor& vor);
 
-  void fillAirportBase(const atools::sql::SqlRecord& record, map::MapAirport& ap, bool complete);
+  void fillAirportBase(const SqlRecordBinding& record, map::MapAirport& ap, bool complete);
 
-  map::MapAirportFlags airportFlag(const atools::sql::SqlRecord& record, const QString& field,
+  map::MapAirportFlags airportFlag(const SqlRecordBinding& record, const char *field,
                                    map::MapAirportFlags airportFlag);
-  map::MapAirportFlags fillAirportFlags(const atools::sql::SqlRecord& record, bool overview);
+  map::MapAirportFlags fillAirportFlags(const SqlRecordBinding& record, bool overview);
 
 };
 
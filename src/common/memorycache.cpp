@@ -0,0 +1,197 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "common/memorycache.h"
+
+#include "common/constants.h"
+#include "settings/settings.h"
+
+#include <QDebug>
+#include <QObject>
+#include <QTimer>
+
+namespace memcache {
+
+MemoryCacheBase::MemoryCacheBase(const QString& cacheName)
+  : name(cacheName)
+{
+  CacheBudget::instance().registerCache(this);
+}
+
+MemoryCacheBase::~MemoryCacheBase()
+{
+  CacheBudget::instance().unregisterCache(this);
+}
+
+void MemoryCacheBase::resetStatistics()
+{
+  hits = 0;
+  misses = 0;
+  evictions = 0;
+}
+
+quint64 MemoryCacheBase::nextStamp()
+{
+  return ++CacheBudget::instance().stamp;
+}
+
+void MemoryCacheBase::addBytes(qint64 value)
+{
+  bytes += value;
+  CacheBudget::instance().bytesChanged(value);
+}
+
+void MemoryCacheBase::removeBytes(qint64 value)
+{
+  bytes -= value;
+  CacheBudget::instance().bytesChanged(-value);
+}
+
+// ---------------------------------------------------------------------------------
+CacheBudget::CacheBudget()
+{
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  budget = settings.getAndStoreValue(lnm::SETTINGS_CACHE + "BudgetMb", 128).toLongLong() * 1024 * 1024;
+}
+
+CacheBudget& CacheBudget::instance()
+{
+  static CacheBudget cacheBudget;
+  return cacheBudget;
+}
+
+void CacheBudget::setBudget(qint64 value)
+{
+  budget = value;
+  scheduleEvict();
+}
+
+void CacheBudget::registerCache(MemoryCacheBase *cache)
+{
+  caches.append(cache);
+}
+
+void CacheBudget::unregisterCache(MemoryCacheBase *cache)
+{
+  caches.removeAll(cache);
+}
+
+void CacheBudget::bytesChanged(qint64 diff)
+{
+  totalBytes += diff;
+
+  if(diff > 0)
+    scheduleEvict();
+}
+
+void CacheBudget::scheduleEvict()
+{
+  if(totalBytes > budget && !evictScheduled)
+  {
+    // Callers may still hold pointers into any cache - evict after returning to the event loop
+    evictScheduled = true;
+    QTimer::singleShot(0, []()
+    {
+      CacheBudget::instance().evict();
+    });
+  }
+}
+
+void CacheBudget::evict()
+{
+  evictScheduled = false;
+
+  if(pinCount > 0)
+    // Scheduled again when the last pin is released
+    return;
+
+  while(totalBytes > budget)
+  {
+    // Find the cache having the least recently used entry
+    MemoryCacheBase *oldestCache = nullptr;
+    quint64 oldest = 0;
+    for(MemoryCacheBase *cache : caches)
+    {
+      quint64 cacheStamp = cache->oldestStamp();
+      if(cacheStamp > 0 && (oldestCache == nullptr || cacheStamp < oldest))
+      {
+        oldestCache = cache;
+        oldest = cacheStamp;
+      }
+    }
+
+    if(oldestCache == nullptr)
+      // Nothing left that can be evicted
+      break;
+
+    oldestCache->evictOldest();
+  }
+}
+
+void CacheBudget::pin()
+{
+  pinCount++;
+}
+
+void CacheBudget::unpin()
+{
+  pinCount--;
+  if(pinCount == 0)
+    scheduleEvict();
+}
+
+QString CacheBudget::getStatisticsHtml() const
+{
+  QString html;
+  html += QObject::tr("<p>Memory used %1 kB of %2 kB</p>").
+          arg(totalBytes / 1024).arg(budget / 1024);
+
+  html += QObject::tr("<table><tr><th>Cache</th><th>Entries</th><th>kB</th>"
+                      "<th>Hits</th><th>Misses</th><th>Hit Rate %</th><th>Evictions</th></tr>");
+
+  for(const MemoryCacheBase *cache : caches)
+  {
+    quint64 lookups = cache->getHits() + cache->getMisses();
+    html += QString("<tr><td>%1</td><td align=\"right\">%2</td><td align=\"right\">%3</td>"
+                    "<td align=\"right\">%4</td><td align=\"right\">%5</td><td align=\"right\">%6</td>"
+                    "<td align=\"right\">%7</td></tr>").
+            arg(cache->getName()).
+            arg(cache->size()).
+            arg(cache->getBytes() / 1024).
+            arg(cache->getHits()).
+            arg(cache->getMisses()).
+            arg(lookups > 0 ? cache->getHits() * 100 / lookups : 0).
+            arg(cache->getEvictions());
+  }
+  html += "</table>";
+  return html;
+}
+
+void CacheBudget::logStatistics() const
+{
+  qInfo() << "Cache memory used" << totalBytes << "bytes of" << budget;
+  for(const MemoryCacheBase *cache : caches)
+    qInfo().noquote().nospace() << "Cache " << cache->getName()
+                                << " entries " << cache->size()
+                                << " bytes " << cache->getBytes()
+                                << " hits " << cache->getHits()
+                                << " misses " << cache->getMisses()
+                                << " evictions " << cache->getEvictions();
+}
+
+} // namespace memcache
@@ -0,0 +1,337 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_MEMORYCACHE_H
+#define LITTLENAVMAP_MEMORYCACHE_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+namespace memcache {
+
+class CacheBudget;
+
+/*
+ * Non template base of all memory caches which is used by the global budget for eviction and statistics.
+ */
+class MemoryCacheBase
+{
+public:
+  MemoryCacheBase(const QString& cacheName);
+  virtual ~MemoryCacheBase();
+
+  MemoryCacheBase(const MemoryCacheBase& other) = delete;
+  MemoryCacheBase& operator=(const MemoryCacheBase& other) = delete;
+
+  const QString& getName() const
+  {
+    return name;
+  }
+
+  /* Approximate memory used by all entries */
+  qint64 getBytes() const
+  {
+    return bytes;
+  }
+
+  quint64 getHits() const
+  {
+    return hits;
+  }
+
+  quint64 getMisses() const
+  {
+    return misses;
+  }
+
+  quint64 getEvictions() const
+  {
+    return evictions;
+  }
+
+  virtual int size() const = 0;
+
+  /* Reset hit, miss and eviction counters */
+  void resetStatistics();
+
+protected:
+  friend class CacheBudget;
+
+  /* Access stamp of the least recently used entry or 0 if empty */
+  virtual quint64 oldestStamp() const = 0;
+
+  /* Remove the least recently used entry. Called by the budget only. */
+  virtual void evictOldest() = 0;
+
+  /* Get a new access stamp from the budget */
+  quint64 nextStamp();
+
+  /* Update memory usage and let the budget evict entries if needed */
+  void addBytes(qint64 value);
+  void removeBytes(qint64 value);
+
+  QString name;
+  qint64 bytes = 0;
+  quint64 hits = 0, misses = 0, evictions = 0;
+};
+
+/*
+ * Global memory budget shared by all caches of MapQuery, InfoQuery and ProcedureQuery.
+ * Evicts the least recently used entries across all caches if the budget is exceeded.
+ *
+ * Eviction never happens while caches are used. It is deferred to the next event loop iteration and
+ * additionally blocked while a CachePin exists. Code holding pointers into caches across calls which might
+ * run a nested event loop, like painting the map or building an information page, has to keep a CachePin for
+ * this scope. The budget can be exceeded until the last pin is released.
+ *
+ * Not thread safe. All caches have to be used from the main thread.
+ */
+class CacheBudget
+{
+public:
+  static CacheBudget& instance();
+
+  /* Budget in bytes */
+  qint64 getBudget() const
+  {
+    return budget;
+  }
+
+  void setBudget(qint64 value);
+
+  /* Sum of all registered caches */
+  qint64 getTotalBytes() const
+  {
+    return totalBytes;
+  }
+
+  /* Table of all caches with size, hits, misses and evictions as HTML */
+  QString getStatisticsHtml() const;
+
+  /* Print statistics for all caches to the log */
+  void logStatistics() const;
+
+private:
+  friend class MemoryCacheBase;
+  friend class CachePin;
+
+  CacheBudget();
+
+  void registerCache(MemoryCacheBase *cache);
+  void unregisterCache(MemoryCacheBase *cache);
+  void bytesChanged(qint64 diff);
+
+  /* Schedule eviction for the next event loop iteration if the budget is exceeded */
+  void scheduleEvict();
+  void evict();
+
+  /* Block eviction while pinCount is not zero */
+  void pin();
+  void unpin();
+
+  QVector<MemoryCacheBase *> caches;
+  qint64 budget = 0, totalBytes = 0;
+  quint64 stamp = 0;
+  int pinCount = 0;
+  bool evictScheduled = false;
+};
+
+/*
+ * Keeps all cache entries alive for the lifetime of this object. Pins can be nested.
+ * Create on the stack for a query scope.
+ */
+class CachePin
+{
+public:
+  CachePin()
+  {
+    CacheBudget::instance().pin();
+  }
+
+  ~CachePin()
+  {
+    CacheBudget::instance().unpin();
+  }
+
+  CachePin(const CachePin& other) = delete;
+  CachePin& operator=(const CachePin& other) = delete;
+};
+
+/*
+ * Least recently used cache similar to QCache but costs entries by approximate size in bytes
+ * and collects statistics. All caches share the global CacheBudget.
+ * Like QCache the cache takes ownership of inserted objects. Returned pointers are valid until the entry is
+ * removed or replaced in the same cache, or until control returns to the event loop where the budget evicts
+ * if no CachePin exists.
+ */
+template<typename KEY, typename TYPE>
+class MemoryCache :
+  public MemoryCacheBase
+{
+public:
+  MemoryCache(const QString& cacheName)
+    : MemoryCacheBase(cacheName)
+  {
+  }
+
+  virtual ~MemoryCache() override
+  {
+    clear();
+  }
+
+  /* Insert object, take ownership and delete an already present object with the same key */
+  void insert(const KEY& key, TYPE *object, qint64 objectBytes);
+
+  /* Get object and mark it as recently used. Counts a hit if found and a miss otherwise. Returns null if not found. */
+  TYPE *object(const KEY& key);
+
+  /* Get object without changing statistics or usage order */
+  TYPE *peek(const KEY& key) const
+  {
+    auto it = entries.constFind(key);
+    return it != entries.constEnd() ? it.value().object : nullptr;
+  }
+
+  bool contains(const KEY& key) const
+  {
+    return entries.contains(key);
+  }
+
+  QList<KEY> keys() const
+  {
+    return entries.keys();
+  }
+
+  void remove(const KEY& key);
+  void clear();
+
+  virtual int size() const override
+  {
+    return entries.size();
+  }
+
+private:
+  struct Entry
+  {
+    TYPE *object;
+    qint64 bytes;
+    quint64 stamp;
+  };
+
+  virtual quint64 oldestStamp() const override
+  {
+    return usage.isEmpty() ? 0 : usage.firstKey();
+  }
+
+  virtual void evictOldest() override;
+
+  QHash<KEY, Entry> entries;
+
+  /* Maps access stamp to key in LRU order */
+  QMap<quint64, KEY> usage;
+};
+
+/* Approximate size of a list of plain structs */
+template<typename TYPE>
+qint64 listBytes(const QList<TYPE>& list)
+{
+  return static_cast<qint64>(sizeof(QList<TYPE>) + list.size() * (sizeof(TYPE) + sizeof(void *)));
+}
+
+template<typename TYPE>
+qint64 vectorBytes(const QVector<TYPE>& vector)
+{
+  return static_cast<qint64>(sizeof(QVector<TYPE>) + vector.size() * sizeof(TYPE));
+}
+
+// ---------------------------------------------------------------------------------
+template<typename KEY, typename TYPE>
+void MemoryCache<KEY, TYPE>::insert(const KEY& key, TYPE *object, qint64 objectBytes)
+{
+  remove(key);
+
+  Entry entry = {object, objectBytes, nextStamp()};
+  entries.insert(key, entry);
+  usage.insert(entry.stamp, key);
+  addBytes(objectBytes);
+}
+
+template<typename KEY, typename TYPE>
+TYPE *MemoryCache<KEY, TYPE>::object(const KEY& key)
+{
+  auto it = entries.find(key);
+  if(it == entries.end())
+  {
+    misses++;
+    return nullptr;
+  }
+
+  hits++;
+
+  // Move to end of usage list
+  usage.remove(it.value().stamp);
+  it.value().stamp = nextStamp();
+  usage.insert(it.value().stamp, key);
+  return it.value().object;
+}
+
+template<typename KEY, typename TYPE>
+void MemoryCache<KEY, TYPE>::remove(const KEY& key)
+{
+  auto it = entries.find(key);
+  if(it != entries.end())
+  {
+    Entry entry = it.value();
+    entries.erase(it);
+    usage.remove(entry.stamp);
+    delete entry.object;
+    removeBytes(entry.bytes);
+  }
+}
+
+template<typename KEY, typename TYPE>
+void MemoryCache<KEY, TYPE>::clear()
+{
+  qint64 removed = 0;
+  for(const Entry& entry : entries)
+  {
+    delete entry.object;
+    removed += entry.bytes;
+  }
+  entries.clear();
+  usage.clear();
+  removeBytes(removed);
+}
+
+template<typename KEY, typename TYPE>
+void MemoryCache<KEY, TYPE>::evictOldest()
+{
+  if(!usage.isEmpty())
+  {
+    KEY key = usage.first();
+    remove(key);
+    evictions++;
+  }
+}
+
+} // namespace memcache
+
+#endif // LITTLENAVMAP_MEMORYCACHE_H
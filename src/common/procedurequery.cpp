@@ -40,6 +40,13 @@ using proc::MapProcedureLegs;
 using proc::MapProcedureLeg;
 using proc::MapAltRestriction;
 
+/* Approximate memory used by approach and transition legs */
+static qint64 legsBytes(const proc::MapProcedureLegs& legs)
+{
+  return static_cast<qint64>(sizeof(proc::MapProcedureLegs)) +
+         memcache::vectorBytes(legs.approachLegs) + memcache::vectorBytes(legs.transitionLegs);
+}
+
 ProcedureQuery::ProcedureQuery(atools::sql::SqlDatabase *sqlDb, MapQuery *mapQueryParam)
   : db(sqlDb), mapQuery(mapQueryParam)
 {
@@ -440,8 +447,9 @@ void ProcedureQuery::updateBounding(proc::MapProcedureLegs& legs)
 proc::MapProcedureLegs *ProcedureQuery::fetchApproachLegs(const map::MapAirport& airport, int approachId)
 {
 #ifndef DEBUG_APPROACH_NO_CACHE
-  if(approachCache.contains(approachId))
-    return approachCache.object(approachId);
+  proc::MapProcedureLegs *cached = approachCache.object(approachId);
+  if(cached != nullptr)
+    return cached;
   else
 #endif
   {
@@ -453,7 +461,7 @@ proc::MapProcedureLegs *ProcedureQuery::fetchApproachLegs(const map::MapAirport&
     for(int i = 0; i < legs->size(); i++)
       approachLegIndex.insert(legs->at(i).legId, std::make_pair(approachId, i));
 
-    approachCache.insert(approachId, legs);
+    approachCache.insert(approachId, legs, legsBytes(*legs));
     return legs;
   }
 }
@@ -462,8 +470,9 @@ proc::MapProcedureLegs *ProcedureQuery::fetchTransitionLegs(const map::MapAirpor
                                                             int approachId, int transitionId)
 {
 #ifndef DEBUG_APPROACH_NO_CACHE
-  if(transitionCache.contains(transitionId))
-    return transitionCache.object(transitionId);
+  proc::MapProcedureLegs *cached = transitionCache.object(transitionId);
+  if(cached != nullptr)
+    return cached;
   else
 #endif
   {
@@ -511,7 +520,7 @@ proc::MapProcedureLegs *ProcedureQuery::fetchTransitionLegs(const map::MapAirpor
     for(int i = 0; i < legs->size(); ++i)
       transitionLegIndex.insert(legs->at(i).legId, std::make_pair(transitionId, i));
 
-    transitionCache.insert(transitionId, legs);
+    transitionCache.insert(transitionId, legs, legsBytes(*legs));
     return legs;
   }
 }
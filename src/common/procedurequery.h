@@ -20,9 +20,9 @@
 
 #include "geo/pos.h"
 #include "common/proctypes.h"
+#include "common/memorycache.h"
 #include "fs/fspaths.h"
 
-#include <QCache>
 #include <QApplication>
 #include <functional>
 
@@ -148,7 +148,8 @@ private:
 
   /* approach ID and transition ID to full lists
    * The approach also has to be stored for transitions since the handover can modify approach legs (CI legs, etc.) */
-  QCache<int, proc::MapProcedureLegs> approachCache, transitionCache;
+  memcache::MemoryCache<int, proc::MapProcedureLegs> approachCache{"ProcedureQuery Approach"},
+                                                     transitionCache{"ProcedureQuery Transition"};
 
   /* maps leg ID to approach/transition ID and index in list */
   QHash<int, std::pair<int, int> > approachLegIndex, transitionLegIndex;
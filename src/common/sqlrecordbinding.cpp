@@ -0,0 +1,48 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+
+#include "common/sqlrecordbinding.h"
+
+#include "sql/sqlquery.h"
+#include "exception.h"
+
+int SqlRecordBinding::indexOf(const char *name) const
+{
+  if(query == nullptr)
+    return record.contains(name) ? record.indexOf(name) : -1;
+
+  // Look up without copying the name
+  auto it = indexes.constFind(QByteArray::fromRawData(name, static_cast<int>(qstrlen(name))));
+  if(it != indexes.constEnd())
+    return it.value();
+
+  // Resolve once per column - record is copied only on the first access of a column
+  atools::sql::SqlRecord rec = query->record();
+  int idx = rec.contains(name) ? rec.indexOf(name) : -1;
+  indexes.insert(QByteArray(name), idx);
+  return idx;
+}
+
+QVariant SqlRecordBinding::value(const char *name) const
+{
+  int idx = indexOf(name);
+  if(idx == -1)
+    throw atools::Exception(QString("SqlRecordBinding: column \"%1\" not found").arg(name));
+  return query->value(idx);
+}
@@ -0,0 +1,113 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_SQLRECORDBINDING_H
+#define LITTLENAVMAP_SQLRECORDBINDING_H
+
+#include "sql/sqlrecord.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QVariant>
+
+namespace atools {
+namespace sql {
+class SqlQuery;
+}
+}
+
+/*
+ * Caches column positions for all rows of one prepared query. A column name is resolved only on first access
+ * and the position is reused for all following rows. Values are read directly from the current row of the query
+ * by position without copying the record.
+ *
+ * Positions are keyed by the column name content. Throws an exception if a column does not exist.
+ *
+ * Can be constructed implicitly from a SqlRecord for single row lookups. Such a binding does not cache
+ * positions and passes all names directly to the record like a plain SqlRecord does.
+ */
+class SqlRecordBinding
+{
+public:
+  SqlRecordBinding()
+  {
+  }
+
+  /* Bind to query. The query has to stay valid and keep its column layout while the binding is used. */
+  explicit SqlRecordBinding(atools::sql::SqlQuery *sqlQuery)
+    : query(sqlQuery)
+  {
+  }
+
+  SqlRecordBinding(const atools::sql::SqlRecord& sqlRecord)
+    : record(sqlRecord)
+  {
+  }
+
+  /* Remove all cached positions. Has to be called if the query is prepared again. */
+  void clear()
+  {
+    indexes.clear();
+  }
+
+  /* Column position or -1 if not found */
+  int indexOf(const char *name) const;
+
+  bool contains(const char *name) const
+  {
+    return indexOf(name) != -1;
+  }
+
+  bool isNull(const char *name) const
+  {
+    return query != nullptr ? value(name).isNull() : record.isNull(name);
+  }
+
+  QString valueStr(const char *name) const
+  {
+    return query != nullptr ? value(name).toString() : record.valueStr(name);
+  }
+
+  int valueInt(const char *name) const
+  {
+    return query != nullptr ? value(name).toInt() : record.valueInt(name);
+  }
+
+  float valueFloat(const char *name) const
+  {
+    return query != nullptr ? value(name).toFloat() : record.valueFloat(name);
+  }
+
+  bool valueBool(const char *name) const
+  {
+    return query != nullptr ? value(name).toBool() : record.valueBool(name);
+  }
+
+private:
+  /* Value of the current query row. Throws an exception if the column does not exist. */
+  QVariant value(const char *name) const;
+
+  /* Used for single records only */
+  atools::sql::SqlRecord record;
+
+  /* Used for bound queries only */
+  atools::sql::SqlQuery *query = nullptr;
+  mutable QHash<QByteArray, int> indexes;
+};
+
+#endif // LITTLENAVMAP_SQLRECORDBINDING_H
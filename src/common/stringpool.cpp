@@ -0,0 +1,87 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "common/stringpool.h"
+
+StringPool::StringPool()
+{
+  index.reserve(50000);
+  strings.reserve(50000);
+}
+
+StringPool& StringPool::instance()
+{
+  static StringPool pool;
+  return pool;
+}
+
+int StringPool::handle(const QString& str)
+{
+  if(str.isEmpty())
+    return INVALID_HANDLE;
+
+  return handleInternal(str);
+}
+
+int StringPool::find(const QString& str) const
+{
+  if(str.isEmpty())
+    return INVALID_HANDLE;
+
+  return index.value(str, INVALID_HANDLE);
+}
+
+QString StringPool::intern(const QString& str)
+{
+  // Keep null and empty strings as they are since callers may distinguish them
+  if(str.isEmpty())
+    return str;
+
+  return strings.at(handleInternal(str));
+}
+
+QString StringPool::string(int handle) const
+{
+  if(handle >= 0 && handle < strings.size())
+    return strings.at(handle);
+  else
+    return QString();
+}
+
+int StringPool::size() const
+{
+  return strings.size();
+}
+
+void StringPool::clear()
+{
+  index.clear();
+  strings.clear();
+}
+
+int StringPool::handleInternal(const QString& str)
+{
+  auto it = index.constFind(str);
+  if(it != index.constEnd())
+    return it.value();
+
+  int handle = strings.size();
+  strings.append(str);
+  index.insert(str, handle);
+  return handle;
+}
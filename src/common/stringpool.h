@@ -0,0 +1,75 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_STRINGPOOL_H
+#define LITTLENAVMAP_STRINGPOOL_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/*
+ * Global pool for short and often repeated strings like idents, ICAO regions, airway names and types.
+ *
+ * Each distinct string is stored only once and gets a small integer handle which is valid until the pool is
+ * cleared on database switch. Handles can be compared instead of strings and are resolved back to text for display.
+ * Strings returned by intern() share their data with the pool, so copies in map objects do not allocate.
+ *
+ * Only idents, regions, types and airway names are pooled. Map objects keep plain QStrings sharing the pool data
+ * and do not store handles. Handles are used by the route network only to compare airway names.
+ *
+ * Not thread safe. Use only from the GUI thread.
+ */
+class StringPool
+{
+public:
+  /* Handle for null or empty strings */
+  static Q_DECL_CONSTEXPR int INVALID_HANDLE = -1;
+
+  /* Get the global pool instance */
+  static StringPool& instance();
+
+  /* Add string if not already present and return the handle. Returns INVALID_HANDLE for empty strings. */
+  int handle(const QString& str);
+
+  /* Get handle for the string without adding it. Returns INVALID_HANDLE if not found or empty. */
+  int find(const QString& str) const;
+
+  /* Add string if not already present and return a copy sharing the data with the pool.
+   * Null and empty strings are returned unchanged and not added. */
+  QString intern(const QString& str);
+
+  /* Get string for handle or an empty string if the handle is not valid */
+  QString string(int handle) const;
+
+  /* Number of distinct strings in the pool */
+  int size() const;
+
+  /* Remove all strings. Invalidates all handles. Strings returned by intern() stay valid. */
+  void clear();
+
+private:
+  StringPool();
+
+  int handleInternal(const QString& str);
+
+  QHash<QString, int> index;
+  QVector<QString> strings;
+};
+
+#endif // LITTLENAVMAP_STRINGPOOL_H
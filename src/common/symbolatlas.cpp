@@ -0,0 +1,116 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "common/symbolatlas.h"
+
+#include <QDebug>
+#include <QPainter>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+SymbolAtlas::Key::Key(const QPainter *painter, SymbolKind symbolKind, quint32 symbolVariant, int symbolSize,
+                      int symbolAngle, QRgb symbolColor)
+  : kind(symbolKind), variant(symbolVariant), size(symbolSize), angle(symbolAngle),
+  pixelRatio(std::max(painter->device()->devicePixelRatio(), 1)), color(symbolColor)
+{
+}
+
+SymbolAtlas::SymbolAtlas()
+{
+}
+
+SymbolAtlas& SymbolAtlas::instance()
+{
+  static SymbolAtlas atlas;
+  return atlas;
+}
+
+const QImage *SymbolAtlas::find(const Key& key)
+{
+  auto it = symbols.find(key);
+  if(it == symbols.end())
+    return nullptr;
+
+  it.value().stamp = ++stamp;
+  return &it.value().image;
+}
+
+const QImage *SymbolAtlas::insert(const Key& key, const QImage& image)
+{
+  if(symbols.size() >= MAX_SYMBOLS)
+    evict();
+
+  Entry entry = {image, ++stamp};
+  return &symbols.insert(key, entry).value().image;
+}
+
+void SymbolAtlas::evict()
+{
+  // Find the access stamp separating the oldest quarter
+  QVector<quint64> stamps;
+  stamps.reserve(symbols.size());
+  for(const Entry& entry : symbols)
+    stamps.append(entry.stamp);
+
+  auto nth = stamps.begin() + stamps.size() / 4;
+  std::nth_element(stamps.begin(), nth, stamps.end());
+  quint64 oldest = *nth;
+
+  for(auto it = symbols.begin(); it != symbols.end();)
+  {
+    if(it.value().stamp < oldest)
+      it = symbols.erase(it);
+    else
+      ++it;
+  }
+  qDebug() << Q_FUNC_INFO << "Symbol atlas full. Remaining" << symbols.size();
+}
+
+QImage SymbolAtlas::createImage(const Key& key, float& center) const
+{
+  // Airport fuel spikes and thick pens for fast drawing exceed the symbol size
+  int dimension = key.size * 2 + 8;
+  center = dimension / 2.f;
+
+  QImage image(dimension * key.pixelRatio, dimension * key.pixelRatio, QImage::Format_ARGB32_Premultiplied);
+  image.setDevicePixelRatio(key.pixelRatio);
+  image.fill(Qt::transparent);
+  return image;
+}
+
+void SymbolAtlas::draw(QPainter *painter, float x, float y, const QImage& image)
+{
+  // Image dimension is even - align the top left corner to device pixels to keep the cached symbol sharp
+  qreal pixelRatio = image.devicePixelRatio();
+  qreal halfSize = image.width() / pixelRatio / 2.;
+  painter->drawImage(QPointF(std::round((x - halfSize) * pixelRatio) / pixelRatio,
+                             std::round((y - halfSize) * pixelRatio) / pixelRatio), image);
+}
+
+void SymbolAtlas::clear()
+{
+  symbols.clear();
+}
+
+uint qHash(const SymbolAtlas::Key& key)
+{
+  return static_cast<uint>(key.kind) ^ (key.variant << 4) ^ (static_cast<uint>(key.size) << 12) ^
+         (static_cast<uint>(key.angle) << 20) ^ key.color ^ (static_cast<uint>(key.pixelRatio) << 29);
+}
@@ -0,0 +1,111 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_SYMBOLATLAS_H
+#define LITTLENAVMAP_SYMBOLATLAS_H
+
+#include <QHash>
+#include <QImage>
+
+class QPainter;
+
+/*
+ * Global cache of pre-rendered map symbols. Each symbol is rendered once into a transparent image for every
+ * kind, variant flags, size, rotation, color and device pixel ratio and then drawn with a single call.
+ *
+ * Images are used instead of pixmaps since recorded map layers are rasterized in worker threads.
+ * The atlas has to be cleared if map colors or the style change.
+ *
+ * Not thread safe. Use from the GUI thread only.
+ */
+class SymbolAtlas
+{
+public:
+  enum SymbolKind
+  {
+    AIRPORT,
+    VOR,
+    NDB,
+    WAYPOINT,
+    MARKER
+  };
+
+  /* Identifies a symbol image */
+  struct Key
+  {
+    /* Device pixel ratio is taken from the paint device of painter */
+    Key(const QPainter *painter, SymbolKind symbolKind, quint32 symbolVariant, int symbolSize, int symbolAngle,
+        QRgb symbolColor);
+
+    bool operator==(const Key& other) const
+    {
+      return kind == other.kind && variant == other.variant && size == other.size && angle == other.angle &&
+             color == other.color && pixelRatio == other.pixelRatio;
+    }
+
+    SymbolKind kind;
+    quint32 variant; /* Symbol specific flags like military, closed or fuel */
+    int size, angle, pixelRatio;
+    QRgb color;
+  };
+
+  static SymbolAtlas& instance();
+
+  /* Get image and mark it as recently used. Null if not rendered yet. */
+  const QImage *find(const Key& key);
+
+  /* Add a rendered image to the atlas and return a pointer valid until the next call of insert() or clear() */
+  const QImage *insert(const Key& key, const QImage& image);
+
+  /* Create a transparent image for a symbol of the given size which leaves enough room for pens and spikes.
+   * center is set to the logical symbol center in the image. */
+  QImage createImage(const Key& key, float& center) const;
+
+  /* Draw an image centered at x and y. The position is rounded to device pixels to avoid blurring. */
+  static void draw(QPainter *painter, float x, float y, const QImage& image);
+
+  /* Remove all images */
+  void clear();
+
+  int size() const
+  {
+    return symbols.size();
+  }
+
+private:
+  SymbolAtlas();
+
+  struct Entry
+  {
+    QImage image;
+    quint64 stamp;
+  };
+
+  /* Remove the least recently used quarter of all symbols */
+  void evict();
+
+  /* Limit the number of symbols if many colors or angles are used */
+  static Q_DECL_CONSTEXPR int MAX_SYMBOLS = 5000;
+
+  QHash<Key, Entry> symbols;
+  quint64 stamp = 0;
+};
+
+uint qHash(const SymbolAtlas::Key& key);
+
+#endif // LITTLENAVMAP_SYMBOLATLAS_H
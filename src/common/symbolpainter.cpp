@@ -20,10 +20,13 @@
 #include "common/maptypes.h"
 #include "mapgui/mapquery.h"
 #include "common/mapcolors.h"
+#include "common/symbolatlas.h"
+#include "common/labelplacement.h"
 #include "options/optiondata.h"
 #include "common/unit.h"
 #include "geo/calculations.h"
 #include "util/paintercontextsaver.h"
+#include "atools.h"
 
 #include <QPainter>
 #include <QApplication>
@@ -130,6 +133,37 @@ QIcon SymbolPainter::createAirspaceIcon(const map::MapAirspace& airspace, int si
 
 void SymbolPainter::drawAirportSymbol(QPainter *painter, const map::MapAirport& airport,
                                       float x, float y, int size, bool isAirportDiagram, bool fast)
+{
+  bool details = (!fast || isAirportDiagram) && size > 5;
+  bool hard = airport.flags.testFlag(AP_HARD) && !airport.flags.testFlag(AP_MIL) &&
+              !airport.flags.testFlag(AP_CLOSED);
+
+  // Round runway heading to full degrees to limit the number of symbol variants
+  int heading = details && hard ? atools::roundToInt(airport.longestRunwayHeading) % 360 : 0;
+
+  quint32 variant = (airport.longestRunwayLength == 0) | hard << 1 | airport.flags.testFlag(AP_MIL) << 2 |
+                    airport.flags.testFlag(AP_CLOSED) << 3 | airport.anyFuel() << 4 | airport.waterOnly() << 5 |
+                    airport.helipadOnly() << 6 | details << 7;
+
+  SymbolAtlas& atlas = SymbolAtlas::instance();
+  SymbolAtlas::Key key(painter, SymbolAtlas::AIRPORT, variant, size, heading,
+                       mapcolors::colorForAirport(airport).rgba());
+  const QImage *image = atlas.find(key);
+  if(image == nullptr)
+  {
+    float center;
+    QImage newImage = atlas.createImage(key, center);
+    QPainter imagePainter(&newImage);
+    prepareForIcon(imagePainter);
+    paintAirportSymbol(&imagePainter, airport, center, center, size, details, heading);
+    imagePainter.end();
+    image = atlas.insert(key, newImage);
+  }
+  SymbolAtlas::draw(painter, x, y, *image);
+}
+
+void SymbolPainter::paintAirportSymbol(QPainter *painter, const map::MapAirport& airport,
+                                       float x, float y, int size, bool details, float heading)
 {
   if(airport.longestRunwayLength == 0)
     size = size * 4 / 5;
@@ -148,7 +182,7 @@ void SymbolPainter::drawAirportSymbol(QPainter *painter, const map::MapAirport&
     // Use white filled circle
     painter->setBrush(QBrush(mapcolors::airportSymbolFillColor));
 
-  if((!fast || isAirportDiagram) && size > 5)
+  if(details)
   {
     // Draw spikes only for larger symbols
     if(airport.anyFuel() && !airport.flags.testFlag(AP_MIL) && !airport.flags.testFlag(AP_CLOSED) && size > 6)
@@ -166,7 +200,7 @@ void SymbolPainter::drawAirportSymbol(QPainter *painter, const map::MapAirport&
   painter->setPen(QPen(QBrush(apColor), size / 5, Qt::SolidLine, Qt::FlatCap));
   painter->drawEllipse(QPointF(x, y), radius, radius);
 
-  if((!fast || isAirportDiagram) && size > 5)
+  if(details)
   {
     if(airport.flags.testFlag(AP_MIL))
       // Military airport
@@ -205,14 +239,14 @@ void SymbolPainter::drawAirportSymbol(QPainter *painter, const map::MapAirport&
     }
   }
 
-  if((!fast || isAirportDiagram) && size > 5)
+  if(details)
   {
     if(airport.flags.testFlag(AP_HARD) && !airport.flags.testFlag(AP_MIL) &&
        !airport.flags.testFlag(AP_CLOSED) && size > 6)
     {
       // Draw line inside circle
       painter->translate(x, y);
-      painter->rotate(airport.longestRunwayHeading);
+      painter->rotate(heading);
       painter->setPen(QPen(QBrush(mapcolors::airportSymbolFillColor), size / 5, Qt::SolidLine, Qt::RoundCap));
       painter->drawLine(0, -radius + 2, 0, radius - 2);
       painter->resetTransform();
@@ -222,6 +256,27 @@ void SymbolPainter::drawAirportSymbol(QPainter *painter, const map::MapAirport&
 
 void SymbolPainter::drawWaypointSymbol(QPainter *painter, const QColor& col, int x, int y, int size,
                                        bool fill, bool fast)
+{
+  SymbolAtlas& atlas = SymbolAtlas::instance();
+  SymbolAtlas::Key key(painter, SymbolAtlas::WAYPOINT, fill | fast << 1, size, 0,
+                       col.isValid() ? col.rgba() : mapcolors::waypointSymbolColor.rgba());
+  const QImage *image = atlas.find(key);
+  if(image == nullptr)
+  {
+    float center;
+    QImage newImage = atlas.createImage(key, center);
+    QPainter imagePainter(&newImage);
+    prepareForIcon(imagePainter);
+    paintWaypointSymbol(&imagePainter, col, static_cast<int>(center), static_cast<int>(center), size, fill,
+                        fast);
+    imagePainter.end();
+    image = atlas.insert(key, newImage);
+  }
+  SymbolAtlas::draw(painter, x, y, *image);
+}
+
+void SymbolPainter::paintWaypointSymbol(QPainter *painter, const QColor& col, int x, int y, int size,
+                                        bool fill, bool fast)
 {
   atools::util::PainterContextSaver saver(painter);
   painter->setBackgroundMode(Qt::TransparentMode);
@@ -250,6 +305,28 @@ void SymbolPainter::drawWaypointSymbol(QPainter *painter, const QColor& col, int
     painter->drawPoint(x, y);
 }
 
+void SymbolPainter::drawClusterSymbol(QPainter *painter, const QColor& col, int x, int y, int size, int count,
+                                      bool fast)
+{
+  atools::util::PainterContextSaver saver(painter);
+  painter->setBackgroundMode(Qt::TransparentMode);
+  painter->setBrush(mapcolors::routeTextBoxColor);
+  painter->setPen(QPen(col, fast ? 1.f : 1.5f, Qt::SolidLine, Qt::SquareCap));
+
+  // Let the circle grow slowly with the number of objects
+  int radius = std::max(size / 2, 4) + std::min(static_cast<int>(std::log10(std::max(count, 1))) * 2, 6);
+  painter->drawEllipse(QPoint(x, y), radius, radius);
+
+  if(!fast)
+  {
+    QString text = QString::number(count);
+    QFontMetricsF metrics = painter->fontMetrics();
+    float w = static_cast<float>(metrics.width(text));
+    float h = static_cast<float>(metrics.ascent());
+    painter->drawText(QPointF(x - w / 2.f, y + h / 2.f - 1.f), text);
+  }
+}
+
 void SymbolPainter::drawWindPointer(QPainter *painter, float x, float y, int size, float dir)
 {
   atools::util::PainterContextSaver saver(painter);
@@ -355,6 +432,35 @@ void SymbolPainter::drawAircraftSymbol(QPainter *painter, int x, int y, int size
 
 void SymbolPainter::drawVorSymbol(QPainter *painter, const map::MapVor& vor, int x, int y, int size,
                                   bool routeFill, bool fast, int largeSize)
+{
+  if(largeSize > 0 && !vor.dmeOnly && !fast)
+  {
+    // Compass rose is rotated by magnetic variation - do not cache
+    paintVorSymbol(painter, vor, x, y, size, routeFill, fast, largeSize);
+    return;
+  }
+
+  quint32 variant = vor.tacan | vor.vortac << 1 | vor.hasDme << 2 | vor.dmeOnly << 3 | routeFill << 4 | fast << 5;
+
+  SymbolAtlas& atlas = SymbolAtlas::instance();
+  SymbolAtlas::Key key(painter, SymbolAtlas::VOR, variant, size, 0, mapcolors::vorSymbolColor.rgba());
+  const QImage *image = atlas.find(key);
+  if(image == nullptr)
+  {
+    float center;
+    QImage newImage = atlas.createImage(key, center);
+    QPainter imagePainter(&newImage);
+    prepareForIcon(imagePainter);
+    paintVorSymbol(&imagePainter, vor, static_cast<int>(center), static_cast<int>(center), size, routeFill,
+                   fast, 0);
+    imagePainter.end();
+    image = atlas.insert(key, newImage);
+  }
+  SymbolAtlas::draw(painter, x, y, *image);
+}
+
+void SymbolPainter::paintVorSymbol(QPainter *painter, const map::MapVor& vor, int x, int y, int size,
+                                   bool routeFill, bool fast, int largeSize)
 {
   atools::util::PainterContextSaver saver(painter);
   Q_UNUSED(saver);
@@ -494,6 +600,25 @@ void SymbolPainter::drawVorSymbol(QPainter *painter, const map::MapVor& vor, int
 }
 
 void SymbolPainter::drawNdbSymbol(QPainter *painter, int x, int y, int size, bool routeFill, bool fast)
+{
+  SymbolAtlas& atlas = SymbolAtlas::instance();
+  SymbolAtlas::Key key(painter, SymbolAtlas::NDB, routeFill | fast << 1, size, 0,
+                       mapcolors::ndbSymbolColor.rgba());
+  const QImage *image = atlas.find(key);
+  if(image == nullptr)
+  {
+    float center;
+    QImage newImage = atlas.createImage(key, center);
+    QPainter imagePainter(&newImage);
+    prepareForIcon(imagePainter);
+    paintNdbSymbol(&imagePainter, static_cast<int>(center), static_cast<int>(center), size, routeFill, fast);
+    imagePainter.end();
+    image = atlas.insert(key, newImage);
+  }
+  SymbolAtlas::draw(painter, x, y, *image);
+}
+
+void SymbolPainter::paintNdbSymbol(QPainter *painter, int x, int y, int size, bool routeFill, bool fast)
 {
   atools::util::PainterContextSaver saver(painter);
   float sizeF = static_cast<float>(size);
@@ -529,6 +654,26 @@ void SymbolPainter::drawNdbSymbol(QPainter *painter, int x, int y, int size, boo
 
 void SymbolPainter::drawMarkerSymbol(QPainter *painter, const map::MapMarker& marker, int x, int y,
                                      int size, bool fast)
+{
+  int heading = fast ? 0 : atools::roundToInt(marker.heading) % 360;
+
+  SymbolAtlas& atlas = SymbolAtlas::instance();
+  SymbolAtlas::Key key(painter, SymbolAtlas::MARKER, fast, size, heading, mapcolors::markerSymbolColor.rgba());
+  const QImage *image = atlas.find(key);
+  if(image == nullptr)
+  {
+    float center;
+    QImage newImage = atlas.createImage(key, center);
+    QPainter imagePainter(&newImage);
+    prepareForIcon(imagePainter);
+    paintMarkerSymbol(&imagePainter, static_cast<int>(center), static_cast<int>(center), size, heading, fast);
+    imagePainter.end();
+    image = atlas.insert(key, newImage);
+  }
+  SymbolAtlas::draw(painter, x, y, *image);
+}
+
+void SymbolPainter::paintMarkerSymbol(QPainter *painter, int x, int y, int size, float heading, bool fast)
 {
   atools::util::PainterContextSaver saver(painter);
   int radius = size / 2;
@@ -541,7 +686,7 @@ void SymbolPainter::drawMarkerSymbol(QPainter *painter, const map::MapMarker& ma
   {
     // Draw rotated lens / ellipse
     painter->translate(x, y);
-    painter->rotate(marker.heading);
+    painter->rotate(heading);
     painter->drawEllipse(QPoint(0, 0), radius, radius / 2);
     painter->resetTransform();
   }
@@ -770,7 +915,40 @@ void SymbolPainter::textBoxF(QPainter *painter, const QStringList& texts, const
     painter->setFont(f);
   }
 
-  // Draw the text
+  if(labelPlacement != nullptr)
+  {
+    // Check estimated size before doing any text layout
+    QRectF rect = LabelPlacement::estimateTextRect(painter->fontMetrics(), texts, x, y,
+                                                   atts.testFlag(textatt::RIGHT), atts.testFlag(textatt::CENTER));
+
+    if(LabelPlacement::isDeferred(labelPriority))
+    {
+      // Draw once all layers are painted and labels are resolved by priority
+      QFont font = painter->font();
+      Qt::BGMode backgroundMode = painter->backgroundMode();
+      QBrush brush = painter->brush(), background = painter->background();
+      labelPlacement->submit(rect, labelPriority, [ = ](QPainter *targetPainter)
+      {
+        atools::util::PainterContextSaver targetSaver(targetPainter);
+        Q_UNUSED(targetSaver);
+        targetPainter->setFont(font);
+        targetPainter->setBackgroundMode(backgroundMode);
+        targetPainter->setBrush(brush);
+        targetPainter->setBackground(background);
+        drawTextLines(targetPainter, texts, textPen, x, y, atts);
+      });
+      return;
+    }
+    else if(!labelPlacement->place(rect, labelPriority))
+      return;
+  }
+
+  drawTextLines(painter, texts, textPen, x, y, atts);
+}
+
+void SymbolPainter::drawTextLines(QPainter *painter, const QStringList& texts, const QPen& textPen,
+                                  float x, float y, textatt::TextAttributes atts)
+{
   QFontMetricsF metrics = painter->fontMetrics();
   float h = static_cast<float>(metrics.height()) - 1.f;
   float yoffset = (texts.size() * h) / 2.f - static_cast<float>(metrics.descent());
@@ -27,6 +27,7 @@
 
 class QPainter;
 class QPen;
+class LabelPlacement;
 
 namespace Marble {
 class GeoPainter;
@@ -90,6 +91,7 @@ Q_DECLARE_OPERATORS_FOR_FLAGS(TextAttributes);
  * Draws all kind of map symbols and texts into an icon or a QPainter. Icons can change shape depending on size.
  * Separate functions are available for texts/captions.
  * An additional parameter "fast" is used to draw icons with less details while scrolling the map.
+ * Airport, navaid and waypoint symbols are rendered once into the global SymbolAtlas and copied from there.
  * Instead of using a text collision detection text are placed on different sides of the symbols.
  */
 class SymbolPainter
@@ -121,6 +123,9 @@ public:
   /* Waypoint symbol. Can use a different color for invalid waypoints that were not found in the database */
   void drawWaypointSymbol(QPainter *painter, const QColor& col, int x, int y, int size, bool fill, bool fast);
 
+  /* Aggregate symbol for a grid cluster of airports or navaids. A circle with the number of objects inside */
+  void drawClusterSymbol(QPainter *painter, const QColor& col, int x, int y, int size, int count, bool fast);
+
   /* Wind arrow */
   void drawWindPointer(QPainter *painter, float x, float y, int size, float dir);
 
@@ -171,13 +176,36 @@ public:
   /* Get dimensions of a custom text box */
   QRect textBoxSize(QPainter *painter, const QStringList& texts, textatt::TextAttributes atts);
 
+  /* Skip text boxes overlapping other labels with the same or higher priority. Null draws all texts.
+   * Text boxes of static layers are drawn later by LabelPlacement::resolve(). */
+  void setLabelPlacement(LabelPlacement *placement, int priority)
+  {
+    labelPlacement = placement;
+    labelPriority = priority;
+  }
+
 private:
+  /* Draw text lines of a text box using the font and background of the painter */
+  static void drawTextLines(QPainter *painter, const QStringList& texts, const QPen& textPen, float x, float y,
+                            textatt::TextAttributes atts);
+
+  /* Vector drawing methods used to fill the symbol atlas */
+  void paintAirportSymbol(QPainter *painter, const map::MapAirport& airport, float x, float y, int size,
+                          bool details, float heading);
+  void paintWaypointSymbol(QPainter *painter, const QColor& col, int x, int y, int size, bool fill, bool fast);
+  void paintVorSymbol(QPainter *painter, const map::MapVor& vor, int x, int y, int size, bool routeFill,
+                      bool fast, int largeSize);
+  void paintNdbSymbol(QPainter *painter, int x, int y, int size, bool routeFill, bool fast);
+  void paintMarkerSymbol(QPainter *painter, int x, int y, int size, float heading, bool fast);
+
   QStringList airportTexts(opts::DisplayOptions dispOpts, textflags::TextFlags flags,
                            const map::MapAirport& airport);
   const QPixmap *windPointerFromCache(int size);
   const QPixmap *trackLineFromCache(int size);
 
   QColor iconBackground;
+  LabelPlacement *labelPlacement = nullptr;
+  int labelPriority = 0;
   QCache<int, QPixmap> windPointerPixmaps, trackLinePixmaps;
   void prepareForIcon(QPainter& painter);
 
@@ -17,12 +17,14 @@
 
 #include "common/coordinateconverter.h"
 #include "common/textplacement.h"
+#include "common/labelplacement.h"
 
 #include "geo/line.h"
 #include "geo/calculations.h"
 #include "geo/linestring.h"
 
 #include <QPainter>
+#include <QTransform>
 
 using atools::geo::Line;
 using atools::geo::Pos;
@@ -135,10 +137,6 @@ void TextPlacement::drawTextAlongOneLine(const QString& text, float bearing,
     // Draw text
     QFontMetricsF metrics = painter->fontMetrics();
 
-    // Both points are visible - cut text for full line length
-    if(bothVisible)
-      newText = metrics.elidedText(newText, elide, textLineLength);
-
     float yoffset;
     if(textOnTopOfLine || bearing >= 180.)
       // Keep all texts north
@@ -146,6 +144,24 @@ void TextPlacement::drawTextAlongOneLine(const QString& text, float bearing,
     else
       yoffset = metrics.ascent() + lineWidth / 2.f + 2.f;
 
+    if(labelPlacement != nullptr)
+    {
+      // Check estimated size before doing any text layout - elided text is not longer than the line
+      float width = static_cast<float>(newText.length() * metrics.averageCharWidth());
+      if(bothVisible)
+        width = std::min(width, static_cast<float>(textLineLength));
+
+      float centerOffset = yoffset - static_cast<float>(metrics.ascent() - metrics.descent()) / 2.f;
+      QPointF center = textCoord + QTransform().rotate(rotate).map(QPointF(0., centerOffset));
+      if(!labelPlacement->place(LabelPlacement::rotatedRect(center, width, static_cast<float>(metrics.height()),
+                                                            rotate), labelPriority))
+        return;
+    }
+
+    // Both points are visible - cut text for full line length
+    if(bothVisible)
+      newText = metrics.elidedText(newText, elide, textLineLength);
+
     painter->translate(textCoord.x(), textCoord.y());
     painter->rotate(rotate);
 
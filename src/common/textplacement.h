@@ -36,6 +36,7 @@ class Pos;
 
 class QPainter;
 class CoordinateConverter;
+class LabelPlacement;
 
 /* Contains methods for text placement along line strings. */
 class TextPlacement
@@ -127,6 +128,13 @@ public:
     lineWidth = value;
   }
 
+  /* Skip texts overlapping other labels with the same or higher priority. Null draws all texts. */
+  void setLabelPlacement(LabelPlacement *placement, int priority)
+  {
+    labelPlacement = placement;
+    labelPriority = priority;
+  }
+
   /* Set an array of colors with the same size as lines in calculateTextAlongLines */
   void setColors(const QVector<QColor>& value)
   {
@@ -156,6 +164,8 @@ private:
   float lineWidth = 10.f;
   QVector<QColor> colors;
   QVector<QColor> colors2;
+  LabelPlacement *labelPlacement = nullptr;
+  int labelPriority = 0;
 };
 
 #endif // LITTLENAVMAP_TEXTPLACEMENT_H
@@ -0,0 +1,547 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+
+#include "common/trackjournal.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtEndian>
+
+#include <cmath>
+
+using atools::geo::Pos;
+using at::AircraftTrackPos;
+
+namespace  {
+
+const quint32 FILE_MAGIC_NUMBER = 0x5B6C1A2B;
+
+/* Version 2 is a full list written at shutdown. Version 3 is the journal. */
+const quint16 LEGACY_FILE_VERSION = 2;
+const quint16 FILE_VERSION = 3;
+
+/* Magic number and version */
+const int HEADER_SIZE = 6;
+
+/* "JB" - marker, position count, payload size and checksum */
+const quint16 BLOCK_MARKER = 0x4A42;
+const int BLOCK_HEADER_SIZE = 10;
+
+/* Coordinates are stored as millionth degree which is about 0.1 meter. Altitude is stored in feet. */
+const double COORD_FACTOR = 1000000.;
+
+void writeVarint(QByteArray& out, quint64 value)
+{
+  while(value >= 0x80)
+  {
+    out.append(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.append(static_cast<char>(value));
+}
+
+bool readVarint(const char *& data, const char *end, quint64& value)
+{
+  value = 0;
+  int shift = 0;
+  while(data < end && shift < 64)
+  {
+    quint8 byte = static_cast<quint8>(*data++);
+    value |= static_cast<quint64>(byte & 0x7f) << shift;
+    if(!(byte & 0x80))
+      return true;
+
+    shift += 7;
+  }
+  return false;
+}
+
+/* Map signed to unsigned values so that small negative numbers result in short varints */
+quint64 zigzag(qint64 value)
+{
+  return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+qint64 unzigzag(quint64 value)
+{
+  return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+
+}
+
+TrackJournal::TrackJournal()
+{
+
+}
+
+TrackJournal::~TrackJournal()
+{
+  close();
+}
+
+void TrackJournal::open(const QString& filenameParam, QVector<AircraftTrackPos>& positions)
+{
+  close();
+  filename = filenameParam;
+  numFilePositions = 0;
+  pending.clear();
+
+  // Size of the valid part of the file or -1 if the file has to be written again
+  qint64 validSize = -1;
+  bool legacy = false;
+
+  QFile in(filename);
+  if(in.exists())
+  {
+    if(in.open(QIODevice::ReadOnly))
+    {
+      // Map file into memory if possible to avoid copying
+      qint64 size = in.size();
+      uchar *mapped = size > 0 ? in.map(0, size) : nullptr;
+      QByteArray data = mapped != nullptr ?
+                        QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), static_cast<int>(size)) :
+                        in.readAll();
+
+      quint32 magic = 0;
+      quint16 version = 0;
+      if(data.size() >= HEADER_SIZE)
+      {
+        magic = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(data.constData()));
+        version = qFromBigEndian<quint16>(reinterpret_cast<const uchar *>(data.constData() + 4));
+      }
+
+      if(magic == FILE_MAGIC_NUMBER && version == FILE_VERSION)
+      {
+        validSize = decodeBlocks(data, HEADER_SIZE, positions);
+        numFilePositions = positions.size();
+
+        if(validSize < data.size())
+          qWarning() << "Track" << filename << "truncated or corrupted at" << validSize << "of" << data.size();
+      }
+      else if(magic == FILE_MAGIC_NUMBER && version == LEGACY_FILE_VERSION)
+      {
+        decodeLegacy(data, positions);
+        legacy = true;
+      }
+      else if(data.size() > 0)
+        qWarning() << "Cannot read track" << filename << ". Invalid magic number or version:" << magic << version;
+
+      if(mapped != nullptr)
+        in.unmap(mapped);
+      in.close();
+    }
+    else
+      qWarning() << "Cannot read track" << filename << ":" << in.errorString();
+  }
+
+  if(legacy)
+  {
+    // Convert once - old file is kept if this fails
+    QSaveFile out(filename);
+    if(writeFile(&out, {positions}) && out.commit())
+      numFilePositions = positions.size();
+    else
+      qWarning() << "Cannot convert track" << filename << ":" << out.errorString();
+  }
+  else if(validSize >= HEADER_SIZE)
+  {
+    // Cut off incomplete block left by a crash so that new blocks can be appended
+    if(validSize < QFile(filename).size() && !QFile::resize(filename, validSize))
+      qWarning() << "Cannot truncate track" << filename;
+  }
+  else
+    QFile::remove(filename);
+
+  openForAppend();
+}
+
+void TrackJournal::close()
+{
+  checkCompaction(true);
+  flush();
+
+  if(file.isOpen())
+    file.close();
+}
+
+void TrackJournal::append(const AircraftTrackPos& trackPos)
+{
+  pending.append(trackPos);
+
+  if(pending.size() >= BLOCK_SIZE)
+    flush();
+}
+
+void TrackJournal::flush()
+{
+  checkCompaction(false);
+
+  // Keep positions until file is opened
+  if(pending.isEmpty() || !file.isOpen())
+    return;
+
+  if(writeBlocks(file, pending))
+  {
+    numFilePositions += pending.size();
+
+    if(compacting)
+      // Not contained in the snapshot - have to be added to the new file
+      compactPending += pending;
+  }
+  else
+    qWarning() << "Cannot write track" << filename << ":" << file.errorString();
+
+  pending.clear();
+}
+
+void TrackJournal::clear()
+{
+  pending.clear();
+  compactPending.clear();
+  if(compacting)
+    compactCancelled = true;
+
+  numFilePositions = 0;
+
+  if(!filename.isEmpty())
+  {
+    file.close();
+    QFile::remove(filename);
+    openForAppend();
+  }
+}
+
+void TrackJournal::compact(const QVector<QVector<AircraftTrackPos> >& positions)
+{
+  checkCompaction(false);
+
+  if(compacting || filename.isEmpty())
+    return;
+
+  // Write pending positions to the old file since they are contained in the snapshot
+  flush();
+
+  compactNumPositions = 0;
+  for(const QVector<AircraftTrackPos>& block : positions)
+    compactNumPositions += block.size();
+
+  qDebug() << Q_FUNC_INFO << "Compacting" << filename << "from" << numFilePositions << "to" << compactNumPositions;
+
+  compacting = true;
+  compactCancelled = false;
+  compactPending.clear();
+  compactFile = new QSaveFile(filename);
+  compactFuture = QtConcurrent::run(&TrackJournal::writeFile, compactFile, positions);
+}
+
+void TrackJournal::checkCompaction(bool wait)
+{
+  if(!compacting)
+    return;
+
+  if(wait)
+    compactFuture.waitForFinished();
+  else if(!compactFuture.isFinished())
+    return;
+
+  compacting = false;
+
+  // Add positions which were written to the old file in the meantime
+  if(compactFuture.result() && !compactCancelled && writeBlocks(*compactFile, compactPending))
+  {
+    // Replace the old file in one step - old file is kept if this fails
+    file.close();
+    if(compactFile->commit())
+      numFilePositions = compactNumPositions + compactPending.size();
+    else
+      qWarning() << "Cannot replace track" << filename << ":" << compactFile->errorString();
+    openForAppend();
+  }
+  else
+  {
+    if(!compactCancelled)
+      qWarning() << "Cannot write track" << filename << ":" << compactFile->errorString();
+    compactFile->cancelWriting();
+  }
+
+  delete compactFile;
+  compactFile = nullptr;
+  compactPending.clear();
+}
+
+bool TrackJournal::openForAppend()
+{
+  file.setFileName(filename);
+  bool hasHeader = file.size() >= HEADER_SIZE;
+
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Append))
+  {
+    qWarning() << "Cannot open track" << filename << ":" << file.errorString();
+    return false;
+  }
+
+  if(!hasHeader)
+  {
+    file.resize(0);
+    return writeHeader(file);
+  }
+  return true;
+}
+
+bool TrackJournal::writeFile(QSaveFile *out, QVector<QVector<AircraftTrackPos> > positions)
+{
+  if(!out->open(QIODevice::WriteOnly))
+    return false;
+
+  if(!writeHeader(*out))
+    return false;
+
+  for(const QVector<AircraftTrackPos>& block : positions)
+  {
+    if(!writeBlocks(*out, block))
+      return false;
+  }
+  return true;
+}
+
+bool TrackJournal::writeHeader(QFileDevice& out)
+{
+  uchar header[HEADER_SIZE];
+  qToBigEndian<quint32>(FILE_MAGIC_NUMBER, header);
+  qToBigEndian<quint16>(FILE_VERSION, header + 4);
+  return out.write(reinterpret_cast<const char *>(header), HEADER_SIZE) == HEADER_SIZE && out.flush();
+}
+
+bool TrackJournal::writeBlocks(QFileDevice& out, const QVector<AircraftTrackPos>& positions)
+{
+  for(int i = 0; i < positions.size(); i += BLOCK_SIZE)
+  {
+    QByteArray block = encodeBlock(positions.constData() + i, std::min(BLOCK_SIZE, positions.size() - i));
+    if(out.write(block) != block.size())
+      return false;
+  }
+
+  // Hand over to the operating system so that the data survives a crash of the program
+  return out.flush();
+}
+
+QByteArray TrackJournal::encodeBlock(const AircraftTrackPos *positions, int num)
+{
+  QByteArray payload;
+  payload.reserve(num * 12);
+
+  qint64 lastLon = 0, lastLat = 0, lastAlt = 0, lastTime = 0;
+  for(int i = 0; i < num; i++)
+  {
+    const AircraftTrackPos& trackPos = positions[i];
+    qint64 lon = std::llround(trackPos.pos.getLonX() * COORD_FACTOR);
+    qint64 lat = std::llround(trackPos.pos.getLatY() * COORD_FACTOR);
+    qint64 alt = std::llround(trackPos.pos.getAltitude());
+    qint64 time = trackPos.timestamp;
+
+    writeVarint(payload, zigzag(lon - lastLon));
+    writeVarint(payload, zigzag(lat - lastLat));
+    writeVarint(payload, zigzag(alt - lastAlt));
+    // Ground flag in lowest bit
+    writeVarint(payload, (zigzag(time - lastTime) << 1) | (trackPos.onGround ? 1 : 0));
+
+    lastLon = lon;
+    lastLat = lat;
+    lastAlt = alt;
+    lastTime = time;
+  }
+
+  uchar header[BLOCK_HEADER_SIZE];
+  qToBigEndian<quint16>(BLOCK_MARKER, header);
+  qToBigEndian<quint16>(static_cast<quint16>(num), header + 2);
+  qToBigEndian<quint32>(static_cast<quint32>(payload.size()), header + 4);
+  qToBigEndian<quint16>(qChecksum(payload.constData(), static_cast<uint>(payload.size())), header + 8);
+
+  return QByteArray(reinterpret_cast<const char *>(header), BLOCK_HEADER_SIZE) + payload;
+}
+
+void TrackJournal::decodeLegacy(const QByteArray& data, QVector<AircraftTrackPos>& positions)
+{
+  // Full list of positions
+  QDataStream stream(data);
+  stream.setVersion(QDataStream::Qt_5_5);
+  stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  quint32 magic = 0, num = 0;
+  quint16 version = 0;
+  stream >> magic >> version >> num;
+
+  AircraftTrackPos trackPos;
+  for(quint32 i = 0; i < num && stream.status() == QDataStream::Ok; i++)
+  {
+    stream >> trackPos;
+    positions.append(trackPos);
+  }
+}
+
+int TrackJournal::decodeBlocks(const QByteArray& data, int offset, QVector<AircraftTrackPos>& positions)
+{
+  const char *base = data.constData();
+  int size = data.size();
+
+  while(offset + BLOCK_HEADER_SIZE <= size)
+  {
+    const uchar *header = reinterpret_cast<const uchar *>(base + offset);
+    if(qFromBigEndian<quint16>(header) != BLOCK_MARKER)
+      break;
+
+    int num = qFromBigEndian<quint16>(header + 2);
+    quint32 payloadSize = qFromBigEndian<quint32>(header + 4);
+    quint16 checksum = qFromBigEndian<quint16>(header + 8);
+
+    // Incomplete block
+    if(payloadSize > static_cast<quint32>(size - offset - BLOCK_HEADER_SIZE))
+      break;
+
+    const char *payload = base + offset + BLOCK_HEADER_SIZE;
+    if(qChecksum(payload, payloadSize) != checksum)
+      break;
+
+    const char *cur = payload, *end = payload + payloadSize;
+    qint64 lon = 0, lat = 0, alt = 0, time = 0;
+    QVector<AircraftTrackPos> block;
+    block.reserve(num);
+
+    bool ok = true;
+    for(int i = 0; i < num && ok; i++)
+    {
+      quint64 dLon, dLat, dAlt, dTime;
+      ok = readVarint(cur, end, dLon) && readVarint(cur, end, dLat) &&
+           readVarint(cur, end, dAlt) && readVarint(cur, end, dTime);
+
+      if(ok)
+      {
+        lon += unzigzag(dLon);
+        lat += unzigzag(dLat);
+        alt += unzigzag(dAlt);
+        time += unzigzag(dTime >> 1);
+
+        block.append({Pos(static_cast<float>(lon / COORD_FACTOR), static_cast<float>(lat / COORD_FACTOR),
+                          static_cast<float>(alt)), static_cast<quint32>(time), (dTime & 1) != 0});
+      }
+    }
+
+    if(!ok)
+      break;
+
+    positions += block;
+    offset += BLOCK_HEADER_SIZE + static_cast<int>(payloadSize);
+  }
+  return offset;
+}
+
+bool TrackJournal::checkFormat()
+{
+  // Three full blocks and a partial one crossing the anti-meridian, equator and zero altitude
+  QVector<AircraftTrackPos> positions;
+  for(int i = 0; i < BLOCK_SIZE * 3 + 5; i++)
+    positions.append({Pos(179.99f - i * 0.37f, 0.5f - i * 0.013f, 250.f - i * 10.3f),
+                      static_cast<quint32>(1500000000 + i * 3), i % 7 == 0});
+
+  // Positions as expected after decoding with reduced precision
+  QVector<AircraftTrackPos> expected;
+  for(const AircraftTrackPos& trackPos : positions)
+  {
+    float lon = static_cast<float>(std::llround(trackPos.pos.getLonX() * COORD_FACTOR) / COORD_FACTOR);
+    float lat = static_cast<float>(std::llround(trackPos.pos.getLatY() * COORD_FACTOR) / COORD_FACTOR);
+    float alt = static_cast<float>(std::llround(trackPos.pos.getAltitude()));
+    expected.append({Pos(lon, lat, alt), trackPos.timestamp, trackPos.onGround});
+  }
+
+  auto equal = [](const QVector<AircraftTrackPos>& list1, const QVector<AircraftTrackPos>& list2,
+                  int num) -> bool
+               {
+                 if(list1.size() != num || list2.size() < num)
+                   return false;
+
+                 for(int i = 0; i < num; i++)
+                 {
+                   const AircraftTrackPos& p1 = list1.at(i), & p2 = list2.at(i);
+                   if(p1.pos.getLonX() != p2.pos.getLonX() || p1.pos.getLatY() != p2.pos.getLatY() ||
+                      p1.pos.getAltitude() != p2.pos.getAltitude() || p1.timestamp != p2.timestamp ||
+                      p1.onGround != p2.onGround)
+                     return false;
+                 }
+                 return true;
+               };
+
+  QByteArray data;
+  QVector<int> blockEnds;
+  for(int i = 0; i < positions.size(); i += BLOCK_SIZE)
+  {
+    data += encodeBlock(positions.constData() + i, std::min(BLOCK_SIZE, positions.size() - i));
+    blockEnds.append(data.size());
+  }
+  int lastComplete = positions.size() / BLOCK_SIZE * BLOCK_SIZE;
+  bool ok = true;
+
+  // Round trip
+  QVector<AircraftTrackPos> decoded;
+  if(decodeBlocks(data, 0, decoded) != data.size() || !equal(decoded, expected, expected.size()))
+  {
+    qWarning() << Q_FUNC_INFO << "Round trip failed";
+    ok = false;
+  }
+
+  // Truncated last block has to be cut off
+  decoded.clear();
+  if(decodeBlocks(data.left(data.size() - 3), 0, decoded) != blockEnds.at(blockEnds.size() - 2) ||
+     !equal(decoded, expected, lastComplete))
+  {
+    qWarning() << Q_FUNC_INFO << "Truncated tail not recovered";
+    ok = false;
+  }
+
+  // Corrupted last block fails the checksum and has to be cut off
+  QByteArray corrupted(data);
+  corrupted[data.size() - 2] = static_cast<char>(corrupted.at(data.size() - 2) ^ 0x55);
+  decoded.clear();
+  if(decodeBlocks(corrupted, 0, decoded) != blockEnds.at(blockEnds.size() - 2) ||
+     !equal(decoded, expected, lastComplete))
+  {
+    qWarning() << Q_FUNC_INFO << "Corrupted tail not recovered";
+    ok = false;
+  }
+
+  // Old format is read without loss
+  QByteArray legacy;
+  QDataStream stream(&legacy, QIODevice::WriteOnly);
+  stream.setVersion(QDataStream::Qt_5_5);
+  stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  stream << FILE_MAGIC_NUMBER << LEGACY_FILE_VERSION << static_cast<quint32>(positions.size());
+  for(const AircraftTrackPos& trackPos : positions)
+    stream << trackPos;
+
+  decoded.clear();
+  decodeLegacy(legacy, decoded);
+  if(!equal(decoded, positions, positions.size()))
+  {
+    qWarning() << Q_FUNC_INFO << "Conversion of version" << LEGACY_FILE_VERSION << "failed";
+    ok = false;
+  }
+
+  return ok;
+}
@@ -0,0 +1,119 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_TRACKJOURNAL_H
+#define LITTLENAVMAP_TRACKJOURNAL_H
+
+#include "common/aircrafttrack.h"
+
+#include <QFile>
+#include <QFuture>
+
+class QSaveFile;
+
+/*
+ * Append only file for the aircraft track which survives application crashes except for the last partial block.
+ *
+ * Positions are collected and written in small blocks. Each block has a marker, position count,
+ * payload size and checksum. The payload contains coordinates, altitude and time as varint encoded
+ * differences to the previous position. The first position in a block is stored relative to zero
+ * so that each block can be decoded on its own.
+ *
+ * Blocks are handed to the operating system once written but not synced to disk. An application crash loses
+ * up to BLOCK_SIZE - 1 positions still pending in memory and a partially written last block. A system crash
+ * or power loss can lose more.
+ *
+ * A truncated or corrupted block at the end of the file, which can be left by a crash, is cut off when
+ * reading. Positions removed from the track stay in the file until it is compacted. Compaction rewrites the
+ * file in a background thread and replaces the old one atomically once finished. The old file is kept if
+ * writing or replacing fails.
+ *
+ * Files of the previous full rewrite format (version 2) are read and converted.
+ */
+class TrackJournal
+{
+public:
+  TrackJournal();
+  ~TrackJournal();
+
+  /* Read all positions from the file and keep it open for appending. Creates the file if it does not exist
+   * and converts files of the old format. */
+  void open(const QString& filenameParam, QVector<at::AircraftTrackPos>& positions);
+
+  /* Write pending positions and wait for a running compaction */
+  void close();
+
+  /* Queue position. Written once BLOCK_SIZE positions are pending. */
+  void append(const at::AircraftTrackPos& trackPos);
+
+  /* Write all pending positions */
+  void flush();
+
+  /* Truncate file and drop pending positions */
+  void clear();
+
+  /* Rewrite the file containing only the given blocks of positions in a background thread.
+   * Implicitly shared blocks can be passed without copying the positions. */
+  void compact(const QVector<QVector<at::AircraftTrackPos> >& positions);
+
+  /* Positions in file including pending ones. Used to decide when compaction is needed. */
+  int getNumPositions() const
+  {
+    return numFilePositions + pending.size();
+  }
+
+  /* Number of positions in one block */
+  static Q_DECL_CONSTEXPR int BLOCK_SIZE = 16;
+
+  /* Encode and decode sample positions in memory and log any difference. Checks round trip, cutting off
+   * truncated and corrupted tail blocks and conversion of the old format. Returns true if all passed. */
+  static bool checkFormat();
+
+private:
+  /* Finish compaction if the background thread is done. Waits for it if wait is true. */
+  void checkCompaction(bool wait);
+
+  bool openForAppend();
+
+  /* Background thread function writing a complete file without committing it */
+  static bool writeFile(QSaveFile *out, QVector<QVector<at::AircraftTrackPos> > positions);
+  static bool writeHeader(QFileDevice& out);
+  static bool writeBlocks(QFileDevice& out, const QVector<at::AircraftTrackPos>& positions);
+  static QByteArray encodeBlock(const at::AircraftTrackPos *positions, int num);
+
+  /* Decode all blocks in data and return the size of the valid part */
+  static int decodeBlocks(const QByteArray& data, int offset, QVector<at::AircraftTrackPos>& positions);
+
+  /* Decode a complete file of the previous format (version 2) including header */
+  static void decodeLegacy(const QByteArray& data, QVector<at::AircraftTrackPos>& positions);
+
+  QString filename;
+  QFile file;
+  int numFilePositions = 0;
+  QVector<at::AircraftTrackPos> pending;
+
+  /* Compaction state. Positions written to the old file while compacting are added to the new one.
+   * compactFile replaces the journal on commit and is used by the background thread while compacting. */
+  QSaveFile *compactFile = nullptr;
+  QFuture<bool> compactFuture;
+  bool compacting = false, compactCancelled = false;
+  int compactNumPositions = 0;
+  QVector<at::AircraftTrackPos> compactPending;
+};
+
+#endif // LITTLENAVMAP_TRACKJOURNAL_H
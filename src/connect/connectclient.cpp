@@ -22,6 +22,10 @@
 #include "connect/connectdialog.h"
 #include "fs/sc/simconnectreply.h"
 #include "fs/sc/datareaderthread.h"
+#include "connect/simdatahub.h"
+#include "connect/simdatarecorder.h"
+#include "connect/simdatagenerator.h"
+#include "connect/simdatacodec.h"
 #include "gui/dialog.h"
 #include "gui/errorhandler.h"
 #include "gui/mainwindow.h"
@@ -41,6 +45,24 @@ ConnectClient::ConnectClient(MainWindow *parent)
 {
   atools::settings::Settings& settings = atools::settings::Settings::instance();
   verbose = settings.getAndStoreValue(lnm::OPTIONS_CONNECTCLIENT_DEBUG, false).toBool();
+  // Off until Little Navconnect implements the delta format
+  deltaFormat = settings.getAndStoreValue(lnm::OPTIONS_CONNECTCLIENT_DELTA_FORMAT, false).toBool();
+  deltaDecoder = new SimDataDecoder;
+
+  simDataHub = new SimDataHub(this);
+  connect(this, &ConnectClient::disconnectedFromSimulator, simDataHub, &SimDataHub::clear);
+  connect(this, &ConnectClient::weatherPacketReceived, this, &ConnectClient::updateMetars, Qt::QueuedConnection);
+
+  recorder = new SimDataRecorder;
+
+  // Replay uses the same path as the data reader
+  replay = new SimDataReplay(this);
+  connect(replay, &SimDataReplay::postSimConnectData, this, &ConnectClient::postSimConnectDataDirect);
+  connect(replay, &SimDataReplay::finished, this, &ConnectClient::replayFinished);
+
+  generator = new SimDataGenerator(this);
+  connect(generator, &SimDataGenerator::postSimConnectData, this, &ConnectClient::postSimConnectDataDirect);
+  connect(generator, &SimDataGenerator::finished, this, &ConnectClient::trafficGeneratorFinished);
 
   DataReaderThread *dr =
     new DataReaderThread(mainWindow, settings.getAndStoreValue(lnm::OPTIONS_DATAREADER_DEBUG, false).toBool());
@@ -50,7 +72,9 @@ ConnectClient::ConnectClient(MainWindow *parent)
     dataReader = dr;
     dataReader->setReconnectRateSec(DIRECT_RECONNECT_SEC);
 
-    connect(dataReader, &DataReaderThread::postSimConnectData, this, &ConnectClient::postSimConnectData);
+    // Called in the reader thread to avoid queuing each packet into the event loop
+    connect(dataReader, &DataReaderThread::postSimConnectData, this, &ConnectClient::postSimConnectDataDirect,
+            Qt::DirectConnection);
     connect(dataReader, &DataReaderThread::postLogMessage, this, &ConnectClient::postLogMessage);
     connect(dataReader, &DataReaderThread::connectedToSimulator, this, &ConnectClient::connectedToSimulatorDirect);
     connect(dataReader, &DataReaderThread::disconnectedFromSimulator, this,
@@ -86,6 +110,10 @@ ConnectClient::~ConnectClient()
   qDebug() << Q_FUNC_INFO << "delete dataReader";
   delete dataReader;
 
+  // Delete after reader thread is stopped
+  delete recorder;
+  delete deltaDecoder;
+
   qDebug() << Q_FUNC_INFO << "delete dialog";
   delete dialog;
 }
@@ -171,11 +199,33 @@ void ConnectClient::disconnectedFromSimulatorDirect()
   manualDisconnect = false;
 }
 
-/* Posts data received directly from simconnect or the socket and caches any metar reports */
+/* Posts data received from the socket and caches any metar reports */
 void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData dataPacket)
 {
-  emit dataPacketReceived(dataPacket);
+  recorder->write(dataPacket);
+
+  // Weather replies do not contain aircraft
+  if(dataPacket.getPacketId() > 0 || dataPacket.getMetars().isEmpty())
+    simDataHub->post(dataPacket);
+
+  updateMetars(dataPacket);
+}
 
+/* Posts data received directly from simconnect. Called in the data reader thread. */
+void ConnectClient::postSimConnectDataDirect(atools::fs::sc::SimConnectData dataPacket)
+{
+  recorder->write(dataPacket);
+
+  if(dataPacket.getPacketId() > 0 || dataPacket.getMetars().isEmpty())
+    simDataHub->post(dataPacket);
+
+  if(!dataPacket.getMetars().isEmpty())
+    // Pass to the GUI thread
+    emit weatherPacketReceived(dataPacket);
+}
+
+void ConnectClient::updateMetars(const atools::fs::sc::SimConnectData& dataPacket)
+{
   if(!dataPacket.getMetars().isEmpty())
   {
     if(verbose)
@@ -186,7 +236,7 @@ void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData dataPacket
       QString ident = metar.requestIdent;
       if(verbose)
       {
-        qDebug() << "ConnectClient::postSimConnectData metar ident to cache ident"
+        qDebug() << "ConnectClient::updateMetars metar ident to cache ident"
                  << ident << "pos" << metar.requestPos.toString();
         qDebug() << "Station" << metar.metarForStation;
         qDebug() << "Nearest" << metar.metarForNearest;
@@ -372,12 +422,157 @@ void ConnectClient::connectInternal()
 
 bool ConnectClient::isConnected() const
 {
+  if(replay->isActive() || generator->isActive())
+    return true;
+
   if(dataReader != nullptr)
     return (socket != nullptr && socket->isOpen()) || dataReader->isConnected();
   else
     return socket != nullptr && socket->isOpen();
 }
 
+bool ConnectClient::startRecording(const QString& filename)
+{
+  // Do not write replayed or generated data into a new recording
+  if(replay->isActive() || generator->isActive())
+  {
+    QMessageBox::warning(mainWindow, QApplication::applicationName(),
+                         tr("Stop the replay or traffic generator before recording simulator data."));
+    return false;
+  }
+
+  if(!recorder->open(filename))
+  {
+    QMessageBox::warning(mainWindow, QApplication::applicationName(),
+                         tr("Cannot create simulator data recording \"%1\": %2").
+                         arg(filename).arg(recorder->getErrorString()));
+    return false;
+  }
+  return true;
+}
+
+void ConnectClient::stopRecording()
+{
+  recorder->close();
+}
+
+bool ConnectClient::isRecording() const
+{
+  return recorder->isOpen();
+}
+
+bool ConnectClient::startReplay(const QString& filename, int speed)
+{
+  if(isConnected())
+  {
+    QMessageBox::warning(mainWindow, QApplication::applicationName(),
+                         tr("Disconnect from the simulator before replaying a recording."));
+    return false;
+  }
+
+  if(isRecording())
+  {
+    QMessageBox::warning(mainWindow, QApplication::applicationName(),
+                         tr("Stop recording simulator data before replaying a recording."));
+    return false;
+  }
+
+  if(!replay->start(filename, speed))
+  {
+    QMessageBox::warning(mainWindow, QApplication::applicationName(),
+                         tr("Cannot replay simulator data recording \"%1\": %2").
+                         arg(filename).arg(replay->getErrorString()));
+    return false;
+  }
+
+  mainWindow->setConnectionStatusMessageText(tr("Replay"), tr("Replaying simulator data from \"%1\".").
+                                             arg(filename));
+  emit connectedToSimulator();
+  emit weatherUpdated();
+  return true;
+}
+
+void ConnectClient::stopReplay()
+{
+  replay->stop();
+}
+
+bool ConnectClient::isReplaying() const
+{
+  return replay->isActive();
+}
+
+bool ConnectClient::startTrafficGenerator(const QVector<atools::geo::Pos>& airports, int numAircraft)
+{
+  if(isConnected())
+  {
+    QMessageBox::warning(mainWindow, QApplication::applicationName(),
+                         tr("Disconnect from the simulator before generating traffic."));
+    return false;
+  }
+
+  if(isRecording())
+  {
+    QMessageBox::warning(mainWindow, QApplication::applicationName(),
+                         tr("Stop recording simulator data before generating traffic."));
+    return false;
+  }
+
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  generator->start(airports, numAircraft,
+                   settings.getAndStoreValue(lnm::OPTIONS_TRAFFIC_GENERATOR_UPDATE_MS, 200).toInt());
+
+  if(generator->isActive())
+  {
+    mainWindow->setConnectionStatusMessageText(tr("Traffic"), tr("Generating %1 AI aircraft.").arg(numAircraft));
+    emit connectedToSimulator();
+    emit weatherUpdated();
+  }
+  return generator->isActive();
+}
+
+void ConnectClient::stopTrafficGenerator()
+{
+  generator->stop();
+}
+
+bool ConnectClient::isTrafficGeneratorActive() const
+{
+  return generator->isActive();
+}
+
+void ConnectClient::trafficGeneratorFinished()
+{
+  qDebug() << Q_FUNC_INFO << "packets" << generator->getNumPackets();
+
+  mainWindow->setConnectionStatusMessageText(tr("Disconnected"), tr("Traffic generator stopped."));
+
+  if(!NavApp::isShuttingDown())
+  {
+    emit disconnectedFromSimulator();
+    emit weatherUpdated();
+  }
+}
+
+void ConnectClient::replayFinished()
+{
+  qDebug() << Q_FUNC_INFO << replay->getErrorString();
+
+  mainWindow->setConnectionStatusMessageText(tr("Disconnected"), tr("Simulator data replay finished."));
+
+  metarIdentCache.clear();
+
+  if(!replay->getErrorString().isEmpty())
+    QMessageBox::warning(mainWindow, QApplication::applicationName(),
+                         tr("Error replaying simulator data: %1").arg(replay->getErrorString()));
+
+  if(!NavApp::isShuttingDown())
+  {
+    emit disconnectedFromSimulator();
+    emit weatherUpdated();
+  }
+}
+
 bool ConnectClient::isSimConnectAvailable() const
 {
   if(dataReader != nullptr)
@@ -524,6 +719,17 @@ void ConnectClient::connectedToServerSocket()
 
   silent = false;
 
+  deltaDecoder->reset();
+  if(deltaFormat)
+  {
+    // Server answers with delta frames if it knows the command - otherwise plain packets continue to arrive
+    atools::fs::sc::SimConnectReply reply;
+    reply.setCommand(simcodec::CMD_REQUEST_DELTA_FORMAT);
+    writeReplyToSocket(reply);
+    if(socket == nullptr)
+      return;
+  }
+
   dialog->setConnected(isConnected());
 
   // Let other program parts know about the new connection
@@ -538,6 +744,39 @@ void ConnectClient::readFromSocket()
   {
     if(verbose)
       qDebug() << "readFromSocket" << socket->bytesAvailable();
+    if(simConnectData == nullptr && deltaFormat && socket->bytesAvailable() < simcodec::HEADER_SIZE)
+      // Need the magic number to detect the packet format
+      return;
+
+    if(simConnectData == nullptr && deltaFormat && SimDataDecoder::isFrame(socket))
+    {
+      // Start of a compressed delta frame - read it as a whole once complete
+      atools::fs::sc::SimConnectData data;
+      if(!deltaDecoder->read(socket, data))
+      {
+        if(deltaDecoder->hasError())
+        {
+          QMessageBox::critical(mainWindow, QApplication::applicationName(),
+                                QString(tr("Error reading data from Little Navconnect: %1.")).
+                                arg(deltaDecoder->getErrorString()));
+          closeSocket(false);
+        }
+        return;
+      }
+
+      if(data.getPacketId() > 0)
+      {
+        atools::fs::sc::SimConnectReply reply;
+        reply.setPacketId(data.getPacketId());
+        writeReplyToSocket(reply);
+        if(socket == nullptr)
+          return;
+      }
+
+      postSimConnectData(data);
+      continue;
+    }
+
     if(simConnectData == nullptr)
       // Need to keep the data in background since this method can be called multiple times until the data is filled
       simConnectData = new atools::fs::sc::SimConnectData;
@@ -28,6 +28,11 @@
 class QTcpSocket;
 class ConnectDialog;
 class MainWindow;
+class SimDataHub;
+class SimDataRecorder;
+class SimDataReplay;
+class SimDataGenerator;
+class SimDataDecoder;
 
 namespace atools {
 namespace fs {
@@ -42,8 +47,10 @@ class SimConnectReply;
 }
 
 /*
- * Client for the Little Navconnect Simconnect agent/server. Receives data and passes it around by emitting a signal.
- * Does not use multithreading - runs completely in the event loop.
+ * Client for the Little Navconnect Simconnect agent/server. Receives data and passes it to the SimDataHub which
+ * distributes it to all consumers.
+ * Socket connections run completely in the event loop. Data from the direct connection is written to the hub
+ * from the reader thread.
  */
 class ConnectClient :
   public QObject
@@ -70,9 +77,33 @@ public:
 
   atools::fs::sc::MetarResult requestWeather(const QString& station, const atools::geo::Pos& pos);
 
+  /* Distributes all received simulator data */
+  SimDataHub *getSimDataHub() const
+  {
+    return simDataHub;
+  }
+
+  /* Record all received packets into a file. Shows an error dialog and returns false on failure or if
+   * a replay or the traffic generator is active. */
+  bool startRecording(const QString& filename);
+  void stopRecording();
+  bool isRecording() const;
+
+  /* Replay a recording as if received from the simulator. speed is the factor for the recorded times or
+   * 0 to replay as fast as possible. Shows an error dialog and returns false on failure or while recording. */
+  bool startReplay(const QString& filename, int speed);
+  void stopReplay();
+  bool isReplaying() const;
+
+  /* Generate numAircraft synthetic AI aircraft around the given airport positions instead of connecting to
+   * a simulator. Returns false if already connected or recording. */
+  bool startTrafficGenerator(const QVector<atools::geo::Pos>& airports, int numAircraft);
+  void stopTrafficGenerator();
+  bool isTrafficGeneratorActive() const;
+
 signals:
-  /* Emitted when a new SimConnect data was received from the server (Little Navconnect) */
-  void dataPacketReceived(atools::fs::sc::SimConnectData simConnectData);
+  /* Internal. Emitted from the reader thread for packets containing weather data */
+  void weatherPacketReceived(atools::fs::sc::SimConnectData simConnectData);
 
   /* Emitted when a new SimConnect data was received that contains weather data */
   void weatherUpdated();
@@ -96,6 +127,8 @@ private:
   void writeReplyToSocket(atools::fs::sc::SimConnectReply& reply);
   void disconnectClicked();
   void postSimConnectData(atools::fs::sc::SimConnectData dataPacket);
+  void postSimConnectDataDirect(atools::fs::sc::SimConnectData dataPacket);
+  void updateMetars(const atools::fs::sc::SimConnectData& dataPacket);
   void postLogMessage(QString message, bool warning);
   void connectedToSimulatorDirect();
   void disconnectedFromSimulatorDirect();
@@ -103,6 +136,8 @@ private:
   void requestWeather(const atools::fs::sc::WeatherRequest& weatherRequest);
   void flushQueuedRequests();
   void fetchOptionsToDataReader();
+  void replayFinished();
+  void trafficGeneratorFinished();
 
   bool silent = false, manualDisconnect = false;
   ConnectDialog *dialog = nullptr;
@@ -110,6 +145,16 @@ private:
   /* Does automatic reconnect */
   atools::fs::sc::DataReaderThread *dataReader = nullptr;
 
+  SimDataHub *simDataHub = nullptr;
+  SimDataRecorder *recorder = nullptr;
+  SimDataReplay *replay = nullptr;
+  SimDataGenerator *generator = nullptr;
+
+  /* Request compressed delta frames from Little Navconnect. Disabled by default since no released server
+   * implements the format and the request flag is not reserved in atools yet. */
+  bool deltaFormat = false;
+  SimDataDecoder *deltaDecoder = nullptr;
+
   /* Have to keep it since it is read multiple times */
   atools::fs::sc::SimConnectData *simConnectData = nullptr;
 
@@ -0,0 +1,405 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+
+#include "connect/simdatacodec.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QDebug>
+#include <QIODevice>
+
+using atools::fs::sc::SimConnectData;
+using atools::fs::sc::SimConnectAircraft;
+
+namespace  {
+
+/* Frame flags */
+const quint8 FRAME_KEYFRAME = 1;
+
+/* Packet and aircraft encoding */
+const quint8 ENCODING_FULL = 0;
+const quint8 ENCODING_XOR = 1;
+const quint8 ENCODING_UNCHANGED = 2;
+
+/* Send only full states after this number of frames */
+const int KEYFRAME_INTERVAL = 256;
+
+/* Low level is sufficient for the long zero runs and keeps latency down */
+const int COMPRESSION_LEVEL = 3;
+
+/* Refuse larger frames to avoid allocating memory for a corrupted size */
+const quint32 MAX_FRAME_SIZE = 64 * 1024 * 1024;
+
+QByteArray serialize(const SimConnectAircraft& aircraft)
+{
+  QByteArray bytes;
+  QDataStream out(&bytes, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+  aircraft.write(out);
+  return bytes;
+}
+
+/* Packet without aircraft in the plain network format */
+QByteArray serializePacket(const SimConnectData& data)
+{
+  SimConnectData packet(data);
+  packet.getUserAircraft() = atools::fs::sc::SimConnectUserAircraft();
+  packet.getAiAircraft().clear();
+
+  QByteArray bytes;
+  QBuffer buffer(&bytes);
+  buffer.open(QIODevice::WriteOnly);
+  packet.write(&buffer);
+  return bytes;
+}
+
+void deserialize(const QByteArray& bytes, SimConnectAircraft& aircraft)
+{
+  QDataStream in(bytes);
+  in.setVersion(QDataStream::Qt_5_5);
+  aircraft.read(in);
+}
+
+/* XOR bytes with other of same size */
+void xorBytes(QByteArray& bytes, const QByteArray& other)
+{
+  char *data = bytes.data();
+  const char *otherData = other.constData();
+  for(int i = 0; i < bytes.size(); i++)
+    data[i] ^= otherData[i];
+}
+
+}
+
+// ==============================================================================================
+SimDataEncoder::SimDataEncoder()
+{
+}
+
+void SimDataEncoder::reset()
+{
+  lastPacket.clear();
+  lastUser.clear();
+  lastAi.clear();
+  numFrames = 0;
+}
+
+QByteArray SimDataEncoder::encode(const SimConnectData& data)
+{
+  bool keyframe = numFrames % KEYFRAME_INTERVAL == 0;
+  if(keyframe)
+  {
+    lastPacket.clear();
+    lastUser.clear();
+    lastAi.clear();
+  }
+
+  QByteArray payload;
+  QDataStream out(&payload, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+
+  out << (keyframe ? FRAME_KEYFRAME : quint8(0)) << static_cast<quint32>(data.getPacketId());
+
+  // Time stamp, status, metars and all other values
+  QByteArray packetBytes = serializePacket(data);
+  encodeBytes(out, packetBytes, lastPacket);
+  lastPacket = packetBytes;
+
+  QByteArray userBytes = serialize(data.getUserAircraft());
+  encodeBytes(out, userBytes, lastUser);
+  lastUser = userBytes;
+
+  // Ids not contained in the new hash are removed on the decoder side
+  const QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
+  QHash<quint32, QByteArray> ai;
+  ai.reserve(aiAircraft.size());
+
+  out << static_cast<quint32>(aiAircraft.size());
+  for(const SimConnectAircraft& aircraft : aiAircraft)
+  {
+    quint32 id = aircraft.getObjectId();
+    QByteArray bytes = serialize(aircraft);
+    out << id;
+    encodeBytes(out, bytes, lastAi.value(id));
+    ai.insert(id, bytes);
+  }
+  lastAi.swap(ai);
+  numFrames++;
+
+  QByteArray compressed = qCompress(payload, COMPRESSION_LEVEL);
+
+  QByteArray frame;
+  QDataStream header(&frame, QIODevice::WriteOnly);
+  header.setVersion(QDataStream::Qt_5_5);
+  header << simcodec::MAGIC_NUMBER << simcodec::VERSION << static_cast<quint32>(compressed.size());
+  frame.append(compressed);
+  return frame;
+}
+
+void SimDataEncoder::encodeBytes(QDataStream& out, const QByteArray& bytes, const QByteArray& last)
+{
+  if(bytes.size() != last.size())
+    // New aircraft, keyframe or string values changed length
+    out << ENCODING_FULL << bytes;
+  else if(bytes == last)
+    out << ENCODING_UNCHANGED;
+  else
+  {
+    QByteArray delta(bytes);
+    xorBytes(delta, last);
+    out << ENCODING_XOR << delta;
+  }
+}
+
+// ==============================================================================================
+SimDataDecoder::SimDataDecoder()
+{
+}
+
+void SimDataDecoder::reset()
+{
+  lastPacket.clear();
+  lastUser.clear();
+  lastAi.clear();
+  keyframeSeen = false;
+  errorString.clear();
+}
+
+bool SimDataDecoder::isFrame(QIODevice *device)
+{
+  QByteArray bytes = device->peek(sizeof(quint32));
+  if(bytes.size() < static_cast<int>(sizeof(quint32)))
+    return false;
+
+  QDataStream in(bytes);
+  quint32 magic = 0;
+  in >> magic;
+  return magic == simcodec::MAGIC_NUMBER;
+}
+
+bool SimDataDecoder::read(QIODevice *device, SimConnectData& data)
+{
+  // Wait until header and payload are complete
+  QByteArray headerBytes = device->peek(simcodec::HEADER_SIZE);
+  if(headerBytes.size() < simcodec::HEADER_SIZE)
+    return false;
+
+  QDataStream header(headerBytes);
+  header.setVersion(QDataStream::Qt_5_5);
+  quint32 magic = 0, size = 0;
+  quint16 version = 0;
+  header >> magic >> version >> size;
+
+  if(magic != simcodec::MAGIC_NUMBER)
+  {
+    errorString = tr("Invalid magic number in delta frame");
+    return false;
+  }
+
+  if(version != simcodec::VERSION)
+  {
+    errorString = tr("Unsupported delta frame version %1").arg(version);
+    return false;
+  }
+
+  if(size > MAX_FRAME_SIZE)
+  {
+    errorString = tr("Invalid delta frame size %1").arg(size);
+    return false;
+  }
+
+  if(device->bytesAvailable() < simcodec::HEADER_SIZE + static_cast<qint64>(size))
+    return false;
+
+  device->read(simcodec::HEADER_SIZE);
+  QByteArray payload = qUncompress(device->read(size));
+  if(payload.isEmpty())
+  {
+    errorString = tr("Cannot uncompress delta frame");
+    return false;
+  }
+
+  return decodePayload(payload, data);
+}
+
+bool SimDataDecoder::decodePayload(const QByteArray& payload, SimConnectData& data)
+{
+  QDataStream in(payload);
+  in.setVersion(QDataStream::Qt_5_5);
+
+  quint8 flags = 0;
+  quint32 packetId = 0;
+  in >> flags >> packetId;
+
+  if(flags & FRAME_KEYFRAME)
+  {
+    lastPacket.clear();
+    lastUser.clear();
+    lastAi.clear();
+    keyframeSeen = true;
+  }
+  else if(!keyframeSeen)
+  {
+    errorString = tr("Delta frame received before keyframe");
+    return false;
+  }
+
+  // Read packet without aircraft first to get all other values
+  QByteArray packetBytes;
+  if(!decodeBytes(in, lastPacket, packetBytes))
+    return false;
+
+  QBuffer buffer(&packetBytes);
+  buffer.open(QIODevice::ReadOnly);
+  data = SimConnectData();
+  if(!data.read(&buffer))
+  {
+    errorString = tr("Invalid packet in delta frame");
+    return false;
+  }
+  lastPacket = packetBytes;
+
+  QByteArray userBytes;
+  if(!decodeBytes(in, lastUser, userBytes))
+    return false;
+  deserialize(userBytes, data.getUserAircraft());
+  lastUser = userBytes;
+
+  quint32 numAi = 0;
+  in >> numAi;
+
+  QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
+  aiAircraft.reserve(static_cast<int>(numAi));
+  QHash<quint32, QByteArray> ai;
+  ai.reserve(static_cast<int>(numAi));
+
+  for(quint32 i = 0; i < numAi && in.status() == QDataStream::Ok; i++)
+  {
+    quint32 id = 0;
+    in >> id;
+
+    QByteArray bytes;
+    if(!decodeBytes(in, lastAi.value(id), bytes))
+      return false;
+
+    SimConnectAircraft aircraft;
+    deserialize(bytes, aircraft);
+    aiAircraft.append(aircraft);
+    ai.insert(id, bytes);
+  }
+
+  if(in.status() != QDataStream::Ok)
+  {
+    errorString = tr("Truncated delta frame");
+    return false;
+  }
+
+  lastAi.swap(ai);
+  data.setPacketId(static_cast<int>(packetId));
+  return true;
+}
+
+bool SimDataDecoder::decodeBytes(QDataStream& in, const QByteArray& last, QByteArray& bytes)
+{
+  quint8 encoding = ENCODING_FULL;
+  in >> encoding;
+
+  switch(encoding)
+  {
+    case ENCODING_FULL:
+      in >> bytes;
+      return true;
+
+    case ENCODING_XOR:
+      in >> bytes;
+      if(bytes.size() == last.size() && !last.isEmpty())
+      {
+        xorBytes(bytes, last);
+        return true;
+      }
+      break;
+
+    case ENCODING_UNCHANGED:
+      if(!last.isEmpty())
+      {
+        bytes = last;
+        return true;
+      }
+      break;
+  }
+
+  errorString = tr("Invalid delta in frame");
+  return false;
+}
+
+// ==============================================================================================
+void SimDataCodecCheck::reset()
+{
+  encoder.reset();
+  decoder.reset();
+  numPackets = 0;
+  numErrors = 0;
+}
+
+bool SimDataCodecCheck::check(const SimConnectData& data)
+{
+  // Weather replies are sent in the plain format
+  if(data.getPacketId() <= 0 && !data.getMetars().isEmpty())
+    return true;
+
+  numPackets++;
+
+  QByteArray frame = encoder.encode(data);
+  QBuffer buffer(&frame);
+  buffer.open(QIODevice::ReadOnly);
+
+  SimConnectData decoded;
+  if(!decoder.read(&buffer, decoded) || !buffer.atEnd())
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot decode packet" << data.getPacketId() << decoder.getErrorString();
+    numErrors++;
+    // Start again with a keyframe
+    encoder.reset();
+    decoder.reset();
+    return false;
+  }
+
+  if(!compare(data, decoded))
+  {
+    qWarning() << Q_FUNC_INFO << "Decoded packet" << data.getPacketId() << "differs";
+    numErrors++;
+    return false;
+  }
+  return true;
+}
+
+bool SimDataCodecCheck::compare(const SimConnectData& data, const SimConnectData& decoded) const
+{
+  if(data.getPacketId() != decoded.getPacketId() || serializePacket(data) != serializePacket(decoded) ||
+     serialize(data.getUserAircraft()) != serialize(decoded.getUserAircraft()) ||
+     data.getAiAircraft().size() != decoded.getAiAircraft().size())
+    return false;
+
+  for(int i = 0; i < data.getAiAircraft().size(); i++)
+  {
+    if(serialize(data.getAiAircraft().at(i)) != serialize(decoded.getAiAircraft().at(i)))
+      return false;
+  }
+  return true;
+}
@@ -0,0 +1,150 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_SIMDATACODEC_H
+#define LITTLENAVMAP_SIMDATACODEC_H
+
+#include "fs/sc/simconnectdata.h"
+#include "fs/sc/simconnectreply.h"
+
+#include <QCoreApplication>
+#include <QHash>
+
+class QIODevice;
+class QDataStream;
+
+namespace simcodec {
+
+/* Sent by the client in a SimConnectReply right after connecting to request delta frames. Servers not
+ * knowing the flag ignore it and continue to send plain SimConnectData packets.
+ * Belongs to atools::fs::sc::Commands and has to be moved there so the bit is not taken by another command.
+ * Defined here only since atools is not part of this source tree. */
+const atools::fs::sc::Commands CMD_REQUEST_DELTA_FORMAT = atools::fs::sc::Commands(QFlag(1 << 15));
+
+/* "LNMD" - differs from the SimConnectData magic number so both formats can be mixed on one stream */
+const quint32 MAGIC_NUMBER = 0x4C4E4D44;
+const quint16 VERSION = 2;
+
+/* Magic number, version and payload size */
+const int HEADER_SIZE = 10;
+
+}
+
+/*
+ * Compressed delta format for simulator data sent over the network by Little Navconnect.
+ *
+ * Each frame contains the packet without aircraft, the user aircraft and all AI aircraft keyed by object id.
+ * The packet carries all other values like the time stamp in the plain network format. Packet and aircraft
+ * are serialized and either sent in full, XORed against the previous state which turns unchanged fields
+ * into zero runs, or marked as unchanged. Aircraft missing in a frame are removed. The payload is compressed.
+ * A keyframe containing only full states is sent periodically.
+ *
+ * Only aircraft packets are encoded. Weather replies are still sent as plain SimConnectData packets.
+ */
+class SimDataEncoder
+{
+public:
+  SimDataEncoder();
+
+  /* Returns a complete frame including header */
+  QByteArray encode(const atools::fs::sc::SimConnectData& data);
+
+  /* Start with a keyframe. Has to be called for each new connection. */
+  void reset();
+
+private:
+  void encodeBytes(QDataStream& out, const QByteArray& bytes, const QByteArray& last);
+
+  QByteArray lastPacket, lastUser;
+  QHash<quint32, QByteArray> lastAi;
+  int numFrames = 0;
+};
+
+/*
+ * Reads frames written by SimDataEncoder from a socket or other device.
+ */
+class SimDataDecoder
+{
+  Q_DECLARE_TR_FUNCTIONS(SimDataDecoder)
+
+public:
+  SimDataDecoder();
+
+  /* true if the next bytes in the device are the start of a delta frame. Does not consume any data. */
+  static bool isFrame(QIODevice *device);
+
+  /* Read a frame into data. Returns false if the frame is not complete yet or on error.
+   * Nothing is consumed from the device for incomplete frames. */
+  bool read(QIODevice *device, atools::fs::sc::SimConnectData& data);
+
+  bool hasError() const
+  {
+    return !errorString.isEmpty();
+  }
+
+  const QString& getErrorString() const
+  {
+    return errorString;
+  }
+
+  /* Clear state for a new connection */
+  void reset();
+
+private:
+  bool decodePayload(const QByteArray& payload, atools::fs::sc::SimConnectData& data);
+  bool decodeBytes(QDataStream& in, const QByteArray& last, QByteArray& bytes);
+
+  QByteArray lastPacket, lastUser;
+  QHash<quint32, QByteArray> lastAi;
+  bool keyframeSeen = false;
+  QString errorString;
+};
+
+/*
+ * Sends packets through an encoder and decoder pair and compares the result with the original packet.
+ * Used to verify the delta format with replayed recordings. Weather replies are skipped since they are not
+ * encoded.
+ */
+class SimDataCodecCheck
+{
+public:
+  /* Returns false and prints a warning if the decoded packet differs from data */
+  bool check(const atools::fs::sc::SimConnectData& data);
+
+  /* Clear encoder and decoder state and counters */
+  void reset();
+
+  int getNumPackets() const
+  {
+    return numPackets;
+  }
+
+  int getNumErrors() const
+  {
+    return numErrors;
+  }
+
+private:
+  bool compare(const atools::fs::sc::SimConnectData& data, const atools::fs::sc::SimConnectData& decoded) const;
+
+  SimDataEncoder encoder;
+  SimDataDecoder decoder;
+  int numPackets = 0, numErrors = 0;
+};
+
+#endif // LITTLENAVMAP_SIMDATACODEC_H
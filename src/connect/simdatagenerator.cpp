@@ -0,0 +1,363 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "connect/simdatagenerator.h"
+
+#include "geo/calculations.h"
+#include "atools.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QtEndian>
+
+#include <functional>
+
+using atools::fs::sc::SimConnectData;
+using atools::fs::sc::SimConnectAircraft;
+using atools::geo::Pos;
+
+namespace  {
+
+QByteArray serialize(const SimConnectAircraft& aircraft)
+{
+  QByteArray bytes;
+  QDataStream out(&bytes, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+  aircraft.write(out);
+  return bytes;
+}
+
+void deserialize(const QByteArray& bytes, SimConnectAircraft& aircraft)
+{
+  QDataStream in(bytes);
+  in.setVersion(QDataStream::Qt_5_5);
+  aircraft.read(in);
+}
+
+/* Encode value like the aircraft serialization does using single or double precision */
+QByteArray encodeReal(float value, bool doublePrecision)
+{
+  QByteArray bytes;
+  QDataStream out(&bytes, QIODevice::WriteOnly);
+  out.setVersion(QDataStream::Qt_5_5);
+  out.setFloatingPointPrecision(doublePrecision ? QDataStream::DoublePrecision : QDataStream::SinglePrecision);
+  out << value;
+  return bytes;
+}
+
+void patchReal(QByteArray& bytes, int offset, float value, bool doublePrecision)
+{
+  QByteArray encoded = encodeReal(value, doublePrecision);
+  bytes.replace(offset, encoded.size(), encoded);
+}
+
+void patchInt(QByteArray& bytes, int offset, quint32 value, int size)
+{
+  uchar *data = reinterpret_cast<uchar *>(bytes.data()) + offset;
+  if(size == 1)
+    *data = static_cast<uchar>(value);
+  else if(size == 2)
+    qToBigEndian<quint16>(static_cast<quint16>(value), data);
+  else
+    qToBigEndian<quint32>(value, data);
+}
+
+/* Check that patching one field did not change other values */
+bool sameOtherValues(const SimConnectAircraft& aircraft, const SimConnectAircraft& other)
+{
+  return aircraft.getObjectId() == other.getObjectId() &&
+         atools::almostEqual(aircraft.getPosition().getLonX(), other.getPosition().getLonX()) &&
+         atools::almostEqual(aircraft.getPosition().getLatY(), other.getPosition().getLatY()) &&
+         aircraft.getAirplaneTitle() == other.getAirplaneTitle();
+}
+
+/* Find offset of a real value by writing a probe value at each place where the value is encoded and
+ * reading it back using the getter. Returns -1 if not found. */
+int findRealOffset(const QByteArray& bytes, float value, bool doublePrecision,
+                   std::function<float(const SimConnectAircraft&)> getter)
+{
+  const float probe = value + 1.25f;
+  QByteArray encoded = encodeReal(value, doublePrecision);
+  for(int offset = bytes.indexOf(encoded); offset != -1; offset = bytes.indexOf(encoded, offset + 1))
+  {
+    QByteArray patched(bytes);
+    patchReal(patched, offset, probe, doublePrecision);
+    SimConnectAircraft aircraft;
+    deserialize(patched, aircraft);
+    if(atools::almostEqual(getter(aircraft), probe))
+      return offset;
+  }
+  return -1;
+}
+
+}
+
+SimDataGenerator::SimDataGenerator(QObject *parent)
+  : QObject(parent)
+{
+  connect(&timer, &QTimer::timeout, this, &SimDataGenerator::generate);
+}
+
+SimDataGenerator::~SimDataGenerator()
+{
+  timer.stop();
+}
+
+void SimDataGenerator::start(const QVector<Pos>& centers, int numAircraft, int updateRateMs)
+{
+  if(isActive())
+    stop();
+
+  if(centers.isEmpty())
+    return;
+
+  qDebug() << Q_FUNC_INFO << "airports" << centers.size() << "aircraft" << numAircraft
+           << "update rate" << updateRateMs;
+
+  if(!createTemplate(aircraftTemplate, false) || !createTemplate(shipTemplate, true))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot find aircraft fields in serialized data";
+    return;
+  }
+
+  // Same traffic for each run
+  random.seed(1);
+
+  vehicles.clear();
+  vehicles.reserve(numAircraft);
+  // Object ids start with 1 for AI and ships - the user aircraft uses 0
+  for(int i = 0; i < numAircraft; i++)
+    vehicles.append(createVehicle(centers.at(i % centers.size()), static_cast<quint32>(i + 1)));
+
+  // User aircraft circles the first airport
+  user = createVehicle(centers.first(), 0);
+  user.ship = false;
+  user.radiusNm = 10.f;
+  user.altitudeFt = 5000.f;
+  user.speedKts = 200.f;
+
+  numPackets = 0;
+  lastTimeMs = 0;
+  clock.start();
+  timer.start(updateRateMs);
+}
+
+void SimDataGenerator::stop()
+{
+  if(timer.isActive())
+  {
+    qDebug() << Q_FUNC_INFO << "packets" << numPackets;
+
+    timer.stop();
+    vehicles.clear();
+    emit finished();
+  }
+}
+
+bool SimDataGenerator::isActive() const
+{
+  return timer.isActive();
+}
+
+SimDataGenerator::Vehicle SimDataGenerator::createVehicle(const Pos& center, quint32 objectId)
+{
+  std::uniform_real_distribution<float> angle(0.f, 360.f);
+  std::uniform_int_distribution<int> percent(0, 99);
+  std::bernoulli_distribution clockwise;
+
+  Vehicle vehicle;
+  vehicle.center = center;
+  vehicle.angleDeg = angle(random);
+  vehicle.clockwise = clockwise(random);
+  vehicle.objectId = objectId;
+  vehicle.ship = false;
+
+  int type = percent(random);
+  if(type < SHIP_PERCENT)
+  {
+    // Ship cruising at sea level
+    vehicle.ship = true;
+    vehicle.radiusNm = std::uniform_real_distribution<float>(2.f, 30.f)(random);
+    vehicle.speedKts = std::uniform_real_distribution<float>(5.f, 25.f)(random);
+    vehicle.altitudeFt = 0.f;
+  }
+  else if(type < SHIP_PERCENT + GROUND_PERCENT)
+  {
+    // Taxiing
+    vehicle.radiusNm = std::uniform_real_distribution<float>(0.2f, 1.5f)(random);
+    vehicle.speedKts = std::uniform_real_distribution<float>(5.f, 25.f)(random);
+    vehicle.altitudeFt = center.getAltitude();
+  }
+  else
+  {
+    // Departing, arriving or en route
+    vehicle.radiusNm = std::uniform_real_distribution<float>(3.f, 120.f)(random);
+    vehicle.speedKts = std::uniform_real_distribution<float>(120.f, 480.f)(random);
+    vehicle.altitudeFt = std::uniform_real_distribution<float>(1000.f, 40000.f)(random);
+  }
+
+  vehicle.lastPos = move(vehicle, 0.f);
+  return vehicle;
+}
+
+Pos SimDataGenerator::move(Vehicle& vehicle, float seconds) const
+{
+  // Angle change for flown distance on the circle
+  float distNm = vehicle.speedKts * seconds / 3600.f;
+  float deltaDeg = atools::geo::toDegree(distNm / vehicle.radiusNm);
+  vehicle.angleDeg = atools::geo::normalizeCourse(vehicle.angleDeg + (vehicle.clockwise ? deltaDeg : -deltaDeg));
+
+  Pos pos = vehicle.center.endpoint(atools::geo::nmToMeter(vehicle.radiusNm), vehicle.angleDeg).normalize();
+  pos.setAltitude(vehicle.altitudeFt);
+  return pos;
+}
+
+bool SimDataGenerator::createTemplate(AircraftTemplate& aircraftTemplate, bool ship)
+{
+  // Use values which are unlikely to appear elsewhere in the data
+  const Pos lastPos(12.3456f, 47.8912f, 3456.f);
+  const SimConnectAircraft original =
+    SimConnectData::buildDebugForPosition(lastPos.endpoint(1234.f, 37.f).normalize(), lastPos).getUserAircraft();
+  QByteArray bytes = serialize(original);
+  AircraftTemplate& t = aircraftTemplate;
+
+  auto lonX = [](const SimConnectAircraft& ac) -> float
+              {
+                return ac.getPosition().getLonX();
+              };
+  auto latY = [](const SimConnectAircraft& ac) -> float
+              {
+                return ac.getPosition().getLatY();
+              };
+  auto altitude = [](const SimConnectAircraft& ac) -> float
+                  {
+                    return ac.getPosition().getAltitude();
+                  };
+  auto heading = [](const SimConnectAircraft& ac) -> float
+                 {
+                   return ac.getHeadingDegTrue();
+                 };
+  auto speed = [](const SimConnectAircraft& ac) -> float
+               {
+                 return ac.getGroundSpeedKts();
+               };
+
+  // Detect float precision using the longitude
+  for(bool doublePrecision : {false, true})
+  {
+    t.doublePrecision = doublePrecision;
+    t.lonXOffset = findRealOffset(bytes, lonX(original), doublePrecision, lonX);
+    if(t.lonXOffset != -1)
+      break;
+  }
+  t.latYOffset = findRealOffset(bytes, latY(original), t.doublePrecision, latY);
+  t.altitudeOffset = findRealOffset(bytes, altitude(original), t.doublePrecision, altitude);
+  t.headingOffset = findRealOffset(bytes, heading(original), t.doublePrecision, heading);
+  t.speedOffset = findRealOffset(bytes, speed(original), t.doublePrecision, speed);
+
+  // Find object id, user flag and category by changing each byte and reading back
+  const quint32 probeId = 0x5A5A5A5A;
+  const auto category = ship ? atools::fs::sc::BOAT : atools::fs::sc::AIRPLANE;
+  bool userCleared = !original.isUser(), categorySet = original.getCategory() == category;
+  SimConnectAircraft aircraft;
+  for(int offset = 0; offset < bytes.size(); offset++)
+  {
+    if(t.objectIdOffset == -1 && offset + 4 <= bytes.size())
+    {
+      QByteArray patched(bytes);
+      patchInt(patched, offset, probeId, 4);
+      deserialize(patched, aircraft);
+      if(aircraft.getObjectId() == probeId)
+        t.objectIdOffset = offset;
+    }
+
+    for(int bit = 0; bit < 8 && !userCleared; bit++)
+    {
+      QByteArray patched(bytes);
+      patched[offset] = static_cast<char>(patched.at(offset) & ~(1 << bit));
+      deserialize(patched, aircraft);
+      if(!aircraft.isUser() && aircraft.getCategory() == original.getCategory() &&
+         sameOtherValues(aircraft, original))
+      {
+        bytes = patched;
+        userCleared = true;
+      }
+    }
+
+    for(int size : {1, 2, 4})
+    {
+      if(categorySet || offset + size > bytes.size())
+        break;
+
+      QByteArray patched(bytes);
+      patchInt(patched, offset, static_cast<quint32>(category), size);
+      deserialize(patched, aircraft);
+      if(aircraft.getCategory() == category && aircraft.isUser() == !userCleared &&
+         sameOtherValues(aircraft, original))
+      {
+        bytes = patched;
+        categorySet = true;
+      }
+    }
+  }
+
+  t.bytes = bytes;
+  return t.lonXOffset != -1 && t.latYOffset != -1 && t.altitudeOffset != -1 && t.headingOffset != -1 &&
+         t.speedOffset != -1 && t.objectIdOffset != -1 && userCleared && categorySet;
+}
+
+SimConnectAircraft SimDataGenerator::buildAiVehicle(const Vehicle& vehicle, const Pos& pos) const
+{
+  const AircraftTemplate& t = vehicle.ship ? shipTemplate : aircraftTemplate;
+
+  QByteArray bytes(t.bytes);
+  patchInt(bytes, t.objectIdOffset, vehicle.objectId, 4);
+  patchReal(bytes, t.lonXOffset, pos.getLonX(), t.doublePrecision);
+  patchReal(bytes, t.latYOffset, pos.getLatY(), t.doublePrecision);
+  patchReal(bytes, t.altitudeOffset, pos.getAltitude(), t.doublePrecision);
+  patchReal(bytes, t.headingOffset, vehicle.lastPos.angleDegTo(pos), t.doublePrecision);
+  patchReal(bytes, t.speedOffset, vehicle.speedKts, t.doublePrecision);
+
+  SimConnectAircraft aircraft;
+  deserialize(bytes, aircraft);
+  return aircraft;
+}
+
+void SimDataGenerator::generate()
+{
+  qint64 now = clock.elapsed();
+  float seconds = static_cast<float>(now - lastTimeMs) / 1000.f;
+  lastTimeMs = now;
+
+  // Heading and other values are calculated by the debug builder
+  Pos userPos = move(user, seconds);
+  SimConnectData data = SimConnectData::buildDebugForPosition(userPos, user.lastPos);
+  data.setPacketId(++numPackets);
+  user.lastPos = userPos;
+
+  QVector<SimConnectAircraft>& aiAircraft = data.getAiAircraft();
+  aiAircraft.reserve(vehicles.size());
+  for(Vehicle& vehicle : vehicles)
+  {
+    Pos pos = move(vehicle, seconds);
+    aiAircraft.append(buildAiVehicle(vehicle, pos));
+    vehicle.lastPos = pos;
+  }
+
+  emit postSimConnectData(data);
+}
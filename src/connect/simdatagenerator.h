@@ -0,0 +1,122 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_SIMDATAGENERATOR_H
+#define LITTLENAVMAP_SIMDATAGENERATOR_H
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QElapsedTimer>
+#include <QTimer>
+
+#include <random>
+
+/*
+ * Generates synthetic simulator data with a large number of AI aircraft to load test the map, screen index
+ * and information windows without a simulator.
+ *
+ * Aircraft fly circles at random distance, altitude and speed around the given airport positions.
+ * A part of them moves slowly close to the airports to simulate taxiing traffic and another part are ships
+ * cruising at sea level. Each vehicle has a unique object id.
+ * Packets are emitted like the DataReaderThread does. Runs in the event loop using a timer.
+ *
+ * atools has no setters for aircraft. AI vehicles are therefore built by patching a serialized template
+ * aircraft and reading it back. The offsets of the patched fields are found once when starting by changing the
+ * serialized bytes and checking the result with the getters.
+ * The random generator uses a fixed seed so runs are repeatable.
+ */
+class SimDataGenerator :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  SimDataGenerator(QObject *parent);
+  virtual ~SimDataGenerator();
+
+  /* Start generating numAircraft AI aircraft distributed around the positions in centers.
+   * A packet is emitted every updateRateMs. */
+  void start(const QVector<atools::geo::Pos>& centers, int numAircraft, int updateRateMs);
+
+  /* Stop and emit finished */
+  void stop();
+  bool isActive() const;
+
+  int getNumPackets() const
+  {
+    return numPackets;
+  }
+
+signals:
+  /* Emitted for each generated packet */
+  void postSimConnectData(atools::fs::sc::SimConnectData dataPacket);
+
+  /* Emitted when stopped */
+  void finished();
+
+private:
+  struct Vehicle
+  {
+    atools::geo::Pos center, lastPos;
+    float radiusNm, angleDeg, speedKts, altitudeFt;
+    quint32 objectId;
+    bool clockwise, ship;
+  };
+
+  /* Move all vehicles and emit a packet */
+  void generate();
+
+  /* Create vehicle with random parameters flying around center */
+  Vehicle createVehicle(const atools::geo::Pos& center, quint32 objectId);
+
+  /* Serialized AI aircraft or ship and the offsets of fields changed for each vehicle */
+  struct AircraftTemplate
+  {
+    QByteArray bytes;
+    int objectIdOffset = -1, lonXOffset = -1, latYOffset = -1, altitudeOffset = -1, headingOffset = -1,
+        speedOffset = -1;
+    bool doublePrecision = false;
+  };
+
+  /* Build AI aircraft or ship for the vehicle at pos from the template */
+  atools::fs::sc::SimConnectAircraft buildAiVehicle(const Vehicle& vehicle, const atools::geo::Pos& pos) const;
+
+  /* Find field offsets and clear the user flag. Returns false if a field cannot be found. */
+  static bool createTemplate(AircraftTemplate& aircraftTemplate, bool ship);
+
+  /* Advance vehicle by the given time and return the new position */
+  atools::geo::Pos move(Vehicle& vehicle, float seconds) const;
+
+  /* Number of vehicles moving slowly close to the airport in percent */
+  static Q_DECL_CONSTEXPR int GROUND_PERCENT = 10;
+
+  /* Number of ships in percent */
+  static Q_DECL_CONSTEXPR int SHIP_PERCENT = 5;
+
+  QVector<Vehicle> vehicles;
+  Vehicle user;
+  AircraftTemplate aircraftTemplate, shipTemplate;
+
+  QTimer timer;
+  QElapsedTimer clock;
+  qint64 lastTimeMs = 0;
+  int numPackets = 0;
+  std::mt19937 random;
+};
+
+#endif // LITTLENAVMAP_SIMDATAGENERATOR_H
@@ -0,0 +1,136 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "connect/simdatahub.h"
+
+using atools::fs::sc::SimConnectData;
+
+SimDataHub::SimDataHub(QObject *parent)
+  : QObject(parent)
+{
+  clock.start();
+
+  // Always queued - also if the producer is the GUI thread
+  connect(this, &SimDataHub::dataAvailable, this, &SimDataHub::fetchAndDeliver, Qt::QueuedConnection);
+
+  deliveryTimer.setSingleShot(true);
+  connect(&deliveryTimer, &QTimer::timeout, this, &SimDataHub::deliver);
+}
+
+SimDataHub::~SimDataHub()
+{
+  deliveryTimer.stop();
+}
+
+void SimDataHub::post(const SimConnectData& data)
+{
+  numPosted++;
+  if(buffer.write(data))
+    // Buffer was empty - notify GUI thread once
+    emit dataAvailable();
+}
+
+void SimDataHub::addConsumer(const ConsumerFunc& consumer, int intervalMs)
+{
+  consumers.append({consumer, intervalMs, 0, -1});
+}
+
+void SimDataHub::clear()
+{
+  buffer.clear();
+  latest.reset();
+  deliveryTimer.stop();
+
+  for(Consumer& consumer : consumers)
+    consumer.lastDeliveryMs = -1;
+}
+
+void SimDataHub::fetchAndDeliver()
+{
+  SimConnectData *data = buffer.take();
+  if(data != nullptr)
+  {
+    latest.reset(data);
+    sequence++;
+    numFetched++;
+  }
+  deliver();
+}
+
+void SimDataHub::deliver()
+{
+  if(latest.isNull())
+    return;
+
+  // Keep a reference in case a consumer calls clear
+  QSharedPointer<const SimConnectData> snapshot(latest);
+  quint64 snapshotSequence = sequence;
+
+  QElapsedTimer handlingTimer;
+  handlingTimer.start();
+
+  qint64 now = clock.elapsed(), nextDueMs = -1;
+  for(Consumer& consumer : consumers)
+  {
+    if(consumer.sequence == snapshotSequence)
+      // Already has this one
+      continue;
+
+    qint64 dueMs = consumer.lastDeliveryMs + consumer.intervalMs;
+    if(consumer.lastDeliveryMs == -1 || now >= dueMs)
+    {
+      consumer.sequence = snapshotSequence;
+      consumer.lastDeliveryMs = now;
+      consumer.func(*snapshot);
+    }
+    else if(nextDueMs == -1 || dueMs < nextDueMs)
+      nextDueMs = dueMs;
+  }
+
+  qint64 deliveryNs = handlingTimer.nsecsElapsed();
+  totalDeliveryNs += deliveryNs;
+  maxDeliveryNs = std::max(maxDeliveryNs, deliveryNs);
+  numDeliveries++;
+
+  if(nextDueMs != -1)
+    // Deliver latest snapshot to skipped consumers later
+    deliveryTimer.start(static_cast<int>(nextDueMs - now));
+}
+
+void SimDataHub::resetStatistics()
+{
+  numPosted = 0;
+  numFetched = 0;
+  numDeliveries = 0;
+  totalDeliveryNs = 0;
+  maxDeliveryNs = 0;
+}
+
+QStringList SimDataHub::getStatisticsText() const
+{
+  quint64 posted = numPosted;
+  QStringList text;
+  text.append(tr("Packets posted %1, delivered %2, dropped %3").
+              arg(posted).arg(numFetched).arg(posted > numFetched ? posted - numFetched : 0));
+
+  if(numDeliveries > 0)
+    text.append(tr("Packet handling average %1 ms, maximum %2 ms").
+                arg(static_cast<double>(totalDeliveryNs) / numDeliveries / 1000000., 0, 'f', 2).
+                arg(static_cast<double>(maxDeliveryNs) / 1000000., 0, 'f', 2));
+  return text;
+}
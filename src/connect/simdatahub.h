@@ -0,0 +1,109 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_SIMDATAHUB_H
+#define LITTLENAVMAP_SIMDATAHUB_H
+
+#include "common/latestvaluebuffer.h"
+#include "fs/sc/simconnectdata.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QTimer>
+
+#include <atomic>
+#include <functional>
+
+/*
+ * Central distribution point for simulator data packets.
+ *
+ * The producer (data reader thread or network socket) writes packets into a lock free latest value buffer.
+ * Only one notification is queued into the event loop regardless of the packet rate. Packets not fetched
+ * until then are dropped.
+ *
+ * Consumers are called in the GUI thread with an immutable shared snapshot, each not more often than its
+ * configured interval. A consumer that was skipped due to its interval gets the latest snapshot once
+ * the interval has passed.
+ */
+class SimDataHub :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  typedef std::function<void (const atools::fs::sc::SimConnectData&)> ConsumerFunc;
+
+  SimDataHub(QObject *parent);
+  virtual ~SimDataHub();
+
+  /* Thread safe. Can be called from any thread but only one producer at a time. */
+  void post(const atools::fs::sc::SimConnectData& data);
+
+  /* Register a consumer which is called not more often than every intervalMs.
+   * Consumers are called in order of registration. */
+  void addConsumer(const ConsumerFunc& consumer, int intervalMs = 0);
+
+  /* Get the latest snapshot or null if nothing was received since the last clear. */
+  QSharedPointer<const atools::fs::sc::SimConnectData> getLatest() const
+  {
+    return latest;
+  }
+
+  /* Drop all pending data. Called after disconnect. */
+  void clear();
+
+  /* Packet handling statistics: posted, delivered and dropped packets and time spent in consumers */
+  void resetStatistics();
+  QStringList getStatisticsText() const;
+
+signals:
+  /* Internal. Emitted by the producer when data was written into the empty buffer. */
+  void dataAvailable();
+
+private:
+  struct Consumer
+  {
+    ConsumerFunc func;
+    int intervalMs;
+    quint64 sequence; /* Sequence number of last delivered snapshot */
+    qint64 lastDeliveryMs; /* -1 if nothing delivered yet */
+  };
+
+  /* Take latest value from the buffer and deliver it */
+  void fetchAndDeliver();
+
+  /* Call all consumers which are due and start the timer for the rest */
+  void deliver();
+
+  LatestValueBuffer<atools::fs::sc::SimConnectData> buffer;
+  QSharedPointer<const atools::fs::sc::SimConnectData> latest;
+  quint64 sequence = 0;
+
+  QVector<Consumer> consumers;
+  QTimer deliveryTimer;
+  QElapsedTimer clock;
+
+  /* Statistics. Posted is written by the producer thread. */
+  std::atomic<quint64> numPosted {0};
+  quint64 numFetched = 0, numDeliveries = 0;
+  qint64 totalDeliveryNs = 0, maxDeliveryNs = 0;
+};
+
+#endif // LITTLENAVMAP_SIMDATAHUB_H
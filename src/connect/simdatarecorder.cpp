@@ -0,0 +1,311 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "connect/simdatarecorder.h"
+
+#include "common/constants.h"
+#include "settings/settings.h"
+
+#include <QBuffer>
+#include <QDebug>
+
+using atools::fs::sc::SimConnectData;
+
+namespace  {
+/* "LNMR" */
+const quint32 FILE_MAGIC_NUMBER = 0x4C4E4D52;
+const quint16 FILE_VERSION = 1;
+
+/* Record types */
+const quint8 RECORD_FULL = 0;
+const quint8 RECORD_DELTA = 1;
+
+/* Write a full packet after this number of packets */
+const int KEYFRAME_INTERVAL = 256;
+
+const int COMPRESSION_LEVEL = 6;
+
+/* XOR bytes with other of same size */
+void xorBytes(QByteArray& bytes, const QByteArray& other)
+{
+  char *data = bytes.data();
+  const char *otherData = other.constData();
+  for(int i = 0; i < bytes.size(); i++)
+    data[i] ^= otherData[i];
+}
+
+}
+
+// ==============================================================================================
+SimDataRecorder::SimDataRecorder()
+{
+}
+
+SimDataRecorder::~SimDataRecorder()
+{
+  close();
+}
+
+bool SimDataRecorder::open(const QString& filename)
+{
+  QMutexLocker locker(&mutex);
+
+  if(file.isOpen())
+    file.close();
+
+  errorString.clear();
+  lastPacket.clear();
+  lastTimeMs = 0;
+  numPackets = 0;
+
+  file.setFileName(filename);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    errorString = file.errorString();
+    return false;
+  }
+
+  stream.setDevice(&file);
+  stream.setVersion(QDataStream::Qt_5_5);
+  stream << FILE_MAGIC_NUMBER << FILE_VERSION;
+  timer.start();
+
+  qDebug() << Q_FUNC_INFO << "Recording to" << filename;
+  return true;
+}
+
+void SimDataRecorder::close()
+{
+  QMutexLocker locker(&mutex);
+
+  if(file.isOpen())
+  {
+    qDebug() << Q_FUNC_INFO << "Recorded" << numPackets << "packets to" << file.fileName();
+    stream.setDevice(nullptr);
+    file.close();
+  }
+  lastPacket.clear();
+}
+
+bool SimDataRecorder::isOpen() const
+{
+  QMutexLocker locker(&mutex);
+  return file.isOpen();
+}
+
+QString SimDataRecorder::getErrorString() const
+{
+  QMutexLocker locker(&mutex);
+  return errorString;
+}
+
+void SimDataRecorder::write(const SimConnectData& data)
+{
+  QMutexLocker locker(&mutex);
+
+  if(!file.isOpen())
+    return;
+
+  // Serialize using the network format
+  QByteArray packet;
+  QBuffer buffer(&packet);
+  buffer.open(QIODevice::WriteOnly);
+  SimConnectData(data).write(&buffer);
+  buffer.close();
+
+  QByteArray payload(packet);
+  quint8 type = RECORD_FULL;
+  if(numPackets % KEYFRAME_INTERVAL != 0 && packet.size() == lastPacket.size())
+  {
+    // Most values do not change between packets which results in long zero sequences
+    xorBytes(payload, lastPacket);
+    type = RECORD_DELTA;
+  }
+
+  qint64 now = timer.elapsed();
+  quint32 deltaMs = numPackets == 0 ? 0 : static_cast<quint32>(now - lastTimeMs);
+  stream << deltaMs << type << qCompress(payload, COMPRESSION_LEVEL);
+
+  if(stream.status() != QDataStream::Ok)
+  {
+    errorString = file.errorString();
+    qWarning() << Q_FUNC_INFO << "Error writing" << file.fileName() << errorString;
+    stream.setDevice(nullptr);
+    file.close();
+    return;
+  }
+
+  lastTimeMs = now;
+  lastPacket = packet;
+  numPackets++;
+}
+
+// ==============================================================================================
+SimDataReplay::SimDataReplay(QObject *parent)
+  : QObject(parent)
+{
+  timer.setSingleShot(true);
+  connect(&timer, &QTimer::timeout, this, &SimDataReplay::replayNext);
+}
+
+SimDataReplay::~SimDataReplay()
+{
+  timer.stop();
+}
+
+bool SimDataReplay::start(const QString& filename, int speed)
+{
+  if(isActive())
+    stop();
+
+  errorString.clear();
+  lastPacket.clear();
+  nextTimeMs = 0;
+  this->speed = speed;
+
+  codecCheck.reset();
+  checkCodec = atools::settings::Settings::instance().getAndStoreValue(
+    lnm::OPTIONS_SIM_DATA_CODEC_CHECK, false).toBool();
+
+  file.setFileName(filename);
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    errorString = file.errorString();
+    return false;
+  }
+
+  stream.setDevice(&file);
+  stream.setVersion(QDataStream::Qt_5_5);
+
+  quint32 magic = 0;
+  quint16 version = 0;
+  stream >> magic >> version;
+  if(magic != FILE_MAGIC_NUMBER || version != FILE_VERSION)
+  {
+    errorString = tr("Not a simulator data recording or unsupported version.");
+    stream.setDevice(nullptr);
+    file.close();
+    return false;
+  }
+
+  if(!readRecord())
+  {
+    if(errorString.isEmpty())
+      errorString = tr("Recording is empty.");
+    stream.setDevice(nullptr);
+    file.close();
+    return false;
+  }
+
+  qDebug() << Q_FUNC_INFO << "Replaying" << filename << "speed" << speed;
+
+  clock.start();
+  timer.start(0);
+  return true;
+}
+
+void SimDataReplay::stop()
+{
+  if(file.isOpen())
+  {
+    if(checkCodec)
+      qDebug() << Q_FUNC_INFO << "Codec check packets" << codecCheck.getNumPackets()
+               << "errors" << codecCheck.getNumErrors();
+
+    timer.stop();
+    stream.setDevice(nullptr);
+    file.close();
+    emit finished();
+  }
+}
+
+bool SimDataReplay::isActive() const
+{
+  return file.isOpen();
+}
+
+void SimDataReplay::replayNext()
+{
+  if(speed <= 0)
+  {
+    // One packet per event loop iteration to keep the GUI alive
+    emit postSimConnectData(nextData);
+    if(readRecord())
+      timer.start(0);
+    else
+      stop();
+    return;
+  }
+
+  // Position in the recording time line
+  qint64 nowMs = clock.elapsed() * speed;
+  while(nextTimeMs <= nowMs)
+  {
+    emit postSimConnectData(nextData);
+    if(!readRecord())
+    {
+      stop();
+      return;
+    }
+  }
+
+  timer.start(static_cast<int>((nextTimeMs - nowMs) / speed));
+}
+
+bool SimDataReplay::readRecord()
+{
+  if(stream.atEnd())
+    return false;
+
+  quint32 deltaMs = 0;
+  quint8 type = RECORD_FULL;
+  QByteArray payload;
+  stream >> deltaMs >> type >> payload;
+  if(stream.status() != QDataStream::Ok)
+  {
+    errorString = tr("Truncated recording.");
+    return false;
+  }
+
+  QByteArray packet = qUncompress(payload);
+  if(type == RECORD_DELTA)
+  {
+    if(packet.size() != lastPacket.size())
+    {
+      errorString = tr("Invalid delta record.");
+      return false;
+    }
+    xorBytes(packet, lastPacket);
+  }
+  lastPacket = packet;
+
+  QBuffer buffer(&packet);
+  buffer.open(QIODevice::ReadOnly);
+  nextData = SimConnectData();
+  if(!nextData.read(&buffer) || nextData.getStatus() != atools::fs::sc::OK)
+  {
+    errorString = tr("Invalid packet: %1").arg(nextData.getStatusText());
+    return false;
+  }
+
+  if(checkCodec)
+    codecCheck.check(nextData);
+
+  nextTimeMs += deltaMs;
+  return true;
+}
@@ -0,0 +1,122 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_SIMDATARECORDER_H
+#define LITTLENAVMAP_SIMDATARECORDER_H
+
+#include "connect/simdatacodec.h"
+#include "fs/sc/simconnectdata.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QTimer>
+
+/*
+ * Records the stream of simulator data packets including AI aircraft and weather replies into a binary file.
+ *
+ * Packets are serialized in the network format. Each packet is stored as the XOR difference to the previous
+ * one if the size is unchanged and compressed. A full packet is written periodically and if the size changes.
+ * Time is stored as milliseconds since the previous packet.
+ */
+class SimDataRecorder
+{
+public:
+  SimDataRecorder();
+  ~SimDataRecorder();
+
+  /* Create file and start recording. Returns false on error. */
+  bool open(const QString& filename);
+  void close();
+  bool isOpen() const;
+
+  /* Append packet. Thread safe. Can be called from the data reader thread. */
+  void write(const atools::fs::sc::SimConnectData& data);
+
+  QString getErrorString() const;
+
+private:
+  mutable QMutex mutex;
+  QFile file;
+  QDataStream stream;
+  QElapsedTimer timer;
+  QByteArray lastPacket;
+  qint64 lastTimeMs = 0;
+  int numPackets = 0;
+  QString errorString;
+};
+
+/*
+ * Replays a file written by SimDataRecorder and emits the packets like the DataReaderThread.
+ * Runs in the event loop using a timer.
+ * Each packet is also sent through the delta codec and compared if Options/SimDataCodecCheck is enabled.
+ */
+class SimDataReplay :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  SimDataReplay(QObject *parent);
+  virtual ~SimDataReplay();
+
+  /* Start replay. speed is the factor for the recorded times or 0 to emit packets as fast as possible
+   * while still processing events. Returns false if the file cannot be read. */
+  bool start(const QString& filename, int speed);
+
+  /* Stop replay and emit finished */
+  void stop();
+  bool isActive() const;
+
+  QString getErrorString() const
+  {
+    return errorString;
+  }
+
+signals:
+  /* Emitted for each recorded packet */
+  void postSimConnectData(atools::fs::sc::SimConnectData dataPacket);
+
+  /* Emitted at the end of the file, on error or when stopped */
+  void finished();
+
+private:
+  /* Emit all packets which are due and start timer for the next one */
+  void replayNext();
+
+  /* Read next record into nextData and nextTimeMs. Returns false at end of file or on error. */
+  bool readRecord();
+
+  QFile file;
+  QDataStream stream;
+  QTimer timer;
+  QElapsedTimer clock;
+  QByteArray lastPacket;
+  atools::fs::sc::SimConnectData nextData;
+
+  /* Time of nextData since start of recording */
+  qint64 nextTimeMs = 0;
+  int speed = 1;
+  QString errorString;
+
+  SimDataCodecCheck codecCheck;
+  bool checkCodec = false;
+};
+
+#endif // LITTLENAVMAP_SIMDATARECORDER_H
@@ -24,6 +24,7 @@
 #include "gui/application.h"
 #include "common/weatherreporter.h"
 #include "connect/connectclient.h"
+#include "connect/simdatahub.h"
 #include "common/elevationprovider.h"
 #include "db/databasemanager.h"
 #include "gui/dialog.h"
@@ -52,6 +53,8 @@
 #include "route/routestring.h"
 #include "common/unit.h"
 #include "common/procedurequery.h"
+#include "common/memorycache.h"
+#include "common/symbolatlas.h"
 #include "search/proceduresearch.h"
 #include "gui/airspacetoolbarhandler.h"
 
@@ -67,6 +70,7 @@
 #include <QWindow>
 #include <QDesktopWidget>
 #include <QDir>
+#include <QInputDialog>
 #include <QFileInfoList>
 
 #include "ui_mainwindow.h"
@@ -613,6 +617,11 @@ void MainWindow::connectAllSlots()
   connect(optionsDialog, &OptionsDialog::optionsChanged, weatherReporter, &WeatherReporter::optionsChanged);
   connect(optionsDialog, &OptionsDialog::optionsChanged, searchController, &SearchController::optionsChanged);
   connect(optionsDialog, &OptionsDialog::optionsChanged, map::updateUnits);
+  connect(optionsDialog, &OptionsDialog::optionsChanged, []()
+  {
+    // Style or colors might have changed
+    SymbolAtlas::instance().clear();
+  });
   connect(optionsDialog, &OptionsDialog::optionsChanged, routeController, &RouteController::optionsChanged);
   connect(optionsDialog, &OptionsDialog::optionsChanged, infoController, &InfoController::optionsChanged);
   connect(optionsDialog, &OptionsDialog::optionsChanged, mapWidget, &MapWidget::optionsChanged);
@@ -673,6 +682,12 @@ void MainWindow::connectAllSlots()
 
   connect(ui->actionOptions, &QAction::triggered, this, &MainWindow::options);
   connect(ui->actionResetMessages, &QAction::triggered, this, &MainWindow::resetMessages);
+  connect(ui->actionCacheStatistics, &QAction::triggered, this, &MainWindow::showCacheStatistics);
+  connect(ui->actionMapShowPaintStatistics, &QAction::toggled, mapWidget, &MapWidget::setShowPaintStatistics);
+  connect(ui->actionMapSavePaintStatistics, &QAction::triggered, this, &MainWindow::savePaintStatistics);
+  connect(ui->actionConnectRecord, &QAction::triggered, this, &MainWindow::recordSimulatorData);
+  connect(ui->actionConnectReplay, &QAction::triggered, this, &MainWindow::replaySimulatorData);
+  connect(ui->actionConnectGenerateTraffic, &QAction::triggered, this, &MainWindow::generateAiTraffic);
 
   // Flight plan file actions
   connect(ui->actionRouteCenter, &QAction::triggered, this, &MainWindow::routeCenter);
@@ -854,11 +869,24 @@ void MainWindow::connectAllSlots()
   connect(ui->actionConnectSimulator, &QAction::triggered, connectClient, &ConnectClient::connectToServerDialog);
 
   // Deliver first to route controller to update active leg and distances
-  connect(connectClient, &ConnectClient::dataPacketReceived, routeController, &RouteController::simDataChanged);
-
-  connect(connectClient, &ConnectClient::dataPacketReceived, mapWidget, &MapWidget::simDataChanged);
-  connect(connectClient, &ConnectClient::dataPacketReceived, profileWidget, &ProfileWidget::simDataChanged);
-  connect(connectClient, &ConnectClient::dataPacketReceived, infoController, &InfoController::simulatorDataReceived);
+  SimDataHub *simDataHub = connectClient->getSimDataHub();
+  simDataHub->addConsumer([this](const atools::fs::sc::SimConnectData& data)
+                          {
+                            routeController->simDataChanged(data);
+                          }, RouteController::MIN_SIM_UPDATE_TIME_MS);
+
+  simDataHub->addConsumer([this](const atools::fs::sc::SimConnectData& data)
+                          {
+                            mapWidget->simDataChanged(data);
+                          });
+  simDataHub->addConsumer([this](const atools::fs::sc::SimConnectData& data)
+                          {
+                            profileWidget->simDataChanged(data);
+                          });
+  simDataHub->addConsumer([this](const atools::fs::sc::SimConnectData& data)
+                          {
+                            infoController->simulatorDataReceived(data);
+                          }, InfoController::MIN_SIM_UPDATE_TIME_MS);
 
   connect(connectClient, &ConnectClient::disconnectedFromSimulator, routeController,
           &RouteController::disconnectedFromSimulator);
@@ -1000,6 +1028,127 @@ void MainWindow::updateLegend()
 }
 
 /* Menu item */
+/* Show memory usage and hit rates of the database caches and print them to the log */
+void MainWindow::showCacheStatistics()
+{
+  memcache::CacheBudget& budget = memcache::CacheBudget::instance();
+  budget.logStatistics();
+  QMessageBox::information(this, QApplication::applicationName(), budget.getStatisticsHtml());
+}
+
+void MainWindow::savePaintStatistics()
+{
+  QString filename = dialog->saveFileDialog(
+    tr("Save Map Paint Statistics"),
+    tr("CSV Files (*.csv);;All Files (*)"),
+    "csv", "PaintStatistics/",
+    QStandardPaths::standardLocations(QStandardPaths::DocumentsLocation).first(),
+    "littlenavmap_paint_statistics.csv");
+
+  if(!filename.isEmpty())
+  {
+    if(mapWidget->savePaintStatistics(filename))
+      setStatusMessage(tr("Map paint statistics saved."));
+    else
+      QMessageBox::warning(this, QApplication::applicationName(),
+                           tr("Error writing map paint statistics to \"%1\".").arg(filename));
+  }
+}
+
+void MainWindow::recordSimulatorData(bool checked)
+{
+  ConnectClient *connectClient = NavApp::getConnectClient();
+  if(checked)
+  {
+    QString filename = dialog->saveFileDialog(
+      tr("Record Simulator Data"),
+      tr("Simulator Data Recordings (*.lnmrec);;All Files (*)"),
+      "lnmrec", "SimDataRecording/",
+      QStandardPaths::standardLocations(QStandardPaths::DocumentsLocation).first(),
+      "littlenavmap_recording.lnmrec");
+
+    if(!filename.isEmpty() && connectClient->startRecording(filename))
+      setStatusMessage(tr("Recording simulator data."));
+  }
+  else
+  {
+    connectClient->stopRecording();
+    setStatusMessage(tr("Simulator data recording stopped."));
+  }
+  ui->actionConnectRecord->setChecked(connectClient->isRecording());
+}
+
+void MainWindow::replaySimulatorData(bool checked)
+{
+  ConnectClient *connectClient = NavApp::getConnectClient();
+  if(checked)
+  {
+    QString filename = dialog->openFileDialog(
+      tr("Replay Simulator Data"),
+      tr("Simulator Data Recordings (*.lnmrec);;All Files (*)"),
+      "SimDataRecording/",
+      QStandardPaths::standardLocations(QStandardPaths::DocumentsLocation).first());
+
+    if(!filename.isEmpty())
+    {
+      // Factor for recorded packet times - 0 is as fast as possible
+      static const QVector<int> SPEEDS({1, 2, 4, 8, 16, 32, 64, 0});
+      QStringList speedTexts;
+      for(int speed : SPEEDS)
+        speedTexts.append(speed > 0 ? tr("%1x").arg(speed) : tr("As fast as possible"));
+
+      bool ok = false;
+      QString speedText = QInputDialog::getItem(this, QApplication::applicationName(), tr("Replay speed:"),
+                                                speedTexts, 0, false, &ok);
+      if(ok)
+        connectClient->startReplay(filename, SPEEDS.at(speedTexts.indexOf(speedText)));
+    }
+  }
+  else
+    connectClient->stopReplay();
+
+  ui->actionConnectReplay->setChecked(connectClient->isReplaying());
+}
+
+void MainWindow::generateAiTraffic(bool checked)
+{
+  ConnectClient *connectClient = NavApp::getConnectClient();
+  if(checked)
+  {
+    bool ok = false;
+    int numAircraft = QInputDialog::getInt(this, QApplication::applicationName(),
+                                           tr("Number of AI aircraft:"), 1000, 1, 20000, 100, &ok);
+    if(ok)
+    {
+      // Use flight plan airports or map center
+      QVector<atools::geo::Pos> airports;
+      for(int i = 0; i < NavApp::getRoute().size(); i++)
+      {
+        const RouteLeg& leg = NavApp::getRoute().at(i);
+        if(leg.getMapObjectType() == map::AIRPORT)
+          airports.append(leg.getPosition());
+      }
+      if(airports.isEmpty())
+        airports.append(atools::geo::Pos(mapWidget->centerLongitude(), mapWidget->centerLatitude()));
+
+      connectClient->getSimDataHub()->resetStatistics();
+      if(connectClient->startTrafficGenerator(airports, numAircraft))
+        // Show frame times while running
+        ui->actionMapShowPaintStatistics->setChecked(true);
+    }
+  }
+  else
+  {
+    connectClient->stopTrafficGenerator();
+
+    QStringList report(connectClient->getSimDataHub()->getStatisticsText());
+    report.append(mapWidget->getPaintStatisticsText());
+    QMessageBox::information(this, QApplication::applicationName(), report.join("<br/>"));
+  }
+
+  ui->actionConnectGenerateTraffic->setChecked(connectClient->isTrafficGeneratorActive());
+}
+
 void MainWindow::showDatabaseFiles()
 {
   QUrl url = QUrl::fromLocalFile(NavApp::getDatabaseManager()->getDatabaseDirectory());
@@ -1851,6 +2000,10 @@ void MainWindow::updateActionStates()
 
   ui->actionShowStatusbar->setChecked(!ui->statusBar->isHidden());
 
+  // Replay might have reached the end of the file
+  ui->actionConnectReplay->setChecked(NavApp::getConnectClient()->isReplaying());
+  ui->actionConnectGenerateTraffic->setChecked(NavApp::getConnectClient()->isTrafficGeneratorActive());
+
   ui->actionClearKml->setEnabled(!mapWidget->getKmlFiles().isEmpty());
 
   ui->actionReloadScenery->setEnabled(NavApp::getDatabaseManager()->hasInstalledSimulators());
@@ -202,6 +202,11 @@ private:
   bool routeValidate(bool validateParking = true);
   void showMapLegend();
   void resetMessages();
+  void showCacheStatistics();
+  void savePaintStatistics();
+  void recordSimulatorData(bool checked);
+  void replaySimulatorData(bool checked);
+  void generateAiTraffic(bool checked);
   void showDatabaseFiles();
   void mapSaveImage();
   void distanceChanged();
@@ -289,6 +289,8 @@ void InfoController::updateAirportInternal(bool newAirport)
   if(databaseLoadStatus)
     return;
 
+  memcache::CachePin cachePin;
+
   if(!currentSearchResult.airports.isEmpty())
   {
     map::WeatherContext currentWeatherContext;
@@ -358,6 +360,9 @@ void InfoController::showInformationInternal(const map::MapSearchResult& result,
 {
   qDebug() << Q_FUNC_INFO;
 
+  // Information pages are assembled from records of several caches
+  memcache::CachePin cachePin;
+
   bool foundAirport = false, foundNavaid = false, foundUserAircraft = false, foundAiAircraft = false,
        foundAirspace = false;
   HtmlBuilder html(true);
@@ -673,32 +678,27 @@ void InfoController::updateAiAircraftText()
     ui->textBrowserAircraftAiInfo->clear();
 }
 
-void InfoController::simulatorDataReceived(atools::fs::sc::SimConnectData data)
+/* Called by the SimDataHub not more often than MIN_SIM_UPDATE_TIME_MS */
+void InfoController::simulatorDataReceived(const atools::fs::sc::SimConnectData& data)
 {
   if(databaseLoadStatus)
     return;
 
-  if(atools::almostNotEqual(QDateTime::currentDateTime().toMSecsSinceEpoch(),
-                            lastSimUpdate, static_cast<qint64>(MIN_SIM_UPDATE_TIME_MS)))
-  {
-    // Last update was more than 500 ms ago
-    updateAiAirports(data);
+  updateAiAirports(data);
 
-    Ui::MainWindow *ui = NavApp::getMainUi();
+  Ui::MainWindow *ui = NavApp::getMainUi();
 
-    lastSimData = data;
-    if(data.getUserAircraft().getPosition().isValid() && ui->dockWidgetAircraft->isVisible())
-    {
-      if(ui->tabWidgetAircraft->currentIndex() == ic::AIRCRAFT_USER)
-        updateAircraftText();
+  lastSimData = data;
+  if(data.getUserAircraft().getPosition().isValid() && ui->dockWidgetAircraft->isVisible())
+  {
+    if(ui->tabWidgetAircraft->currentIndex() == ic::AIRCRAFT_USER)
+      updateAircraftText();
 
-      if(ui->tabWidgetAircraft->currentIndex() == ic::AIRCRAFT_USER_PROGRESS)
-        updateAircraftProgressText();
+    if(ui->tabWidgetAircraft->currentIndex() == ic::AIRCRAFT_USER_PROGRESS)
+      updateAircraftProgressText();
 
-      if(ui->tabWidgetAircraft->currentIndex() == ic::AIRCRAFT_AI)
-        updateAiAircraftText();
-    }
-    lastSimUpdate = QDateTime::currentDateTime().toMSecsSinceEpoch();
+    if(ui->tabWidgetAircraft->currentIndex() == ic::AIRCRAFT_AI)
+      updateAiAircraftText();
   }
 }
 
@@ -738,7 +738,6 @@ void InfoController::disconnectedFromSimulator()
 {
   qDebug() << Q_FUNC_INFO;
   lastSimData = atools::fs::sc::SimConnectData();
-  lastSimUpdate = 0;
   updateAircraftInfo();
 }
 
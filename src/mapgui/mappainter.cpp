@@ -21,9 +21,11 @@
 #include "common/symbolpainter.h"
 #include "geo/calculations.h"
 #include "mapgui/mapwidget.h"
+#include "common/greatcirclecache.h"
 
 #include <marble/GeoDataLineString.h>
 #include <marble/GeoPainter.h>
+#include <marble/ViewportParams.h>
 
 using namespace Marble;
 using namespace atools::geo;
@@ -63,6 +65,18 @@ MapPainter::~MapPainter()
   delete symbolPainter;
 }
 
+float MapPainter::clusterCellSizeDeg() const
+{
+  // One degree latitude is 60 NM
+  float pixelPerDeg = scale->getPixelForNm(60.f, 0.f);
+  if(!(pixelPerDeg > 0.f))
+    return 1.f;
+
+  // Round to the next power of two with half steps
+  float cellSize = PaintContext::CLUSTER_CELL_SIZE_PIXEL / pixelPerDeg;
+  return std::pow(2.f, std::round(std::log2(cellSize) * 2.f) / 2.f);
+}
+
 void MapPainter::paintCircle(GeoPainter *painter, const Pos& centerPos, int radiusNm, bool fast,
                              int& xtext, int& ytext)
 {
@@ -191,16 +205,65 @@ void MapPainter::drawLineString(const PaintContext *context, const atools::geo::
 
 void MapPainter::drawLine(const PaintContext *context, const atools::geo::Line& line)
 {
-  if(line.isValid())
+  QVector<QPolygonF> polylines;
+  greatCircleToScreen(line, polylines);
+  drawPolylines(context->painter, polylines);
+}
+
+void MapPainter::greatCircleToScreen(const atools::geo::Line& line, QVector<QPolygonF>& polylines) const
+{
+  polylines.clear();
+  if(!line.isValid())
+    return;
+
+  const ViewportParams *viewport = getViewport();
+  QRectF screenRect(0., 0., viewport->width(), viewport->height());
+
+  // Jumps larger than half of the world width are caused by Mercator repetitions
+  bool mercator = viewport->projection() == Marble::Mercator;
+  double maxJump = 2. * viewport->radius();
+
+  QPolygonF points;
+  QVector<bool> hidden;
+  for(const LineString& part : GreatCircleCache::instance().getLine(line.getPos1(), line.getPos2()))
   {
-    GeoDataLineString ls;
-    ls.setTessellate(true);
-    ls << GeoDataCoordinates(line.getPos1().getLonX(), line.getPos1().getLatY(), 0, DEG)
-       << GeoDataCoordinates(line.getPos2().getLonX(), line.getPos2().getLatY(), 0, DEG);
-    context->painter->drawPolyline(ls);
+    wToS(part, points, nullptr, DEFAULT_WTOS_SIZE, &hidden);
+
+    // Collect runs of visible segments
+    QPolygonF polyline;
+    for(int i = 1; i < points.size(); i++)
+    {
+      const QPointF& p1 = points.at(i - 1);
+      const QPointF& p2 = points.at(i);
+
+      bool visible = !hidden.at(i - 1) && !hidden.at(i) &&
+                     !(mercator && std::abs(p2.x() - p1.x()) > maxJump) &&
+                     QRectF(p1, p2).normalized().adjusted(-1., -1., 1., 1.).intersects(screenRect);
+
+      if(visible)
+      {
+        if(polyline.isEmpty())
+          polyline.append(p1);
+        polyline.append(p2);
+      }
+      else if(!polyline.isEmpty())
+      {
+        polylines.append(polyline);
+        polyline.clear();
+      }
+    }
+
+    if(!polyline.isEmpty())
+      polylines.append(polyline);
   }
 }
 
+void MapPainter::drawPolylines(QPainter *painter, const QVector<QPolygonF>& polylines)
+{
+  for(const QPolygonF& polyline : polylines)
+    painter->drawPolyline(polyline);
+}
+
 void MapPainter::paintArc(QPainter *painter, const QPointF& p1, const QPointF& p2, const QPointF& center, bool left)
 {
   QRectF arcRect;
@@ -26,6 +26,7 @@
 #include <marble/MarbleWidget.h>
 #include <QPen>
 #include <QApplication>
+#include <QElapsedTimer>
 
 namespace atools {
 namespace geo {
@@ -39,11 +40,26 @@ class GeoPainter;
 }
 
 class SymbolPainter;
+class LabelPlacement;
 class MapLayer;
 class MapQuery;
 class MapScale;
 class MapWidget;
 
+/* Screen area covered by the user aircraft and the newest track segment in the last frame.
+ * Filled by the vehicle painters and used by the map widget to repaint only the changed region. */
+struct VehiclePaintBounds
+{
+  /* Aircraft symbol, track line, label and wind pointer. Null if the aircraft was not painted. */
+  QRect userAircraft;
+  QPointF userAircraftPos;
+
+  /* Screen position where the newest painted track segment starts. Null if no track was painted. */
+  QPointF trackTail;
+  int trackSize = 0;
+  quint32 trackGeneration = 0;
+};
+
 /* Struct that is passed on each paint event to all painters */
 struct PaintContext
 {
@@ -64,6 +80,15 @@ struct PaintContext
 
   opts::DisplayOptions dispOpts;
 
+  /* Seconds since the last simulator packet used to extrapolate vehicle positions. 0 disables extrapolation. */
+  float simDataExtrapolationSec = 0.f;
+
+  /* Filled by vehicle painters. Can be null. */
+  VehiclePaintBounds *vehicleBounds = nullptr;
+
+  /* Frame local index of placed text labels to avoid overlapping texts. Can be null. */
+  LabelPlacement *labelPlacement = nullptr;
+
   float textSizeAircraftAi = 1.f;
   float symbolSizeNavaid = 1.f;
   float thicknessFlightplan = 1.f;
@@ -80,17 +105,54 @@ struct PaintContext
   // Needs to be larger than number of highest level airports
   static Q_DECL_CONSTEXPR int MAX_OBJECT_COUNT = 2500;
   int objectCount = 0;
+
+  /* Painters stop adding objects once the frame took longer than this. 0 means no limit.
+   * Started when painting begins. */
+  qint64 timeBudgetMs = 0;
+  QElapsedTimer frameTimer;
+  bool timeBudgetExceeded = false;
+
+  /* Count an object and return true if painting should stop */
   bool objCount()
   {
     objectCount++;
-    return objectCount > MAX_OBJECT_COUNT;
+
+    // Look at the clock only every 16 objects
+    if((objectCount & 0xf) == 0)
+      checkTimeBudget();
+    return objectCount > MAX_OBJECT_COUNT || timeBudgetExceeded;
   }
 
+  /* true if either object count or time budget is exceeded */
   bool isOverflow()
+  {
+    checkTimeBudget();
+    return objectCount > MAX_OBJECT_COUNT || timeBudgetExceeded;
+  }
+
+  bool isObjectCountOverflow() const
   {
     return objectCount > MAX_OBJECT_COUNT;
   }
 
+  bool isTimeBudgetExceeded()
+  {
+    checkTimeBudget();
+    return timeBudgetExceeded;
+  }
+
+  void checkTimeBudget()
+  {
+    if(!timeBudgetExceeded && timeBudgetMs > 0 && frameTimer.hasExpired(timeBudgetMs))
+      timeBudgetExceeded = true;
+  }
+
+  /* Airports or waypoints are aggregated into grid clusters if the number of loaded objects exceeds this value */
+  static Q_DECL_CONSTEXPR int MIN_CLUSTER_OBJECT_COUNT = 1000;
+
+  /* Approximate size of a cluster grid cell on the screen */
+  static Q_DECL_CONSTEXPR int CLUSTER_CELL_SIZE_PIXEL = 24;
+
   bool  dOpt(const opts::DisplayOptions& opts) const
   {
     return dispOpts & opts;
@@ -154,8 +216,18 @@ protected:
 
   void drawLineString(const PaintContext *context, const Marble::GeoDataLineString& linestring);
   void drawLineString(const PaintContext *context, const atools::geo::LineString& linestring);
+  /* Draw a great circle line using the densified points from the GreatCircleCache */
   void drawLine(const PaintContext *context, const atools::geo::Line& line);
 
+  /* Convert a densified great circle line to screen polylines. Parts hidden behind the globe
+   * or outside of the screen are left out. */
+  void greatCircleToScreen(const atools::geo::Line& line, QVector<QPolygonF>& polylines) const;
+  void drawPolylines(QPainter *painter, const QVector<QPolygonF>& polylines);
+
+  /* Get the cluster grid cell size in degree for the current zoom distance. The value is quantized to
+   * avoid rebuilding the cluster caches on small zoom changes. */
+  float clusterCellSizeDeg() const;
+
   void paintArc(QPainter *painter, const QPointF& p1, const QPointF& p2, const QPointF& center, bool left);
 
   void paintHoldWithText(QPainter *painter, float x, float y, float direction, float lengthNm, float minutes, bool left,
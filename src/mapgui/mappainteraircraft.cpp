@@ -56,19 +56,20 @@ void MapPainterAircraft::render(PaintContext *context)
     // Draw AI aircraft
     if(context->objectTypes & map::AIRCRAFT_AI && context->mapLayer->isAiAircraftLarge())
     {
-      for(const SimConnectAircraft& ac : mapWidget->getAiAircraft())
-      {
-        if(ac.getCategory() != atools::fs::sc::BOAT &&
-           (ac.getModelRadius() * 2 > layer::LARGE_AIRCRAFT_SIZE || context->mapLayer->isAiAircraftSmall()) &&
-           (!ac.isOnGround() || context->mapLayer->isAiAircraftGround()))
-          paintAiVehicle(context, ac);
-      }
+      bool small = context->mapLayer->isAiAircraftSmall(), ground = context->mapLayer->isAiAircraftGround();
+      paintAiVehicles(context, [small, ground](const SimConnectAircraft& ac) -> bool
+                      {
+                        return ac.getCategory() != atools::fs::sc::BOAT &&
+                        (ac.getModelRadius() * 2 > layer::LARGE_AIRCRAFT_SIZE || small) &&
+                        (!ac.isOnGround() || ground);
+                      }, small | (ground << 1));
     }
 
     if(context->objectTypes.testFlag(map::AIRCRAFT))
     {
       const atools::fs::sc::SimConnectUserAircraft& userAircraft = mapWidget->getUserAircraft();
-      const atools::geo::Pos& pos = userAircraft.getPosition();
+      const atools::geo::Pos pos = extrapolatePosition(userAircraft, userAircraft.getTrackDegTrue(),
+                                                       context->simDataExtrapolationSec);
 
       if(pos.isValid())
       {
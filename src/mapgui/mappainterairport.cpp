@@ -18,6 +18,8 @@
 #include "mapgui/mappainterairport.h"
 
 #include "common/symbolpainter.h"
+#include "common/labelplacement.h"
+#include "common/geometrybatch.h"
 #include "mapgui/mapscale.h"
 #include "mapgui/maplayer.h"
 #include "mapgui/mapquery.h"
@@ -28,6 +30,8 @@
 #include "mapgui/mapwidget.h"
 #include "route/routecontroller.h"
 #include "util/paintercontextsaver.h"
+#include "settings/settings.h"
+#include "common/constants.h"
 
 #include <QElapsedTimer>
 
@@ -38,18 +42,40 @@ using namespace Marble;
 using namespace atools::geo;
 using namespace map;
 
+uint qHash(const MapPainterAirport::DiagramTileKey& key)
+{
+  return static_cast<uint>(key.airportId) ^ (static_cast<uint>(key.tileX) << 20) ^
+         (static_cast<uint>(key.tileY) << 26) ^ static_cast<uint>(key.radius);
+}
+
+bool MapPainterAirport::DiagramTileKey::operator==(const DiagramTileKey& other) const
+{
+  return airportId == other.airportId && tileX == other.tileX && tileY == other.tileY && radius == other.radius &&
+         projection == other.projection && pixelRatio == other.pixelRatio && layer == other.layer &&
+         fast == other.fast;
+}
+
 MapPainterAirport::MapPainterAirport(MapWidget *mapWidget, MapQuery *mapQuery, MapScale *mapScale,
                                      const Route *routeParam)
   : MapPainter(mapWidget, mapQuery, mapScale), route(routeParam)
 {
+  diagramCache.setMaxCost(atools::settings::Settings::instance().getAndStoreValue(
+                            lnm::SETTINGS_MAPPAINTLAYER + "AirportDiagramCacheMb", 128).toInt() * 1024);
 }
 
 MapPainterAirport::~MapPainterAirport()
 {
 }
 
+void MapPainterAirport::clearDiagramCache()
+{
+  diagramCache.clear();
+}
+
 void MapPainterAirport::render(PaintContext *context)
 {
+  symbolPainter->setLabelPlacement(context->labelPlacement, LabelPlacement::PRIORITY_AIRPORT);
+
   // Get all airports from the route and add them to the map
   QHash<int, const MapAirport *> airportMap; // Collect all airports from route and bounding rectangle
   QSet<int> routeAirportIds; // Airport ids from departure and destination
@@ -81,8 +107,26 @@ void MapPainterAirport::render(PaintContext *context)
   else
     airportCache = query->getAirports(curBox, context->mapLayer, context->lazyUpdate);
 
-  for(const MapAirport& ap : *airportCache)
-    airportMap.insert(ap.id, &ap);
+  // Use grid clusters instead of single airports if too many are loaded for the zoom distance
+  QHash<int, int> clusterCounts; // Number of airports for each cluster representative id
+  if(!context->mapLayerEffective->isAirportDiagram() && context->objectTypes.testFlag(map::AIRPORT) &&
+     context->mapLayer->isAirport() && airportCache->size() > PaintContext::MIN_CLUSTER_OBJECT_COUNT)
+  {
+    const QList<map::MapObjectCluster> *clusters =
+      query->getAirportClusters(clusterCellSizeDeg(), context->objectTypes, context->mapLayer->getMinRunwayLength());
+
+    for(const map::MapObjectCluster& cluster : *clusters)
+    {
+      const MapAirport& ap = airportCache->at(cluster.index);
+      airportMap.insert(ap.id, &ap);
+      clusterCounts.insert(ap.id, cluster.count);
+    }
+  }
+  else
+  {
+    for(const MapAirport& ap : *airportCache)
+      airportMap.insert(ap.id, &ap);
+  }
 
   if(airportMap.isEmpty())
     // Nothing found in bounding rectangle and route
@@ -119,7 +163,10 @@ void MapPainterAirport::render(PaintContext *context)
   {
     // In diagram mode draw background first to avoid overwriting other airports
     for(const MapAirport *airport : visibleAirports)
-      drawAirportDiagramBackround(context, *airport);
+    {
+      if(!drawAirportDiagramCached(context, *airport, true /* background */))
+        drawAirportDiagramBackround(context, *airport);
+    }
   }
 
   // Draw the diagrams first
@@ -129,7 +176,14 @@ void MapPainterAirport::render(PaintContext *context)
 
     // Airport diagram is not influenced by detail level
     if(context->mapLayerEffective->isAirportDiagram())
-      drawAirportDiagram(context, *airport, context->drawFast);
+    {
+      // Diagrams are expensive - leave the rest for the refinement pass but always draw one
+      if(i > 0 && context->isTimeBudgetExceeded())
+        break;
+
+      if(!drawAirportDiagramCached(context, *airport, false /* background */))
+        drawAirportDiagram(context, *airport, context->drawFast);
+    }
   }
 
   // Add airport symbols on top of diagrams
@@ -139,13 +193,17 @@ void MapPainterAirport::render(PaintContext *context)
     const QPointF& pt = visiblePoints.at(i);
     const MapLayer *layer = context->mapLayer;
 
+    int clusterCount = clusterCounts.value(airport->id, 1);
+
     // Airport diagram is not influenced by detail level
-    if(!context->mapLayerEffective->isAirportDiagram())
+    if(!context->mapLayerEffective->isAirportDiagram() && clusterCount == 1)
       // Draw simplificated runway lines
       drawAirportSymbolOverview(context, *airport, pt.x(), pt.y());
 
     // More detailed symbol will be drawn by the route painter - so skip here
-    if(!routeAirportIds.contains(airport->id))
+    if(clusterCount > 1 && !routeAirportIds.contains(airport->id))
+      drawAirportCluster(context, *airport, clusterCount, pt.x(), pt.y());
+    else if(!routeAirportIds.contains(airport->id))
     {
       // if(context->dOpt(opts::ITEM_AIRPORT_WIND_POINTER))
       // drawWindPointer(context, *airport, pt.x(), pt.y());
@@ -174,6 +232,145 @@ void MapPainterAirport::render(PaintContext *context)
   }
 }
 
+/* Index of the tile containing the pixel relative to the airport center */
+static int diagramTileIndex(int pixel, int tileSize)
+{
+  return static_cast<int>(std::floor(static_cast<double>(pixel) / tileSize));
+}
+
+bool MapPainterAirport::drawAirportDiagramCached(const PaintContext *context, const map::MapAirport& airport,
+                                                 bool background)
+{
+  // Tiles are anchored at the center of the airport
+  double x, y;
+  bool hidden;
+  wToS(airport.bounding.getCenter(), x, y, DEFAULT_WTOS_SIZE, &hidden);
+  if(hidden)
+    return false;
+
+  // Use full pixels to avoid gaps between tiles
+  QPoint origin(static_cast<int>(std::round(x)), static_cast<int>(std::round(y)));
+
+  // Screen size of the airport plus space for background and texts - returns double size
+  QSize airportSize = scale->getScreeenSizeForRect(airport.bounding) / 2;
+  int margin = scale->getPixelIntForMeter(AIRPORT_DIAGRAM_BACKGROUND_METER) + DIAGRAM_IMAGE_MARGIN;
+  int halfWidth = airportSize.width() / 2 + margin, halfHeight = airportSize.height() / 2 + margin;
+  QRect airportRect(-halfWidth, -halfHeight, halfWidth * 2, halfHeight * 2);
+
+  // Render and keep only the part of the airport covered by the viewport
+  QRect visibleRect = airportRect & QRect(-origin, context->viewport->size());
+  if(visibleRect.isEmpty())
+    return true;
+
+  DiagramTileKey key;
+  key.airportId = airport.id;
+  key.radius = context->viewport->radius();
+  key.projection = context->viewport->projection();
+  key.pixelRatio = context->painter->device()->devicePixelRatio();
+  key.layer = context->mapLayerEffective;
+  key.fast = context->drawFast;
+
+  int tileX1 = diagramTileIndex(visibleRect.left(), DIAGRAM_TILE_SIZE);
+  int tileX2 = diagramTileIndex(visibleRect.right(), DIAGRAM_TILE_SIZE);
+  int tileY1 = diagramTileIndex(visibleRect.top(), DIAGRAM_TILE_SIZE);
+  int tileY2 = diagramTileIndex(visibleRect.bottom(), DIAGRAM_TILE_SIZE);
+
+  // Collect tiles not rendered yet for this zoom distance
+  QVector<DiagramTileKey> keys, missing;
+  for(key.tileY = tileY1; key.tileY <= tileY2; key.tileY++)
+  {
+    for(key.tileX = tileX1; key.tileX <= tileX2; key.tileX++)
+    {
+      keys.append(key);
+      if(!diagramCache.contains(key))
+        missing.append(key);
+    }
+  }
+
+  if(!missing.isEmpty())
+    renderDiagramTiles(context, airport, airportRect, missing);
+
+  // Look up all tiles first since the cache might have dropped some if the viewport is larger than the cache
+  QVector<const DiagramTile *> tiles;
+  for(const DiagramTileKey& tileKey : keys)
+  {
+    const DiagramTile *tile = diagramCache.object(tileKey);
+    if(tile == nullptr)
+      return false;
+    tiles.append(tile);
+  }
+
+  for(int i = 0; i < keys.size(); i++)
+  {
+    const QImage& img = background ? tiles.at(i)->background : tiles.at(i)->diagram;
+    context->painter->drawImage(origin + QPoint(keys.at(i).tileX, keys.at(i).tileY) * DIAGRAM_TILE_SIZE, img);
+  }
+  return true;
+}
+
+void MapPainterAirport::renderDiagramTiles(const PaintContext *context, const map::MapAirport& airport,
+                                           const QRect& airportRect, const QVector<DiagramTileKey>& keys)
+{
+  const ViewportParams *viewport = context->viewport;
+  int pixelRatio = keys.first().pixelRatio;
+
+  // Draw the airport only once for all tiles
+  QRect rect;
+  for(const DiagramTileKey& key : keys)
+    rect |= QRect(key.tileX * DIAGRAM_TILE_SIZE, key.tileY * DIAGRAM_TILE_SIZE, DIAGRAM_TILE_SIZE, DIAGRAM_TILE_SIZE);
+
+  // Viewport having the same zoom distance and projection but centered on the airport
+  const Pos center = airport.bounding.getCenter();
+  ViewportParams imageViewport(viewport->projection(), atools::geo::toRadians(center.getLonX()),
+                               atools::geo::toRadians(center.getLatY()), viewport->radius(), airportRect.size());
+
+  const ViewportParams *contextViewport = getViewport();
+  setViewport(&imageViewport);
+
+  PaintContext imageContext = *context;
+  imageContext.viewport = &imageViewport;
+
+  QImage background, diagram;
+  for(QImage *img : {&background, &diagram})
+  {
+    *img = QImage(rect.size() * pixelRatio, QImage::Format_ARGB32_Premultiplied);
+    img->setDevicePixelRatio(pixelRatio);
+    img->fill(Qt::transparent);
+
+    GeoPainter imagePainter(img, &imageViewport, context->painter->mapQuality());
+    imagePainter.setRenderHints(context->painter->renderHints());
+    imagePainter.setFont(context->painter->font());
+    // Move the covered part of the airport into the image
+    imagePainter.translate(airportRect.left() - rect.left(), airportRect.top() - rect.top());
+    imageContext.painter = &imagePainter;
+
+    if(img == &background)
+      drawAirportDiagramBackround(&imageContext, airport);
+    else
+      drawAirportDiagram(&imageContext, airport, context->drawFast);
+    imagePainter.end();
+  }
+
+  setViewport(contextViewport);
+
+  // Cut the image into tiles
+  for(const DiagramTileKey& key : keys)
+  {
+    QRect tileRect((QPoint(key.tileX, key.tileY) * DIAGRAM_TILE_SIZE - rect.topLeft()) * pixelRatio,
+                   QSize(DIAGRAM_TILE_SIZE, DIAGRAM_TILE_SIZE) * pixelRatio);
+
+    DiagramTile *tile = new DiagramTile;
+    tile->background = background.copy(tileRect);
+    tile->background.setDevicePixelRatio(pixelRatio);
+    tile->diagram = diagram.copy(tileRect);
+    tile->diagram.setDevicePixelRatio(pixelRatio);
+
+    // Deleted by insert if larger than the whole cache
+    int costKb = static_cast<int>((tile->background.byteCount() + tile->diagram.byteCount()) / 1024);
+    diagramCache.insert(key, tile, costKb);
+  }
+}
+
 /* Draws the full airport diagram including runway, taxiways, apron, parking and more */
 void MapPainterAirport::drawAirportDiagramBackround(const PaintContext *context,
                                                     const map::MapAirport& airport)
@@ -223,15 +420,11 @@ void MapPainterAirport::drawAirportDiagramBackround(const PaintContext *context,
 
   // For aprons
   const QList<MapApron> *aprons = query->getAprons(airport.id);
-  QVector<QPoint> points;
+  QPolygonF points;
   for(const MapApron& apron : *aprons)
   {
-    points.clear();
-    bool visible;
-    for(const Pos& pos : apron.vertices)
-      points.append(wToS(pos, DEFAULT_WTOS_SIZE, &visible));
-
-    painter->QPainter::drawPolyline(points.data(), points.size());
+    wToS(apron.vertices, points);
+    painter->QPainter::drawPolyline(points);
   }
 }
 
@@ -252,31 +445,28 @@ void MapPainterAirport::drawAirportDiagram(const PaintContext *context, const ma
   QList<QRect> runwayRects, runwayOutlineRects;
   runwayCoords(runways, &runwayCenters, &runwayRects, nullptr, &runwayOutlineRects);
 
+  // Collects lines and polygons by pen and brush to avoid state changes for each element
+  GeometryBatch batch;
+
   // Draw aprons ---------------------------------
   painter->setBackground(Qt::transparent);
   const QList<MapApron> *aprons = query->getAprons(airport.id);
-  QVector<QPoint> points;
+  QPolygonF points;
   for(const MapApron& apron : *aprons)
   {
-    points.clear();
-    bool visible;
-    for(const Pos& pos : apron.vertices)
-      points.append(wToS(pos, DEFAULT_WTOS_SIZE, &visible));
+    wToS(apron.vertices, points);
 
     // Draw aprons a bit darker so we can see the taxiways
     QColor col = mapcolors::colorForSurface(apron.surface);
     col = col.darker(110);
 
-    painter->setPen(QPen(col, 1, Qt::SolidLine, Qt::FlatCap));
-
     if(!apron.drawSurface)
       // Use pattern for transparent aprons
-      painter->setBrush(QBrush(col, Qt::Dense6Pattern));
+      batch.addPolygon(QPen(col, 1, Qt::SolidLine, Qt::FlatCap), QBrush(col, Qt::Dense6Pattern), points);
     else
-      painter->setBrush(QBrush(col));
-
-    painter->QPainter::drawPolygon(points.data(), points.size());
+      batch.addPolygon(QPen(col, 1, Qt::SolidLine, Qt::FlatCap), QBrush(col), points);
   }
+  batch.flush(painter);
 
   // Draw taxiways ---------------------------------
   painter->setBackgroundMode(Qt::OpaqueMode);
@@ -295,41 +485,39 @@ void MapPainterAirport::drawAirportDiagram(const PaintContext *context, const ma
   }
 
   // Draw closed and others first to have real taxiways on top
+  // Background color of closed taxiways
   for(int i = 0; i < taxipaths->size(); i++)
   {
     const MapTaxiPath& taxipath = taxipaths->at(i);
-    int thickness = pathThickness.at(i);
-    QColor col = mapcolors::colorForSurface(taxipath.surface);
-
-    const QPoint& start = startPts.at(i);
-    const QPoint& end = endPts.at(i);
-
     if(taxipath.closed)
-    {
-      painter->setPen(QPen(col, thickness, Qt::SolidLine, Qt::RoundCap));
-      painter->drawLine(start, end);
+      batch.addLine(QPen(mapcolors::colorForSurface(taxipath.surface), pathThickness.at(i), Qt::SolidLine,
+                         Qt::RoundCap), startPts.at(i), endPts.at(i));
+  }
+  batch.flush(painter);
 
-      painter->setPen(QPen(mapcolors::taxiwayClosedBrush, thickness, Qt::SolidLine, Qt::RoundCap));
-      painter->drawLine(start, end);
+  // Closed pattern and transparent taxiways
+  for(int i = 0; i < taxipaths->size(); i++)
+  {
+    const MapTaxiPath& taxipath = taxipaths->at(i);
+    int thickness = pathThickness.at(i);
 
-    }
+    if(taxipath.closed)
+      batch.addLine(QPen(mapcolors::taxiwayClosedBrush, thickness, Qt::SolidLine, Qt::RoundCap),
+                    startPts.at(i), endPts.at(i));
     else if(!taxipath.drawSurface)
-    {
-      painter->setPen(QPen(QBrush(col, Qt::Dense4Pattern), thickness, Qt::SolidLine, Qt::RoundCap));
-      painter->drawLine(start, end);
-    }
+      batch.addLine(QPen(QBrush(mapcolors::colorForSurface(taxipath.surface), Qt::Dense4Pattern), thickness,
+                         Qt::SolidLine, Qt::RoundCap), startPts.at(i), endPts.at(i));
   }
+  batch.flush(painter);
 
   for(int i = 0; i < taxipaths->size(); i++)
   {
     const MapTaxiPath& taxipath = taxipaths->at(i);
     if(!taxipath.closed && taxipath.drawSurface)
-    {
-      painter->setPen(QPen(mapcolors::colorForSurface(taxipath.surface),
-                           pathThickness.at(i), Qt::SolidLine, Qt::RoundCap));
-      painter->drawLine(startPts.at(i), endPts.at(i));
-    }
+      batch.addLine(QPen(mapcolors::colorForSurface(taxipath.surface), pathThickness.at(i), Qt::SolidLine,
+                         Qt::RoundCap), startPts.at(i), endPts.at(i));
   }
+  batch.flush(painter);
 
   // Draw taxiway names ---------------------------------
   if(!fast && context->mapLayerEffective->isAirportDiagramDetail())
@@ -910,6 +1098,23 @@ void MapPainterAirport::drawAirportSymbol(PaintContext *context, const map::MapA
   }
 }
 
+/* Draw aggregate symbol for a cell and the ident of the most important airport */
+void MapPainterAirport::drawAirportCluster(PaintContext *context, const map::MapAirport& ap, int count,
+                                           float x, float y)
+{
+  if(context->objCount())
+    return;
+
+  int size = context->sz(context->symbolSizeAirport, context->mapLayerEffective->getAirportSymbolSize());
+  context->szFont(context->textSizeAirport);
+  symbolPainter->drawClusterSymbol(context->painter, mapcolors::colorForAirport(ap),
+                                   static_cast<int>(x), static_cast<int>(y), size, count, context->drawFast);
+
+  if(context->mapLayer->isAirportIdent() || context->mapLayer->isAirportName())
+    symbolPainter->drawAirportText(context->painter, ap, x, y, context->dispOpts, textflags::IDENT,
+                                   size + size / 2, false /* diagram */);
+}
+
 // void MapPainterAirport::drawWindPointer(const PaintContext *context, const MapAirport& ap, int x, int y)
 // {
 // Q_UNUSED(ap);
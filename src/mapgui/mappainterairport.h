@@ -20,6 +20,9 @@
 
 #include "mapgui/mappainter.h"
 
+#include <QCache>
+#include <QImage>
+
 class SymbolPainter;
 
 namespace map {
@@ -46,8 +49,40 @@ public:
 
   virtual void render(PaintContext *context) override;
 
+  /* Remove all rendered airport diagrams. Needed if options or the database change. */
+  void clearDiagramCache();
+
 private:
+  /* Identifies a square part of an airport diagram rendered for one zoom distance. Tiles are aligned to the
+   * center of the airport bounding rectangle and tileX and tileY count tiles from there. */
+  struct DiagramTileKey
+  {
+    bool operator==(const DiagramTileKey& other) const;
+
+    int airportId, tileX, tileY, radius, projection, pixelRatio;
+    const MapLayer *layer;
+    bool fast;
+  };
+
+  friend uint qHash(const MapPainterAirport::DiagramTileKey& key);
+
+  /* Airport diagram and its background for one tile */
+  struct DiagramTile
+  {
+    QImage background, diagram;
+  };
+
+  /* Draw background or diagram tiles visible in the viewport from the cache and render missing tiles first.
+   * Returns false if the airport cannot be cached and has to be drawn directly. */
+  bool drawAirportDiagramCached(const PaintContext *context, const map::MapAirport& airport, bool background);
+
+  /* Draw the airport once into an image covering all given tiles and add the tiles to the cache.
+   * airportRect is the screen rectangle of the diagram relative to the airport center. */
+  void renderDiagramTiles(const PaintContext *context, const map::MapAirport& airport, const QRect& airportRect,
+                          const QVector<DiagramTileKey>& keys);
+
   void drawAirportSymbol(PaintContext *context, const map::MapAirport& ap, float x, float y);
+  void drawAirportCluster(PaintContext *context, const map::MapAirport& ap, int count, float x, float y);
 
   // void drawWindPointer(const PaintContext *context, const maptypes::MapAirport& ap, int x, int y);
 
@@ -64,7 +99,17 @@ private:
   static Q_DECL_CONSTEXPR int TAXIWAY_TEXT_MIN_LENGTH = 40;
   static Q_DECL_CONSTEXPR int RUNWAY_OVERVIEW_MIN_LENGTH_FEET = 8000;
   static Q_DECL_CONSTEXPR float AIRPORT_DIAGRAM_BACKGROUND_METER = 200.f;
+
+  /* Space around the airport bounding rectangle in the diagram for texts */
+  static Q_DECL_CONSTEXPR int DIAGRAM_IMAGE_MARGIN = 100;
+
+  /* Width and height of a diagram tile in pixel */
+  static Q_DECL_CONSTEXPR int DIAGRAM_TILE_SIZE = 256;
+
   const Route *route;
+
+  /* Rendered diagram tiles. Only tiles which were visible are kept. Cost is kilobytes. */
+  QCache<DiagramTileKey, DiagramTile> diagramCache;
 };
 
 #endif // LITTLENAVMAP_MAPPAINTERAIRPORT_H
@@ -33,6 +33,9 @@ using namespace Marble;
 using namespace atools::geo;
 using namespace map;
 
+/* Airspaces smaller than this are drawn as screen polygons without tessellation */
+static const float AIRSPACE_STRAIGHT_MAX_DEG = 1.f;
+
 MapPainterAirspace::MapPainterAirspace(MapWidget *mapWidget, MapQuery *mapQuery, MapScale *mapScale,
                                        const Route *routeParam)
   : MapPainter(mapWidget, mapQuery, mapScale), route(routeParam)
@@ -61,6 +64,7 @@ void MapPainterAirspace::render(PaintContext *context)
 
     painter->setBackgroundMode(Qt::TransparentMode);
 
+    QPolygonF polygon;
     for(const MapAirspace& airspace : *airspaces)
     {
       if(!(airspace.type & context->airspaceTypesByLayer))
@@ -71,9 +75,6 @@ void MapPainterAirspace::render(PaintContext *context)
         if(context->objCount())
           return;
 
-        Marble::GeoDataLinearRing linearRing;
-        linearRing.setTessellate(true);
-
         painter->setPen(mapcolors::penForAirspace(airspace));
 
         if(!context->drawFast)
@@ -81,10 +82,22 @@ void MapPainterAirspace::render(PaintContext *context)
 
         const LineString *lines = query->getAirspaceGeometry(airspace.id);
 
-        for(const Pos& pos : *lines)
-          linearRing.append(Marble::GeoDataCoordinates(pos.getLonX(), pos.getLatY(), 0, DEG));
-
-        painter->drawPolygon(linearRing);
+        // Small airspaces have short edges where the great circle is a straight line on screen.
+        // Project all points at once and draw them directly if none is hidden behind the globe.
+        if(airspace.bounding.getWidthDegree() < AIRSPACE_STRAIGHT_MAX_DEG &&
+           airspace.bounding.getHeightDegree() < AIRSPACE_STRAIGHT_MAX_DEG &&
+           wToS(*lines, polygon) == 0)
+          painter->QPainter::drawPolygon(polygon);
+        else
+        {
+          Marble::GeoDataLinearRing linearRing;
+          linearRing.setTessellate(true);
+
+          for(const Pos& pos : *lines)
+            linearRing.append(Marble::GeoDataCoordinates(pos.getLonX(), pos.getLatY(), 0, DEG));
+
+          painter->drawPolygon(linearRing);
+        }
       }
     }
   }
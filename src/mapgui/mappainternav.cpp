@@ -18,6 +18,8 @@
 #include "mapgui/mappainternav.h"
 
 #include "common/symbolpainter.h"
+#include "common/geometrybatch.h"
+#include "common/labelplacement.h"
 #include "common/mapcolors.h"
 #include "common/unit.h"
 #include "mapgui/mapwidget.h"
@@ -34,6 +36,10 @@ using namespace Marble;
 using namespace atools::geo;
 using namespace map;
 
+/* Airway segments shorter than this are drawn as straight screen lines if both ends are visible.
+ * Difference to the great circle line is below one pixel for this length. */
+static const float AIRWAY_STRAIGHT_MAX_METER = atools::geo::nmToMeter(100.f);
+
 MapPainterNav::MapPainterNav(MapWidget *mapWidget, MapQuery *mapQuery, MapScale *mapScale)
   : MapPainter(mapWidget, mapQuery, mapScale)
 {
@@ -45,6 +51,8 @@ MapPainterNav::~MapPainterNav()
 
 void MapPainterNav::render(PaintContext *context)
 {
+  symbolPainter->setLabelPlacement(context->labelPlacement, LabelPlacement::PRIORITY_NAVAID);
+
   const GeoDataLatLonAltBox& curBox = context->viewport->viewLatLonAltBox();
 
   atools::util::PainterContextSaver saver(context->painter);
@@ -114,6 +122,9 @@ void MapPainterNav::paintAirways(PaintContext *context, const QList<MapAirway> *
   // points to index or airway in airway list
   QList<int> airwayIndex;
 
+  // Collects straight segments per pen
+  GeometryBatch batch;
+
   for(int i = 0; i < airways->size(); i++)
   {
     const MapAirway& airway = airways->at(i);
@@ -123,17 +134,17 @@ void MapPainterNav::paintAirways(PaintContext *context, const QList<MapAirway> *
     if(airway.type == map::VICTOR && !context->objectTypes.testFlag(map::AIRWAYV))
       continue;
 
+    const QPen *pen = &mapcolors::airwayBothPen;
     if(airway.type == map::VICTOR)
-      context->painter->setPen(mapcolors::airwayVictorPen);
+      pen = &mapcolors::airwayVictorPen;
     else if(airway.type == map::JET)
-      context->painter->setPen(mapcolors::airwayJetPen);
-    else if(airway.type == map::BOTH)
-      context->painter->setPen(mapcolors::airwayBothPen);
+      pen = &mapcolors::airwayJetPen;
 
     // Get start and end point of airway segment in screen coordinates
     int x1, y1, x2, y2;
     bool visible1 = wToS(airway.from, x1, y1);
     bool visible2 = wToS(airway.to, x2, y2);
+    bool straight = visible1 && visible2 && airway.from.distanceMeterTo(airway.to) < AIRWAY_STRAIGHT_MAX_METER;
 
     if(!visible1 && !visible2) // Check bounding rect for visibility
     {
@@ -147,9 +158,20 @@ void MapPainterNav::paintAirways(PaintContext *context, const QList<MapAirway> *
     if(visible1 || visible2)
     {
       if(context->objCount())
+      {
+        batch.flush(context->painter);
         return;
+      }
 
-      drawLine(context, Line(airway.from, airway.to));
+      if(straight)
+        batch.addLine(*pen, QPointF(x1, y1), QPointF(x2, y2));
+      else
+      {
+        // Long or partially visible segment - draw the cached great circle after the batched lines to keep order
+        batch.flush(context->painter);
+        context->painter->setPen(*pen);
+        drawLine(context, Line(airway.from, airway.to));
+      }
 
       if(!fast)
       {
@@ -197,6 +219,8 @@ void MapPainterNav::paintAirways(PaintContext *context, const QList<MapAirway> *
     }
   }
 
+  batch.flush(context->painter);
+
   TextPlacement textPlacement(context->painter, this);
 
   // Draw texts ----------------------------------------
@@ -209,6 +233,7 @@ void MapPainterNav::paintAirways(PaintContext *context, const QList<MapAirway> *
       const MapAirway& airway = airways->at(airwayIndex.at(i));
       int xt = -1, yt = -1;
       float textBearing;
+
       if(textPlacement.findTextPos(airway.from, airway.to, metrics.width(text), metrics.height() * 2,
                                    xt, yt, &textBearing))
       {
@@ -218,17 +243,39 @@ void MapPainterNav::paintAirways(PaintContext *context, const QList<MapAirway> *
         else
           rotate = textBearing - 90.f;
 
-        context->painter->translate(xt, yt);
-        context->painter->rotate(rotate);
-        context->painter->drawText(-context->painter->fontMetrics().width(text) / 2,
-                                   context->painter->fontMetrics().ascent(), text);
-        context->painter->resetTransform();
+        if(context->labelPlacement != nullptr)
+        {
+          // Text is drawn below the position - use double height to cover it.
+          // Collision check uses the estimated width. Drawing is done after all layers are painted.
+          int textWidth = static_cast<int>(text.length() * metrics.averageCharWidth());
+          QFont font = context->painter->font();
+          context->labelPlacement->submit(LabelPlacement::rotatedRect(QPointF(xt, yt), textWidth,
+                                                                      metrics.height() * 2, rotate),
+                                          LabelPlacement::PRIORITY_AIRWAY, [ = ](QPainter *painter)
+          {
+            atools::util::PainterContextSaver textSaver(painter);
+            Q_UNUSED(textSaver);
+            painter->setFont(font);
+            painter->setPen(mapcolors::airwayTextColor);
+            drawAirwayText(painter, text, xt, yt, rotate);
+          });
+        }
+        else
+          drawAirwayText(context->painter, text, xt, yt, rotate);
       }
       i++;
     }
   }
 }
 
+void MapPainterNav::drawAirwayText(QPainter *painter, const QString& text, int x, int y, float rotate)
+{
+  painter->translate(x, y);
+  painter->rotate(rotate);
+  painter->drawText(-painter->fontMetrics().width(text) / 2, painter->fontMetrics().ascent(), text);
+  painter->resetTransform();
+}
+
 /* Draw waypoints. If airways are enabled corresponding waypoints are drawn too */
 void MapPainterNav::paintWaypoints(PaintContext *context, const QList<MapWaypoint> *waypoints,
                                    bool drawWaypoint, bool drawFast)
@@ -236,6 +283,21 @@ void MapPainterNav::paintWaypoints(PaintContext *context, const QList<MapWaypoin
   bool drawAirwayV = context->mapLayer->isAirwayWaypoint() && context->objectTypes.testFlag(map::AIRWAYV);
   bool drawAirwayJ = context->mapLayer->isAirwayWaypoint() && context->objectTypes.testFlag(map::AIRWAYJ);
 
+  if(waypoints->size() > PaintContext::MIN_CLUSTER_OBJECT_COUNT)
+  {
+    // Too many waypoints for this zoom distance - draw grid clusters instead
+    map::MapObjectTypes types = map::NONE;
+    if(drawWaypoint)
+      types |= map::WAYPOINT;
+    if(drawAirwayV)
+      types |= map::AIRWAYV;
+    if(drawAirwayJ)
+      types |= map::AIRWAYJ;
+
+    paintWaypointClusters(context, waypoints, types, drawFast);
+    return;
+  }
+
   for(const MapWaypoint& waypoint : *waypoints)
   {
     // If waypoints are off, airways are on and waypoint has no airways skip it
@@ -261,6 +323,39 @@ void MapPainterNav::paintWaypoints(PaintContext *context, const QList<MapWaypoin
   }
 }
 
+void MapPainterNav::paintWaypointClusters(PaintContext *context, const QList<MapWaypoint> *waypoints,
+                                          map::MapObjectTypes types, bool drawFast)
+{
+  if(types == map::NONE)
+    return;
+
+  int size = context->sz(context->symbolSizeNavaid, context->mapLayerEffective->getWaypointSymbolSize());
+  bool drawAirwayWaypoints = types & (map::AIRWAYV | map::AIRWAYJ);
+
+  for(const map::MapObjectCluster& cluster : *query->getWaypointClusters(clusterCellSizeDeg(), types))
+  {
+    int x, y;
+    bool visible = wToS(cluster.position, x, y);
+
+    if(visible)
+    {
+      if(context->objCount())
+        return;
+
+      const MapWaypoint& waypoint = waypoints->at(cluster.index);
+      if(cluster.count > 1)
+        symbolPainter->drawClusterSymbol(context->painter, mapcolors::waypointSymbolColor, x, y, size, cluster.count,
+                                         drawFast);
+      else
+        symbolPainter->drawWaypointSymbol(context->painter, QColor(), x, y, size, false, drawFast);
+
+      if(context->mapLayer->isWaypointName() || (context->mapLayer->isAirwayIdent() && drawAirwayWaypoints))
+        symbolPainter->drawWaypointText(context->painter, waypoint, x, y, textflags::IDENT,
+                                        cluster.count > 1 ? size * 2 : size, false);
+    }
+  }
+}
+
 void MapPainterNav::paintVors(PaintContext *context, const QList<MapVor> *vors, bool drawFast)
 {
   for(const MapVor& vor : *vors)
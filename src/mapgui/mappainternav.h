@@ -23,6 +23,7 @@
 #include "mapgui/mapquery.h"
 
 class SymbolPainter;
+class QPainter;
 
 /*
  * Draws VOR, NDB, markers, waypoints and airways. Flight plan navaids are drawn separately in MapPainterRoute.
@@ -44,8 +45,16 @@ private:
   void paintVors(PaintContext *context, const QList<map::MapVor> *vors, bool drawFast);
   void paintWaypoints(PaintContext *context, const QList<map::MapWaypoint> *waypoints,
                       bool drawWaypoint, bool drawFast);
+
+  /* Draw aggregated waypoints for low zoom distances. types is a combination of WAYPOINT, AIRWAYV and AIRWAYJ
+   * to filter waypoints like paintWaypoints does. */
+  void paintWaypointClusters(PaintContext *context, const QList<map::MapWaypoint> *waypoints,
+                             map::MapObjectTypes types, bool drawFast);
   void paintAirways(PaintContext *context, const QList<map::MapAirway> *airways, bool fast);
 
+  /* Draw airway text rotated around and below x and y */
+  static void drawAirwayText(QPainter *painter, const QString& text, int x, int y, float rotate);
+
 };
 
 #endif // LITTLENAVMAP_MAPPAINTERAIRPORT_H
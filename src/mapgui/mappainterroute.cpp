@@ -19,6 +19,7 @@
 
 #include "mapgui/mapwidget.h"
 #include "common/symbolpainter.h"
+#include "common/labelplacement.h"
 #include "common/unit.h"
 #include "mapgui/maplayer.h"
 #include "common/mapcolors.h"
@@ -51,6 +52,8 @@ MapPainterRoute::~MapPainterRoute()
 
 void MapPainterRoute::render(PaintContext *context)
 {
+  symbolPainter->setLabelPlacement(context->labelPlacement, LabelPlacement::PRIORITY_ROUTE);
+
   // Draw route including approaches
   if(context->objectTypes.testFlag(map::FLIGHTPLAN))
     paintRoute(context);
@@ -131,16 +134,21 @@ void MapPainterRoute::paintRoute(const PaintContext *context)
       routeTexts.first().clear();
     }
 
+    // Convert cached great circle lines to screen once for all passes
+    QVector<QVector<QPolygonF> > screenLines(lines.size());
+    for(int i = 0; i < lines.size(); i++)
+      greatCircleToScreen(lines.at(i), screenLines[i]);
+
     // Draw outer line
     painter->setPen(QPen(mapcolors::routeOutlineColor, outerlinewidth, Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
-    for(const Line& line : lines)
-      drawLine(context, line);
+    for(const QVector<QPolygonF>& polylines : screenLines)
+      drawPolylines(painter, polylines);
 
     // Draw inner line
     painter->setPen(QPen(OptionData::instance().getFlightplanColor(), innerlinewidth,
                          Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
-    for(const Line& line : lines)
-      drawLine(context, line);
+    for(const QVector<QPolygonF>& polylines : screenLines)
+      drawPolylines(painter, polylines);
 
     // Get active route leg
     int activeRouteLeg = route->getActiveLegIndex();
@@ -150,7 +158,7 @@ void MapPainterRoute::paintRoute(const PaintContext *context)
       painter->setPen(QPen(OptionData::instance().getFlightplanActiveSegmentColor(), innerlinewidth,
                            Qt::SolidLine, Qt::RoundCap, Qt::RoundJoin));
 
-      drawLine(context, lines.at(activeRouteLeg - 1));
+      drawPolylines(painter, screenLines.at(activeRouteLeg - 1));
     }
   }
 
@@ -159,6 +167,7 @@ void MapPainterRoute::paintRoute(const PaintContext *context)
   // Collect coordinates for text placement and lines first
   TextPlacement textPlacement(painter, this);
   textPlacement.setDrawFast(context->drawFast);
+  textPlacement.setLabelPlacement(context->labelPlacement, LabelPlacement::PRIORITY_ROUTE);
   textPlacement.setLineWidth(outerlinewidth);
   textPlacement.calculateTextPositions(positions);
   textPlacement.calculateTextAlongLines(lines, routeTexts);
@@ -369,6 +378,7 @@ void MapPainterRoute::paintApproach(const PaintContext *context, const proc::Map
 
     TextPlacement textPlacement(painter, this);
     textPlacement.setDrawFast(context->drawFast);
+    textPlacement.setLabelPlacement(context->labelPlacement, LabelPlacement::PRIORITY_ROUTE);
     textPlacement.setTextOnTopOfLine(false);
     textPlacement.setLineWidth(outerlinewidth);
     textPlacement.setColors(textColors);
@@ -50,12 +50,12 @@ void MapPainterShip::render(PaintContext *context)
       atools::util::PainterContextSaver saver(context->painter);
       Q_UNUSED(saver);
 
-      for(const SimConnectAircraft& ac : mapWidget->getAiAircraft())
-      {
-        if(ac.getCategory() == atools::fs::sc::BOAT &&
-           (ac.getModelRadius() * 2 > layer::LARGE_SHIP_SIZE || context->mapLayer->isAiShipSmall()))
-          paintAiVehicle(context, ac);
-      }
+      bool small = context->mapLayer->isAiShipSmall();
+      paintAiVehicles(context, [small](const SimConnectAircraft& ac) -> bool
+                      {
+                        return ac.getCategory() == atools::fs::sc::BOAT &&
+                        (ac.getModelRadius() * 2 > layer::LARGE_SHIP_SIZE || small);
+                      }, small);
     }
   }
 }
@@ -24,10 +24,14 @@
 #include "mapgui/mapscale.h"
 #include "mapgui/maplayer.h"
 #include "common/unit.h"
+#include "common/maptools.h"
+#include "common/aiaircraftindex.h"
+#include "common/labelplacement.h"
 #include "util/paintercontextsaver.h"
 #include "settings/settings.h"
 
 #include <marble/GeoPainter.h>
+#include <marble/ViewportParams.h>
 
 using namespace Marble;
 using namespace atools::geo;
@@ -41,6 +45,21 @@ uint qHash(const MapPainterVehicle::PixmapKey& key)
   return key.size | (key.type << 8) | (key.ground << 10) | (key.user << 11);
 }
 
+bool MapPainterVehicle::TrackProjection::sameView(const TrackProjection& other) const
+{
+  return centerLon == other.centerLon && centerLat == other.centerLat && radius == other.radius &&
+         projection == other.projection && size == other.size && level == other.level &&
+         generation == other.generation;
+}
+
+bool MapPainterVehicle::AiLabelKey::operator==(const AiLabelKey& other) const
+{
+  return indicatedSpeed == other.indicatedSpeed && groundSpeed == other.groundSpeed && heading == other.heading &&
+         verticalSpeed == other.verticalSpeed && altitude == other.altitude && ground == other.ground &&
+         options == other.options && registration == other.registration && model == other.model &&
+         airline == other.airline && flightnumber == other.flightnumber;
+}
+
 bool MapPainterVehicle::PixmapKey::operator==(const MapPainterVehicle::PixmapKey& other) const
 {
   return type == other.type && ground == other.ground && user == other.user && size == other.size;
@@ -63,7 +82,7 @@ void MapPainterVehicle::paintAiVehicle(const PaintContext *context,
   if(vehicle.isUser())
     return;
 
-  const Pos& pos = vehicle.getPosition();
+  const Pos pos = extrapolatePosition(vehicle, vehicle.getHeadingDegTrue(), context->simDataExtrapolationSec);
 
   if(!pos.isValid())
     return;
@@ -94,6 +113,69 @@ void MapPainterVehicle::paintAiVehicle(const PaintContext *context,
   }
 }
 
+void MapPainterVehicle::paintAiVehicles(const PaintContext *context,
+                                        std::function<bool(const SimConnectAircraft&)> filter, int filterKey)
+{
+  const QVector<SimConnectAircraft>& aiVehicles = mapWidget->getAiAircraft();
+
+  aiLabelFrame++;
+
+  // Vehicles are far enough apart at high zoom to be drawn all
+  if(aiVehicles.size() <= MIN_AI_CLUSTER_COUNT || mapWidget->distance() <= MIN_AI_CLUSTER_DISTANCE_KM)
+  {
+    for(const SimConnectAircraft& vehicle : aiVehicles)
+    {
+      if(filter(vehicle))
+        paintAiVehicle(context, vehicle);
+    }
+  }
+  else
+  {
+    // Too many vehicles - draw grid clusters. Rebuild only for a new packet, zoom or filter change.
+    float cellSizeDeg = clusterCellSizeDeg();
+    quint32 generation = mapWidget->getAiAircraftIndex().getGeneration();
+    if(aiClusterCache.generation != generation || aiClusterCache.cellSizeDeg < cellSizeDeg ||
+       aiClusterCache.cellSizeDeg > cellSizeDeg || aiClusterCache.filterKey != filterKey)
+    {
+      maptools::clusterObjects<SimConnectAircraft>(aiVehicles, cellSizeDeg, aiClusterCache.list, filter,
+                                                   [](const SimConnectAircraft& vehicle) -> int
+                                                   {
+                                                     // Show the largest vehicle of a cell
+                                                     return vehicle.getModelRadius();
+                                                   });
+      aiClusterCache.generation = generation;
+      aiClusterCache.cellSizeDeg = cellSizeDeg;
+      aiClusterCache.filterKey = filterKey;
+    }
+
+    int size = context->sz(context->symbolSizeAircraftAi, 20);
+    for(const map::MapObjectCluster& cluster : aiClusterCache.list)
+    {
+      if(cluster.count > 1)
+      {
+        int x, y;
+        if(wToS(cluster.position, x, y) && context->painter->window().contains(x, y))
+          symbolPainter->drawClusterSymbol(context->painter, mapcolors::aiVehicleClusterColor, x, y, size,
+                                           cluster.count, context->drawFast);
+      }
+      else
+        paintAiVehicle(context, aiVehicles.at(cluster.index));
+    }
+  }
+
+  // Remove labels of vehicles which are gone
+  if(aiLabelCache.size() > aiVehicles.size() * 2)
+  {
+    for(auto it = aiLabelCache.begin(); it != aiLabelCache.end();)
+    {
+      if(it.value().frame != aiLabelFrame)
+        it = aiLabelCache.erase(it);
+      else
+        ++it;
+    }
+  }
+}
+
 void MapPainterVehicle::paintUserAircraft(const PaintContext *context,
                                           const SimConnectUserAircraft& userAircraft, float x, float y)
 {
@@ -113,113 +195,212 @@ void MapPainterVehicle::paintUserAircraft(const PaintContext *context,
   context->painter->drawPixmap(offset, offset, *pixmapFromCache(userAircraft, size, true));
   context->painter->resetTransform();
 
+  if(context->vehicleBounds != nullptr)
+  {
+    // Covers rotated symbol and track line
+    float radius = size * 2.f;
+    context->vehicleBounds->userAircraft |= QRectF(x - radius, y - radius, radius * 2.f, radius * 2.f).toAlignedRect();
+    context->vehicleBounds->userAircraftPos = QPointF(x, y);
+  }
+
   // Build text label
   paintTextLabelUser(context, x, y, size, userAircraft);
 }
 
+Pos MapPainterVehicle::extrapolatePosition(const SimConnectAircraft& aircraft, float courseDegTrue, float seconds)
+{
+  const Pos& pos = aircraft.getPosition();
+
+  if(seconds <= 0.f || !pos.isValid() || aircraft.getGroundSpeedKts() < MIN_EXTRAPOLATION_SPEED_KTS)
+    return pos;
+
+  Pos next = pos.endpoint(nmToMeter(aircraft.getGroundSpeedKts() * seconds / 3600.f), courseDegTrue);
+  next.normalize();
+
+  float altitude = pos.getAltitude();
+  if(!aircraft.isOnGround())
+    altitude += aircraft.getVerticalSpeedFeetPerMin() * seconds / 60.f;
+  next.setAltitude(altitude);
+  return next;
+}
+
 void MapPainterVehicle::paintTrack(const PaintContext *context)
 {
   const AircraftTrack& aircraftTrack = mapWidget->getAircraftTrack();
 
   if(!aircraftTrack.isEmpty())
   {
-    QPolygon polyline;
-
     GeoPainter *painter = context->painter;
+    const ViewportParams *viewport = context->viewport;
 
     float size = context->sz(context->thicknessTrail, 2);
     painter->setPen(mapcolors::aircraftTrailPen(size));
-    bool lastVisible = false;
-
-    int x1, y1;
-    int x2 = -1, y2 = -1;
-    QRect vpRect(painter->viewport());
-    wToS(aircraftTrack.first().pos, x1, y1);
 
-    for(int i = 1; i < aircraftTrack.size(); i++)
+    // Use the coarsest level where points are not farther apart than the minimum line length
+    float pixelPerKm = scale->getPixelForMeter(1000.f);
+    float toleranceMeter = pixelPerKm > 0.f ? AIRCRAFT_TRACK_MIN_LINE_LENGTH * 1000.f / pixelPerKm : 0.f;
+    int level = aircraftTrack.getLevelForTolerance(toleranceMeter);
+    int levelSize = aircraftTrack.getLevelSize(level);
+
+    TrackProjection key;
+    key.centerLon = viewport->centerLongitude();
+    key.centerLat = viewport->centerLatitude();
+    key.radius = viewport->radius();
+    key.projection = viewport->projection();
+    key.size = viewport->size();
+    key.level = level;
+    key.generation = aircraftTrack.getGeneration();
+
+    if(!trackProjection.sameView(key) || trackProjection.points.size() > levelSize)
     {
-      const at::AircraftTrackPos& trackPos = aircraftTrack.at(i);
-      wToS(trackPos.pos, x2, y2);
-
-      QRect rect(QPoint(x1, y1), QPoint(x2, y2));
-      rect = rect.normalized();
-      rect.adjust(-1, -1, 1, 1);
+      // Viewport, level or track changed - project all again
+      trackProjection = key;
+      trackProjection.points.clear();
+      trackProjection.hidden.clear();
+    }
 
-      // Current line is visible (most likely)
-      bool nowVisible = rect.intersects(vpRect);
+    if(trackProjection.points.size() < levelSize)
+    {
+      // Project only positions added since last paint
+      LineString tail;
+      for(int i = trackProjection.points.size(); i < levelSize; i++)
+        tail.append(aircraftTrack.getLevelPos(level, i));
+
+      QPolygonF points;
+      QVector<bool> hidden;
+      wToS(tail, points, nullptr, DEFAULT_WTOS_SIZE, &hidden);
+      trackProjection.points += points;
+      trackProjection.hidden += hidden;
+    }
 
-      if(lastVisible || nowVisible)
-      {
-        if(!polyline.isEmpty())
-        {
-          const QPoint& lastPt = polyline.last();
-          // Last line or this one are visible add coords
-          if(atools::geo::manhattanDistance(lastPt.x(), lastPt.y(), x2, y2) > AIRCRAFT_TRACK_MIN_LINE_LENGTH)
-            polyline.append(QPoint(x1, y1));
-        }
-        else
-          // Always add first visible point
-          polyline.append(QPoint(x1, y1));
-      }
+    // Use the cached projection as is to avoid copying it each frame
+    const QPolygonF& points = trackProjection.points;
+    const QVector<bool>& hidden = trackProjection.hidden;
 
-      if(lastVisible && !nowVisible)
-      {
-        // Not visible anymore draw previous line segment
-        painter->drawPolyline(polyline);
-        polyline.clear();
-      }
+    if(context->vehicleBounds != nullptr)
+    {
+      // Remember where new segments will be attached
+      if(!points.isEmpty())
+        context->vehicleBounds->trackTail = points.last();
+      context->vehicleBounds->trackSize = aircraftTrack.size();
+      context->vehicleBounds->trackGeneration = aircraftTrack.getGeneration();
+    }
 
-      lastVisible = nowVisible;
-      x1 = x2;
-      y1 = y2;
+    QRectF vpRect(painter->viewport());
+    bool mercator = viewport->projection() == Marble::Mercator;
+    double maxJump = 2. * viewport->radius();
+
+    // Collect runs of visible segments into polylines
+    QPolygonF polyline;
+    auto appendSegment = [painter, &polyline, &vpRect, mercator, maxJump](const QPointF& p1, bool hidden1,
+                                                                            const QPointF& p2, bool hidden2)
+                         {
+                           bool visible = !hidden1 && !hidden2 &&
+                                          // Avoid lines across the screen where Mercator repeats
+                                          !(mercator && std::abs(p2.x() - p1.x()) > maxJump) &&
+                                          QRectF(p1, p2).normalized().adjusted(-1., -1., 1., 1.).intersects(vpRect);
+
+                           if(visible)
+                           {
+                             if(polyline.isEmpty())
+                               polyline.append(p1);
+                             polyline.append(p2);
+                           }
+                           else if(!polyline.isEmpty())
+                           {
+                             painter->QPainter::drawPolyline(polyline);
+                             polyline.clear();
+                           }
+                         };
+
+    for(int i = 1; i < points.size(); i++)
+      appendSegment(points.at(i - 1), hidden.at(i - 1), points.at(i), hidden.at(i));
+
+    // Level might not contain the latest position - add the tail segment separately
+    const Pos& lastPos = aircraftTrack.last().pos;
+    if(!points.isEmpty() && aircraftTrack.getLevelPos(level, levelSize - 1) != lastPos)
+    {
+      double x, y;
+      bool lastHidden;
+      wToS(lastPos, x, y, DEFAULT_WTOS_SIZE, &lastHidden);
+      appendSegment(points.last(), hidden.last(), QPointF(x, y), lastHidden);
     }
 
     // Draw rest
     if(!polyline.isEmpty())
-    {
-      polyline.append(QPoint(x2, y2));
-      painter->drawPolyline(polyline);
-    }
+      painter->QPainter::drawPolyline(polyline);
   }
 }
 
 void MapPainterVehicle::paintTextLabelAi(const PaintContext *context, float x, float y, int size,
                                          const SimConnectAircraft& aircraft)
 {
-  QStringList texts;
-
   if((aircraft.isOnGround() && context->mapLayer->isAiAircraftGroundText()) || // All AI on ground
      (!aircraft.isOnGround() && context->mapLayer->isAiAircraftText())) // All AI in the air
   {
-    appendAtcText(texts, aircraft, context->dOpt(opts::ITEM_AI_AIRCRAFT_REGISTRATION),
-                  context->dOpt(opts::ITEM_AI_AIRCRAFT_TYPE),
-                  context->dOpt(opts::ITEM_AI_AIRCRAFT_AIRLINE),
-                  context->dOpt(opts::ITEM_AI_AIRCRAFT_FLIGHT_NUMBER));
+    textatt::TextAttributes atts(textatt::BOLD);
 
-    if(aircraft.getGroundSpeedKts() > 30)
-      appendSpeedText(texts, aircraft, context->dOpt(opts::ITEM_AI_AIRCRAFT_IAS),
-                      context->dOpt(opts::ITEM_AI_AIRCRAFT_GS));
+    // Draw text label
+    symbolPainter->textBoxF(context->painter, textLabelAi(context, aircraft), QPen(Qt::black),
+                            x + size / 2, y + size / 2, atts, 255);
+  }
+}
 
-    if(!aircraft.isOnGround())
-    {
-      if(context->dOpt(opts::ITEM_AI_AIRCRAFT_HEADING))
-        texts.append(tr("HDG %3°M").arg(QString::number(aircraft.getHeadingDegMag(), 'f', 0)));
+const QStringList& MapPainterVehicle::textLabelAi(const PaintContext *context, const SimConnectAircraft& aircraft)
+{
+  // Values rounded to the shown precision
+  AiLabelKey key;
+  key.registration = aircraft.getAirplaneRegistration();
+  key.model = aircraft.getAirplaneModel();
+  key.airline = aircraft.getAirplaneAirline();
+  key.flightnumber = aircraft.getAirplaneFlightnumber();
+  key.indicatedSpeed = atools::roundToInt(aircraft.getIndicatedSpeedKts());
+  key.groundSpeed = atools::roundToInt(aircraft.getGroundSpeedKts());
+  key.heading = atools::roundToInt(aircraft.getHeadingDegMag());
+  key.verticalSpeed = atools::roundToInt(aircraft.getVerticalSpeedFeetPerMin());
+  key.altitude = atools::roundToInt(aircraft.getPosition().getAltitude());
+  key.ground = aircraft.isOnGround();
+  key.options = context->dispOpts;
+
+  AiLabel& label = aiLabelCache[aircraft.getObjectId()];
+  if(!label.valid || !(label.key == key))
+  {
+    label.valid = true;
+    label.key = key;
+    label.texts.clear();
+    buildTextLabelAi(context, aircraft, label.texts);
+  }
+  label.frame = aiLabelFrame;
+  return label.texts;
+}
 
-      if(context->dOpt(opts::ITEM_AI_AIRCRAFT_CLIMB_SINK))
-        appendClimbSinkText(texts, aircraft);
+void MapPainterVehicle::buildTextLabelAi(const PaintContext *context, const SimConnectAircraft& aircraft,
+                                         QStringList& texts)
+{
+  appendAtcText(texts, aircraft, context->dOpt(opts::ITEM_AI_AIRCRAFT_REGISTRATION),
+                context->dOpt(opts::ITEM_AI_AIRCRAFT_TYPE),
+                context->dOpt(opts::ITEM_AI_AIRCRAFT_AIRLINE),
+                context->dOpt(opts::ITEM_AI_AIRCRAFT_FLIGHT_NUMBER));
 
-      if(context->dOpt(opts::ITEM_AI_AIRCRAFT_ALTITUDE))
-      {
-        QString upDown;
-        if(!context->dOpt(opts::ITEM_AI_AIRCRAFT_CLIMB_SINK))
-          climbSinkPointer(upDown, aircraft);
-        texts.append(tr("ALT %1%2").arg(Unit::altFeet(aircraft.getPosition().getAltitude())).arg(upDown));
-      }
-    }
-    textatt::TextAttributes atts(textatt::BOLD);
+  if(aircraft.getGroundSpeedKts() > 30)
+    appendSpeedText(texts, aircraft, context->dOpt(opts::ITEM_AI_AIRCRAFT_IAS),
+                    context->dOpt(opts::ITEM_AI_AIRCRAFT_GS));
 
-    // Draw text label
-    symbolPainter->textBoxF(context->painter, texts, QPen(Qt::black), x + size / 2, y + size / 2, atts, 255);
+  if(!aircraft.isOnGround())
+  {
+    if(context->dOpt(opts::ITEM_AI_AIRCRAFT_HEADING))
+      texts.append(tr("HDG %3°M").arg(QString::number(aircraft.getHeadingDegMag(), 'f', 0)));
+
+    if(context->dOpt(opts::ITEM_AI_AIRCRAFT_CLIMB_SINK))
+      appendClimbSinkText(texts, aircraft);
+
+    if(context->dOpt(opts::ITEM_AI_AIRCRAFT_ALTITUDE))
+    {
+      QString upDown;
+      if(!context->dOpt(opts::ITEM_AI_AIRCRAFT_CLIMB_SINK))
+        climbSinkPointer(upDown, aircraft);
+      texts.append(tr("ALT %1%2").arg(Unit::altFeet(aircraft.getPosition().getAltitude())).arg(upDown));
+    }
   }
 }
 
@@ -259,6 +440,7 @@ void MapPainterVehicle::paintTextLabelUser(const PaintContext *context, float x,
 
   // Draw text label
   symbolPainter->textBoxF(context->painter, texts, QPen(Qt::black), x + size / 2.f, y + size / 2.f, atts, 255);
+  addUserAircraftBounds(context, texts, x + size / 2.f, y + size / 2.f);
 }
 
 const QPixmap *MapPainterVehicle::pixmapFromCache(const SimConnectAircraft& ac, int size,
@@ -382,6 +564,10 @@ void MapPainterVehicle::paintWindPointer(const PaintContext *context,
 {
   symbolPainter->drawWindPointer(context->painter, x, y, WIND_POINTER_SIZE, aircraft.getWindDirectionDegT());
   paintTextLabelWind(context, x, y, WIND_POINTER_SIZE, aircraft);
+
+  if(context->vehicleBounds != nullptr)
+    context->vehicleBounds->userAircraft |= QRect(x - WIND_POINTER_SIZE, y - WIND_POINTER_SIZE,
+                                                  WIND_POINTER_SIZE * 2, WIND_POINTER_SIZE * 2);
 }
 
 void MapPainterVehicle::paintTextLabelWind(const PaintContext *context, int x, int y, int size,
@@ -403,4 +589,14 @@ void MapPainterVehicle::paintTextLabelWind(const PaintContext *context, int x, i
 
   // Draw text label
   symbolPainter->textBoxF(context->painter, texts, QPen(Qt::black), x + size / 2, y + size / 2, atts, 255);
+  addUserAircraftBounds(context, texts, x + size / 2, y + size / 2);
+}
+
+void MapPainterVehicle::addUserAircraftBounds(const PaintContext *context, const QStringList& texts,
+                                              float x, float y) const
+{
+  if(context->vehicleBounds != nullptr && !texts.isEmpty())
+    context->vehicleBounds->userAircraft |=
+      LabelPlacement::estimateTextRect(QFontMetricsF(context->painter->font()), texts, x, y,
+                                       false, false).toAlignedRect();
 }
@@ -19,8 +19,12 @@
 #define LITTLENAVMAP_MAPPAINTERVECHICLE_H
 
 #include "mapgui/mappainter.h"
+#include "common/maptypes.h"
 
 #include <QCache>
+#include <QPolygonF>
+
+#include <functional>
 
 namespace Marble {
 class GeoDataLineString;
@@ -53,6 +57,17 @@ public:
 
   virtual void render(PaintContext *context) = 0;
 
+  /* Position moved ahead by the given time along course using ground and vertical speed
+   * to get fluid movement between simulator packets */
+  static atools::geo::Pos extrapolatePosition(const atools::fs::sc::SimConnectAircraft& aircraft,
+                                              float courseDegTrue, float seconds);
+
+  /* Remove cached AI label texts. Needed if units change. */
+  void clearAiLabelCache()
+  {
+    aiLabelCache.clear();
+  }
+
   enum AircraftType
   {
     AC_SMALL,
@@ -79,10 +94,24 @@ protected:
   void paintAiVehicle(const PaintContext *context,
                       const atools::fs::sc::SimConnectAircraft& vehicle);
 
+  /* Paint AI vehicles passing filter. Vehicles are aggregated into grid clusters if their number exceeds
+   * MIN_AI_CLUSTER_COUNT and the zoom distance is larger than MIN_AI_CLUSTER_DISTANCE_KM.
+   * filterKey has to change if the filter changes. */
+  void paintAiVehicles(const PaintContext *context,
+                       std::function<bool(const atools::fs::sc::SimConnectAircraft&)> filter, int filterKey);
+
+  /* Add the estimated text label rectangle to the user aircraft bounds in the paint context */
+  void addUserAircraftBounds(const PaintContext *context, const QStringList& texts, float x, float y) const;
+
   void paintTextLabelUser(const PaintContext *context, float x, float y, int size,
                           const atools::fs::sc::SimConnectUserAircraft& aircraft);
   void paintTextLabelAi(const PaintContext *context, float x, float y, int size,
                         const atools::fs::sc::SimConnectAircraft& aircraft);
+
+  /* Get label texts from cache or build them if any shown value has changed */
+  const QStringList& textLabelAi(const PaintContext *context, const atools::fs::sc::SimConnectAircraft& aircraft);
+  void buildTextLabelAi(const PaintContext *context, const atools::fs::sc::SimConnectAircraft& aircraft,
+                        QStringList& texts);
   void appendClimbSinkText(QStringList& texts, const atools::fs::sc::SimConnectAircraft& aircraft);
   void appendAtcText(QStringList& texts, const atools::fs::sc::SimConnectAircraft& aircraft,
                      bool registration, bool type, bool airline, bool flightnumber);
@@ -98,15 +127,74 @@ protected:
   const QPixmap *pixmapFromCache(const PixmapKey& key);
   const QPixmap *pixmapFromCache(const atools::fs::sc::SimConnectAircraft& ac, int size, bool user);
 
-  /* Minimum length in pixel of a track segment to be drawn */
+  /* Distance in pixel between track points used to select the track simplification level */
   static Q_DECL_CONSTEXPR int AIRCRAFT_TRACK_MIN_LINE_LENGTH = 5;
 
   static Q_DECL_CONSTEXPR int WIND_POINTER_SIZE = 40;
 
+  /* Cluster AI vehicles if more than this number is shown */
+  static Q_DECL_CONSTEXPR int MIN_AI_CLUSTER_COUNT = 250;
+
+  /* Cluster AI vehicles only at low zoom where this distance is exceeded */
+  static Q_DECL_CONSTEXPR float MIN_AI_CLUSTER_DISTANCE_KM = 200.f;
+
+  /* Do not extrapolate vehicles slower than this to avoid jitter of parked aircraft */
+  static Q_DECL_CONSTEXPR float MIN_EXTRAPOLATION_SPEED_KTS = 1.f;
+
 private:
+  /* Projected aircraft track level. Kept until the viewport changes so that only new positions have
+   * to be converted. */
+  struct TrackProjection
+  {
+    bool sameView(const TrackProjection& other) const;
+
+    qreal centerLon = 0., centerLat = 0.;
+    int radius = 0, projection = 0, level = -1;
+    QSize size;
+    quint32 generation = 0;
+
+    QPolygonF points;
+    QVector<bool> hidden;
+  };
+
+  /* Values shown in an AI label. Texts are only rebuilt if this changes. */
+  struct AiLabelKey
+  {
+    bool operator==(const AiLabelKey& other) const;
+
+    QString registration, model, airline, flightnumber;
+    int indicatedSpeed = 0, groundSpeed = 0, heading = 0, verticalSpeed = 0, altitude = 0;
+    bool ground = false;
+    opts::DisplayOptions options = opts::ITEM_NONE;
+  };
+
+  struct AiLabel
+  {
+    AiLabelKey key;
+    QStringList texts;
+    quint32 frame = 0; /* Last frame where the label was used */
+    bool valid = false;
+  };
+
+  /* Grid clusters for one AI packet, cell size and filter */
+  struct AiClusterCache
+  {
+    quint32 generation = 0;
+    float cellSizeDeg = 0.f;
+    int filterKey = -1;
+    QList<map::MapObjectCluster> list;
+  };
+
   /* Caches pixmaps generated from SVG graphics */
   QCache<PixmapKey, QPixmap> aircraftPixmaps;
 
+  TrackProjection trackProjection;
+
+  /* AI label texts by object id */
+  QHash<unsigned int, AiLabel> aiLabelCache;
+  quint32 aiLabelFrame = 0;
+  AiClusterCache aiClusterCache;
+
 };
 
 #endif // LITTLENAVMAP_MAPPAINTERVECHICLE_H
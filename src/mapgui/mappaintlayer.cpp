@@ -32,10 +32,19 @@
 #include "mapgui/mapscale.h"
 #include "route/route.h"
 #include "options/optiondata.h"
+#include "common/constants.h"
+#include "common/memorycache.h"
+#include "settings/settings.h"
+#include "util/paintercontextsaver.h"
 
 #include <QElapsedTimer>
+#include <QFontDatabase>
+#include <QPicture>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <marble/GeoPainter.h>
+#include <marble/ViewportParams.h>
 
 using namespace Marble;
 using namespace atools::geo;
@@ -46,6 +55,19 @@ MapPaintLayer::MapPaintLayer(MapWidget *widget, MapQuery *mapQueries)
   // Create the layer configuration
   initMapLayerSettings();
 
+  // Rasterize layers in parallel if more than one core is available and text can be drawn in worker threads.
+  // Off by default since recording and compositing cost more than they save for cheap frames like while scrolling.
+  // Compare the frame times in the paint statistics overlay before enabling.
+  parallelRendering = atools::settings::Settings::instance().getAndStoreValue(
+    lnm::SETTINGS_MAPPAINTLAYER + "ParallelRendering", false).toBool() &&
+                      QThread::idealThreadCount() > 1 && QFontDatabase::supportsThreadedFontRendering();
+
+  // Time budget for frames - objects left out are drawn in a refinement pass once the map is still
+  timeBudgetAnimationMs = atools::settings::Settings::instance().getAndStoreValue(
+    lnm::SETTINGS_MAPPAINTLAYER + "TimeBudgetAnimationMs", 40).toLongLong();
+  timeBudgetStillMs = atools::settings::Settings::instance().getAndStoreValue(
+    lnm::SETTINGS_MAPPAINTLAYER + "TimeBudgetStillMs", 1000).toLongLong();
+
   mapScale = new MapScale();
 
   // Create all painters
@@ -80,11 +102,26 @@ MapPaintLayer::~MapPaintLayer()
 void MapPaintLayer::preDatabaseLoad()
 {
   databaseLoadStatus = true;
+  staticLayerValid = false;
+  mapPainterAirport->clearDiagramCache();
 }
 
 void MapPaintLayer::postDatabaseLoad()
 {
   databaseLoadStatus = false;
+  staticLayerValid = false;
+  mapPainterAirport->clearDiagramCache();
+}
+
+void MapPaintLayer::clearAirportDiagramCache()
+{
+  mapPainterAirport->clearDiagramCache();
+}
+
+void MapPaintLayer::clearAiLabelCache()
+{
+  mapPainterAircraft->clearAiLabelCache();
+  mapPainterShip->clearAiLabelCache();
 }
 
 void MapPaintLayer::setShowMapObjects(map::MapObjectTypes type, bool show)
@@ -310,12 +347,277 @@ void MapPaintLayer::updateLayers()
   mapLayer = layers->getLayer(dist, detailFactor);
 }
 
+void MapPaintLayer::renderStaticLayers(PaintContext *context)
+{
+  QVector<MapPainter *> painters;
+  if(context->mapLayerEffective->isAirportDiagram())
+    // Put ILS below and navaids on top of airport diagram
+    painters = {mapPainterAirspace, mapPainterIls, mapPainterAirport, mapPainterNav};
+  else
+    // Airports on top of all
+    painters = {mapPainterAirspace, mapPainterIls, mapPainterNav, mapPainterAirport};
+
+  // Painters are called in z-order which puts the airports with the highest priority last. Painters below the
+  // airports get only a part of the time budget so that airports are not always the ones left out on slow frames.
+  qint64 frameBudgetMs = context->timeBudgetMs;
+  bool budgetExceeded = context->timeBudgetExceeded;
+
+  if(parallelRendering)
+    renderLayersParallel(context, painters, frameBudgetMs, budgetExceeded);
+  else
+  {
+    for(int i = 0; i < painters.size(); i++)
+    {
+      MapPainter *painter = painters.at(i);
+      beginStaticPainter(context, painters, i, frameBudgetMs);
+
+      // ILS are always drawn below the airport diagram
+      if(!context->isOverflow() || (painter == mapPainterIls && context->mapLayerEffective->isAirportDiagram()))
+        renderPainter(painter, context);
+      budgetExceeded |= context->timeBudgetExceeded;
+    }
+  }
+
+  // Restore frame budget and remember if any painter was cut
+  context->timeBudgetMs = frameBudgetMs;
+  context->timeBudgetExceeded = budgetExceeded;
+
+  // Draw the labels collected by all layers in order of priority and on top of all layers
+  if(context->labelPlacement != nullptr)
+    context->labelPlacement->resolve(context->painter);
+}
+
+void MapPaintLayer::beginStaticPainter(PaintContext *context, const QVector<MapPainter *>& painters, int index,
+                                       qint64 frameBudgetMs)
+{
+  if(frameBudgetMs > 0)
+  {
+    int percent = 100;
+    if(index < painters.indexOf(mapPainterAirport))
+    {
+      // Leave time for the airports
+      const MapPainter *painter = painters.at(index);
+      if(painter == mapPainterAirspace)
+        percent = STATIC_BUDGET_PERCENT_AIRSPACE;
+      else if(painter == mapPainterIls)
+        percent = STATIC_BUDGET_PERCENT_ILS;
+      else
+        percent = STATIC_BUDGET_PERCENT_NAV;
+    }
+
+    context->timeBudgetMs = frameBudgetMs * percent / 100;
+    context->timeBudgetExceeded = false;
+  }
+}
+
+/* Rasterize a recorded layer into a transparent image. Called in a worker thread. */
+static void replayLayer(const QPicture *picture, QImage *image)
+{
+  image->fill(Qt::transparent);
+  QPainter painter(image);
+  painter.drawPicture(0, 0, *picture);
+}
+
+void MapPaintLayer::renderLayersParallel(PaintContext *context, const QVector<MapPainter *>& painters,
+                                         qint64 frameBudgetMs, bool& budgetExceeded)
+{
+  const QSize size = context->viewport->size();
+  int pixelRatio = context->painter->device()->devicePixelRatio();
+
+  // Record all drawing commands - map data is accessed only here
+  QVector<QPicture> pictures(painters.size());
+  QVector<bool> recorded(painters.size(), false);
+  for(int i = 0; i < painters.size(); i++)
+  {
+    MapPainter *painter = painters.at(i);
+    beginStaticPainter(context, painters, i, frameBudgetMs);
+    if(context->isOverflow() && !(painter == mapPainterIls && context->mapLayerEffective->isAirportDiagram()))
+    {
+      budgetExceeded |= context->timeBudgetExceeded;
+      continue;
+    }
+
+    // Bounding rectangle is needed to let the clipping painter know the device size
+    pictures[i].setBoundingRect(QRect(QPoint(0, 0), size));
+
+    GeoPainter recordPainter(&pictures[i], context->viewport, context->painter->mapQuality());
+    recordPainter.setRenderHints(context->painter->renderHints());
+    recordPainter.setFont(context->painter->font());
+
+    GeoPainter *contextPainter = context->painter;
+    context->painter = &recordPainter;
+    renderPainter(painter, context);
+    context->painter = contextPainter;
+
+    recordPainter.end();
+    recorded[i] = true;
+    budgetExceeded |= context->timeBudgetExceeded;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+
+  // Rasterize recordings on the thread pool
+  layerImages.resize(painters.size());
+  QVector<QFuture<void> > futures;
+  for(int i = 0; i < painters.size(); i++)
+  {
+    if(!recorded.at(i))
+      continue;
+
+    QImage& image = layerImages[i];
+    if(image.size() != size * pixelRatio)
+    {
+      image = QImage(size * pixelRatio, QImage::Format_ARGB32_Premultiplied);
+      image.setDevicePixelRatio(pixelRatio);
+    }
+
+    // Use the resolution of the recording to avoid scaled fonts
+    image.setDotsPerMeterX(qRound(pictures.at(i).logicalDpiX() / 0.0254));
+    image.setDotsPerMeterY(qRound(pictures.at(i).logicalDpiY() / 0.0254));
+
+    futures.append(QtConcurrent::run(replayLayer, &pictures.at(i), &image));
+  }
+
+  for(QFuture<void>& future : futures)
+    future.waitForFinished();
+
+  // Composite in z-order
+  for(int i = 0; i < painters.size(); i++)
+  {
+    if(recorded.at(i))
+      context->painter->drawImage(QPointF(0., 0.), layerImages.at(i));
+  }
+  profiler.addTime(MapPaintProfiler::COMPOSITE, timer.nsecsElapsed());
+}
+
+void MapPaintLayer::renderStaticLayersCached(PaintContext *context)
+{
+  GeoPainter *painter = context->painter;
+  const ViewportParams *viewport = context->viewport;
+
+  StaticLayerKey key;
+  key.centerLon = viewport->centerLongitude();
+  key.centerLat = viewport->centerLatitude();
+  key.radius = viewport->radius();
+  key.projection = viewport->projection();
+  key.size = viewport->size();
+  key.mapLayer = context->mapLayer;
+  key.objectTypes = context->objectTypes;
+  key.airspaceTypes = context->airspaceTypesByLayer;
+  key.mapThemeId = mapWidget->mapThemeId();
+  key.styleDark = OptionData::instance().isGuiStyleDark();
+  key.styleMapDimming = OptionData::instance().getGuiStyleMapDimming();
+
+  if(!staticLayerValid || key != staticLayerKey)
+  {
+    // Paint into a transparent image having the same resolution as the widget
+    int pixelRatio = painter->device()->devicePixelRatio();
+    if(staticLayerImage.size() != key.size * pixelRatio)
+    {
+      staticLayerImage = QImage(key.size * pixelRatio, QImage::Format_ARGB32_Premultiplied);
+      staticLayerImage.setDevicePixelRatio(pixelRatio);
+    }
+    staticLayerImage.fill(Qt::transparent);
+
+    GeoPainter imagePainter(&staticLayerImage, viewport, painter->mapQuality());
+    imagePainter.setRenderHints(painter->renderHints());
+    imagePainter.setFont(painter->font());
+
+    PaintContext imageContext = *context;
+    imageContext.painter = &imagePainter;
+    renderStaticLayers(&imageContext);
+    imagePainter.end();
+
+    staticLayerObjectCount = imageContext.objectCount - context->objectCount;
+    staticLayerKey = key;
+
+    // Do not keep an incomplete image - refinement pass has to paint it again
+    context->timeBudgetExceeded = imageContext.timeBudgetExceeded;
+    staticLayerValid = !imageContext.timeBudgetExceeded;
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  painter->drawImage(QPointF(0., 0.), staticLayerImage);
+  profiler.addTime(MapPaintProfiler::COMPOSITE, timer.nsecsElapsed());
+
+  // Keep overflow detection working for the following painters
+  context->objectCount += staticLayerObjectCount;
+}
+
+void MapPaintLayer::renderPainter(MapPainter *painter, PaintContext *context)
+{
+  QElapsedTimer timer;
+  timer.start();
+  painter->render(context);
+  profiler.addTime(stageForPainter(painter), timer.nsecsElapsed());
+}
+
+MapPaintProfiler::Stage MapPaintLayer::stageForPainter(const MapPainter *painter) const
+{
+  if(painter == mapPainterShip)
+    return MapPaintProfiler::SHIP;
+  else if(painter == mapPainterAirspace)
+    return MapPaintProfiler::AIRSPACE;
+  else if(painter == mapPainterIls)
+    return MapPaintProfiler::ILS;
+  else if(painter == mapPainterNav)
+    return MapPaintProfiler::NAV;
+  else if(painter == mapPainterAirport)
+    return MapPaintProfiler::AIRPORT;
+  else if(painter == mapPainterRoute)
+    return MapPaintProfiler::ROUTE;
+  else if(painter == mapPainterMark)
+    return MapPaintProfiler::MARK;
+  else
+    return MapPaintProfiler::AIRCRAFT;
+}
+
+void MapPaintLayer::drawPaintStatistics(GeoPainter *painter)
+{
+  QStringList lines = profiler.getOverlayText();
+  if(lines.isEmpty())
+    return;
+
+  atools::util::PainterContextSaver saver(painter);
+
+  painter->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+  QFontMetrics metrics = painter->fontMetrics();
+
+  int width = 0;
+  for(const QString& line : lines)
+    width = std::max(width, metrics.width(line));
+
+  QRect rect(5, 5, width + 10, lines.size() * metrics.height() + 10);
+  painter->fillRect(rect, QColor(255, 255, 255, 210));
+
+  painter->setPen(Qt::black);
+  int y = rect.top() + 5 + metrics.ascent();
+  for(const QString& line : lines)
+  {
+    painter->drawText(rect.left() + 5, y, line);
+    y += metrics.height();
+  }
+}
+
+bool MapPaintLayer::StaticLayerKey::operator==(const StaticLayerKey& other) const
+{
+  return centerLon == other.centerLon && centerLat == other.centerLat && radius == other.radius &&
+         projection == other.projection && size == other.size && mapLayer == other.mapLayer &&
+         objectTypes == other.objectTypes && airspaceTypes == other.airspaceTypes &&
+         mapThemeId == other.mapThemeId && styleDark == other.styleDark && styleMapDimming == other.styleMapDimming;
+}
+
 bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport,
                            const QString& renderPos, GeoSceneLayer *layer)
 {
   Q_UNUSED(renderPos);
   Q_UNUSED(layer);
 
+  // Painters keep pointers to cached runways, parking and other objects for the whole pass
+  memcache::CachePin cachePin;
+
   if(!databaseLoadStatus)
   {
     // Update map scale for screen distance approximation
@@ -369,6 +671,13 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport,
       context.thicknessRangeDistance = od.getDisplayThicknessRangeDistance() / 100.f;
 
       context.dispOpts = od.getDisplayOptions();
+      context.simDataExtrapolationSec = mapWidget->getSimDataExtrapolationSec();
+
+      labelPlacement.clear();
+      context.labelPlacement = &labelPlacement;
+
+      vehicleBounds = VehiclePaintBounds();
+      context.vehicleBounds = &vehicleBounds;
 
       if(mapWidget->viewContext() == Marble::Still)
       {
@@ -383,50 +692,59 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport,
         painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
       }
 
-      mapPainterShip->render(&context);
+      // Tight budget while scrolling to keep the frame rate steady and a relaxed one when still.
+      // A refinement pass has no limit.
+      if(refinementPass)
+        context.timeBudgetMs = 0;
+      else
+        context.timeBudgetMs = context.viewContext == Marble::Animation ? timeBudgetAnimationMs : timeBudgetStillMs;
+      refinementPass = false;
 
-      if(mapWidget->distance() < layer::DISTANCE_CUT_OFF_LIMIT)
-      {
-        if(!context.isOverflow())
-          mapPainterAirspace->render(&context);
+      profiler.beginFrame();
+      context.frameTimer.start();
 
-        if(context.mapLayerEffective->isAirportDiagram())
-        {
-          // Put ILS below and navaids on top of airport diagram
-          mapPainterIls->render(&context);
+      // Ignore query time spent outside of painting
+      mapQuery->takeQueryTimeNs();
 
-          if(!context.isOverflow())
-            mapPainterAirport->render(&context);
+      renderPainter(mapPainterShip, &context);
 
-          if(!context.isOverflow())
-            mapPainterNav->render(&context);
-        }
+      if(mapWidget->distance() < layer::DISTANCE_CUT_OFF_LIMIT)
+      {
+        if(mapWidget->viewContext() == Marble::Still)
+          // Reuse image if only aircraft or other dynamic content changed
+          renderStaticLayersCached(&context);
         else
         {
-          // Airports on top of all
-          if(!context.isOverflow())
-            mapPainterIls->render(&context);
-
-          if(!context.isOverflow())
-            mapPainterNav->render(&context);
-
-          if(!context.isOverflow())
-            mapPainterAirport->render(&context);
+          // Viewport changes anyway while scrolling - paint directly
+          staticLayerValid = false;
+          renderStaticLayers(&context);
         }
       }
 
+      // Remember if static layers were cut - the following painters do not leave anything out for the time budget
+      bool staticLayersCut = context.timeBudgetExceeded || context.isObjectCountOverflow();
+      bool staticLayersTimeBudgetExceeded = context.timeBudgetExceeded;
+
       // if(!context.isOverflow()) always paint route even if number of objets is too large
-      mapPainterRoute->render(&context);
+      renderPainter(mapPainterRoute, &context);
 
       // if(!context.isOverflow())
-      mapPainterMark->render(&context);
+      renderPainter(mapPainterMark, &context);
 
-      mapPainterAircraft->render(&context);
+      renderPainter(mapPainterAircraft, &context);
 
-      if(context.isOverflow())
+      if(context.isObjectCountOverflow())
         overflow = PaintContext::MAX_OBJECT_COUNT;
       else
         overflow = 0;
+
+      if(staticLayersTimeBudgetExceeded)
+        // Complete the picture once the map stops moving
+        mapWidget->scheduleRefinement();
+
+      profiler.addTime(MapPaintProfiler::QUERY, mapQuery->takeQueryTimeNs());
+      profiler.addTime(MapPaintProfiler::TOTAL, context.frameTimer.nsecsElapsed());
+      profiler.endFrame(context.objectCount, staticLayersCut, context.viewContext == Marble::Animation);
     }
 
     // Dim the map by drawing a semi-transparent black rectangle
@@ -437,6 +755,9 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport,
       painter->fillRect(QRect(0, 0, painter->device()->width(), painter->device()->height()), col);
     }
 
+    if(showPaintStatistics)
+      drawPaintStatistics(painter);
+
   }
   return true;
 }
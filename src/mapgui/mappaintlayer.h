@@ -19,8 +19,12 @@
 #define LITTLENAVMAP_MAPPAINTLAYER_H
 
 #include "mapgui/mappainter.h"
+#include "common/labelplacement.h"
+#include "mapgui/mappaintprofiler.h"
 
+#include <QImage>
 #include <QPen>
+#include <QVector>
 
 #include <marble/LayerInterface.h>
 
@@ -103,10 +107,100 @@ public:
     return overflow;
   }
 
+  /* Show painter timings and object counts in the top left corner of the map */
+  void setShowPaintStatistics(bool show)
+  {
+    showPaintStatistics = show;
+  }
+
+  bool isShowPaintStatistics() const
+  {
+    return showPaintStatistics;
+  }
+
+  /* Screen area of user aircraft and track painted in the last frame */
+  const VehiclePaintBounds& getVehiclePaintBounds() const
+  {
+    return vehicleBounds;
+  }
+
+  /* Frame statistics of the latest paint events */
+  const MapPaintProfiler& getPaintProfiler() const
+  {
+    return profiler;
+  }
+
+  /* Remove cached airport diagram images. Needed if colors, units or fonts change. */
+  void clearAirportDiagramCache();
+
+  /* Remove cached AI aircraft label texts. Needed if units change. */
+  void clearAiLabelCache();
+
+  /* Paint the next frame without time budget to complete a frame that was cut short */
+  void setRefinementPass()
+  {
+    refinementPass = true;
+  }
+
+  /* Render airspaces, ILS, navaids and airports again on next paint event instead of using the cached image.
+   * Has to be called if the route, options or anything else that is not part of the viewport changes. */
+  void invalidateStaticLayers()
+  {
+    staticLayerValid = false;
+  }
+
 private:
+  /* Viewport and display settings the cached static layer image was rendered for */
+  struct StaticLayerKey
+  {
+    qreal centerLon = 0., centerLat = 0.;
+    int radius = 0, projection = 0;
+    QSize size;
+    const MapLayer *mapLayer = nullptr;
+    map::MapObjectTypes objectTypes = map::NONE;
+    map::MapAirspaceTypes airspaceTypes = map::AIRSPACE_NONE;
+
+    /* Map theme and GUI style */
+    QString mapThemeId;
+    bool styleDark = false;
+    int styleMapDimming = 0;
+
+    bool operator==(const StaticLayerKey& other) const;
+
+    bool operator!=(const StaticLayerKey& other) const
+    {
+      return !operator==(other);
+    }
+
+  };
+
   void initMapLayerSettings();
   void updateLayers();
 
+  /* Call painter and add the elapsed time to the profiler */
+  void renderPainter(MapPainter *painter, PaintContext *context);
+  MapPaintProfiler::Stage stageForPainter(const MapPainter *painter) const;
+
+  /* Draw the profiler overlay */
+  void drawPaintStatistics(Marble::GeoPainter *painter);
+
+  /* Paint airspaces, ILS, navaids and airports which do not change with simulator updates */
+  void renderStaticLayers(PaintContext *context);
+
+  /* Record the painters in the given z-order on the GUI thread which is the only one accessing map data.
+   * The recordings are rasterized into separate images on the thread pool and composited afterwards.
+   * budgetExceeded is set if a painter was cut by the time budget. */
+  void renderLayersParallel(PaintContext *context, const QVector<MapPainter *>& painters, qint64 frameBudgetMs,
+                            bool& budgetExceeded);
+
+  /* Set the time budget for the static painter at index. Painters below the airports get only a part of the
+   * frame budget. */
+  void beginStaticPainter(PaintContext *context, const QVector<MapPainter *>& painters, int index,
+                          qint64 frameBudgetMs);
+
+  /* Paint static layers into an image or reuse the image if the viewport and settings did not change */
+  void renderStaticLayersCached(PaintContext *context);
+
   /* Implemented from LayerInterface: We  draw above all but below user tools */
   virtual QStringList renderPosition() const override
   {
@@ -145,6 +239,35 @@ private:
   const MapLayer *mapLayer = nullptr, *mapLayerEffective = nullptr;
   int overflow = 0;
 
+  /* Transparent image containing the static layers and the number of objects painted into it */
+  QImage staticLayerImage;
+  StaticLayerKey staticLayerKey;
+  int staticLayerObjectCount = 0;
+  bool staticLayerValid = false;
+
+  MapPaintProfiler profiler;
+  bool showPaintStatistics = false;
+
+  /* Placed text labels of the current frame */
+  LabelPlacement labelPlacement;
+
+  VehiclePaintBounds vehicleBounds;
+
+  /* One transparent image for each painter if rendering in parallel */
+  QVector<QImage> layerImages;
+  bool parallelRendering = false;
+
+  /* Percentage of the frame time budget that painters below the airports may use */
+  static Q_DECL_CONSTEXPR int STATIC_BUDGET_PERCENT_AIRSPACE = 40;
+  static Q_DECL_CONSTEXPR int STATIC_BUDGET_PERCENT_ILS = 50;
+  static Q_DECL_CONSTEXPR int STATIC_BUDGET_PERCENT_NAV = 70;
+
+  /* Frame time budget in milliseconds while scrolling and when the map is still. 0 disables. */
+  qint64 timeBudgetAnimationMs = 40, timeBudgetStillMs = 1000;
+
+  /* Next frame completes the static layers without budget */
+  bool refinementPass = false;
+
 };
 
 #endif // LITTLENAVMAP_MAPPAINTLAYER_H
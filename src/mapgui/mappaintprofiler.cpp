@@ -0,0 +1,155 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "mapgui/mappaintprofiler.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+
+#include <algorithm>
+
+/* Upper limits of the frame time histogram buckets in milliseconds. Last one catches all above. */
+static const QVector<int> HISTOGRAM_LIMITS_MS({5, 10, 20, 40, 80, 160});
+
+MapPaintProfiler::MapPaintProfiler()
+{
+  beginFrame();
+}
+
+void MapPaintProfiler::beginFrame()
+{
+  current.timestamp = QDateTime::currentDateTime();
+  for(int i = 0; i < NUM_STAGES; i++)
+    current.nsecs[i] = 0;
+  current.objectCount = 0;
+  current.overflow = false;
+  current.animation = false;
+}
+
+void MapPaintProfiler::endFrame(int objectCount, bool overflow, bool animation)
+{
+  current.objectCount = objectCount;
+  current.overflow = overflow;
+  current.animation = animation;
+
+  if(frames.size() < MAX_FRAMES)
+    frames.append(current);
+  else
+    frames[next] = current;
+  next = (next + 1) % MAX_FRAMES;
+}
+
+void MapPaintProfiler::clear()
+{
+  frames.clear();
+  next = 0;
+  beginFrame();
+}
+
+const QString& MapPaintProfiler::stageName(Stage stage)
+{
+  static const QStringList NAMES({"Ship", "Airspace", "ILS", "Nav", "Airport", "Route", "Mark", "Aircraft",
+                                  "Query", "Composite", "Total"});
+  return NAMES.at(stage);
+}
+
+QStringList MapPaintProfiler::getOverlayText() const
+{
+  QStringList lines;
+  int num = std::min(OVERLAY_FRAMES, frames.size());
+  if(num == 0)
+    return lines;
+
+  // Collect latest frames from ring buffer
+  qint64 sum[NUM_STAGES] = {}, max[NUM_STAGES] = {};
+  QVector<int> histogram(HISTOGRAM_LIMITS_MS.size() + 1, 0);
+  int overflows = 0;
+  for(int i = 1; i <= num; i++)
+  {
+    const Frame& frame = frames.at((next - i + frames.size()) % frames.size());
+    for(int s = 0; s < NUM_STAGES; s++)
+    {
+      sum[s] += frame.nsecs[s];
+      max[s] = std::max(max[s], frame.nsecs[s]);
+    }
+
+    int bucket = 0;
+    while(bucket < HISTOGRAM_LIMITS_MS.size() && frame.nsecs[TOTAL] / 1000000 >= HISTOGRAM_LIMITS_MS.at(bucket))
+      bucket++;
+    histogram[bucket]++;
+
+    if(frame.overflow)
+      overflows++;
+  }
+
+  const Frame& last = frames.at((next - 1 + frames.size()) % frames.size());
+  lines.append(QString("Frames %1 objects %2%3").
+               arg(num).arg(last.objectCount).arg(last.overflow ? " overflow" : QString()));
+  lines.append(QString("%1 %2 %3 %4").
+               arg("Stage", -10).arg("last", 7).arg("avg", 7).arg("max", 7));
+
+  for(int s = 0; s < NUM_STAGES; s++)
+    lines.append(QString("%1 %2 %3 %4").
+                 arg(stageName(static_cast<Stage>(s)), -10).
+                 arg(last.nsecs[s] / 1000000., 7, 'f', 2).
+                 arg(sum[s] / num / 1000000., 7, 'f', 2).
+                 arg(max[s] / 1000000., 7, 'f', 2));
+
+  QString hist("Histogram ms");
+  for(int i = 0; i < histogram.size(); i++)
+    hist += QString(" %1%2:%3").
+            arg(i < HISTOGRAM_LIMITS_MS.size() ? "<" : ">=").
+            arg(i < HISTOGRAM_LIMITS_MS.size() ? HISTOGRAM_LIMITS_MS.at(i) : HISTOGRAM_LIMITS_MS.last()).
+            arg(histogram.at(i));
+  lines.append(hist);
+  lines.append(QString("Overflows %1").arg(overflows));
+  return lines;
+}
+
+bool MapPaintProfiler::saveCsv(const QString& filename) const
+{
+  QFile file(filename);
+  if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+    return false;
+  }
+
+  QTextStream stream(&file);
+  stream << "Timestamp,Animation,Objects,Overflow";
+  for(int s = 0; s < NUM_STAGES; s++)
+    stream << "," << stageName(static_cast<Stage>(s)) << " ms";
+  stream << endl;
+
+  // Oldest frame first
+  int start = frames.size() < MAX_FRAMES ? 0 : next;
+  for(int i = 0; i < frames.size(); i++)
+  {
+    const Frame& frame = frames.at((start + i) % frames.size());
+    stream << frame.timestamp.toString("yyyy-MM-ddTHH:mm:ss.zzz") << "," << frame.animation << ","
+           << frame.objectCount << "," << frame.overflow;
+    for(int s = 0; s < NUM_STAGES; s++)
+      stream << "," << QString::number(frame.nsecs[s] / 1000000., 'f', 3);
+    stream << endl;
+  }
+
+  file.close();
+  qInfo() << Q_FUNC_INFO << "Saved" << frames.size() << "frames to" << filename;
+  return true;
+}
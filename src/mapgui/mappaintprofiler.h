@@ -0,0 +1,104 @@
+/*****************************************************************************
+* Copyright 2015-2017 Alexander Barthel albar965@mailbox.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LITTLENAVMAP_MAPPAINTPROFILER_H
+#define LITTLENAVMAP_MAPPAINTPROFILER_H
+
+#include <QDateTime>
+#include <QStringList>
+#include <QVector>
+
+/*
+ * Collects frame times for each painter of the MapPaintLayer together with query time, object counts and
+ * overflow state. Keeps a rolling window of the latest frames which can be shown as an overlay on the map
+ * or saved as CSV to compare configurations and map themes.
+ *
+ * Query time is also contained in the painter times since painters load their data on demand.
+ */
+class MapPaintProfiler
+{
+public:
+  enum Stage
+  {
+    SHIP,
+    AIRSPACE,
+    ILS,
+    NAV,
+    AIRPORT,
+    ROUTE,
+    MARK,
+    AIRCRAFT,
+    QUERY, /* Time spent in MapQuery */
+    COMPOSITE, /* Rasterization of recorded layers and drawing of cached layer images */
+    TOTAL,
+    NUM_STAGES
+  };
+
+  MapPaintProfiler();
+
+  /* Clear timings for a new frame */
+  void beginFrame();
+
+  /* Add time to a stage of the current frame */
+  void addTime(Stage stage, qint64 nsecs)
+  {
+    current.nsecs[stage] += nsecs;
+  }
+
+  /* Store the current frame in the rolling window */
+  void endFrame(int objectCount, bool overflow, bool animation);
+
+  /* Remove all frames */
+  void clear();
+
+  /* Text lines showing average and maximum for each stage and a histogram of total frame times */
+  QStringList getOverlayText() const;
+
+  /* Write all frames of the window to a CSV file. Returns false if the file could not be written. */
+  bool saveCsv(const QString& filename) const;
+
+  int getNumFrames() const
+  {
+    return frames.size();
+  }
+
+  static const QString& stageName(Stage stage);
+
+private:
+  struct Frame
+  {
+    QDateTime timestamp;
+    qint64 nsecs[NUM_STAGES];
+    int objectCount;
+    bool overflow, animation;
+  };
+
+  /* Number of frames kept for overlay and CSV */
+  static Q_DECL_CONSTEXPR int MAX_FRAMES = 1000;
+
+  /* Number of latest frames used for the overlay */
+  static Q_DECL_CONSTEXPR int OVERLAY_FRAMES = 100;
+
+  Frame current;
+
+  /* Ring buffer */
+  QVector<Frame> frames;
+  int next = 0;
+};
+
+#endif // LITTLENAVMAP_MAPPAINTPROFILER_H
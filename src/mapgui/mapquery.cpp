@@ -22,9 +22,11 @@
 #include "common/maptools.h"
 #include "sql/sqlquery.h"
 #include "common/maptools.h"
+#include "options/optiondata.h"
 #include "settings/settings.h"
 
 #include <QDataStream>
+#include <QElapsedTimer>
 #include <QRegularExpression>
 
 using namespace Marble;
@@ -56,21 +58,14 @@ MapQuery::MapQuery(QObject *parent, atools::sql::SqlDatabase *sqlDb)
   mapTypesFactory = new MapTypesFactory();
   atools::settings::Settings& settings = atools::settings::Settings::instance();
 
-  runwayCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "RunwayCache", 2000).toInt());
-  runwayOverwiewCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "RunwayOverwiewCache", 1000).toInt());
-  apronCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "ApronCache", 1000).toInt());
-  taxipathCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "TaxipathCache", 1000).toInt());
-  parkingCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "ParkingCache", 1000).toInt());
-  startCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "StartCache", 1000).toInt());
-  helipadCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "HelipadCache", 1000).toInt());
-  airspaceLineCache.setMaxCost(settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "AirspaceLineCache", 10000).toInt());
-
   queryRectInflationFactor = settings.getAndStoreValue(
     lnm::SETTINGS_MAPQUERY + "QueryRectInflationFactor", 0.3).toDouble();
   queryRectInflationIncrement = settings.getAndStoreValue(
     lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement", 0.1).toDouble();
   queryRowLimit = settings.getAndStoreValue(
     lnm::SETTINGS_MAPQUERY + "QueryRowLimit", 5000).toInt();
+  recordBindingBenchmark = settings.getAndStoreValue(
+    lnm::SETTINGS_MAPQUERY + "RecordBindingBenchmark", false).toBool();
 }
 
 MapQuery::~MapQuery()
@@ -588,7 +583,7 @@ void MapQuery::getNearestObjects(const CoordinateConverter& conv, const MapLayer
       // Also check parking and helipads in airport diagrams
       for(int id : parkingCache.keys())
       {
-        QList<MapParking> *parkings = parkingCache.object(id);
+        const QList<MapParking> *parkings = parkingCache.peek(id);
         for(const MapParking& p : *parkings)
         {
           if(conv.wToS(p.position, x, y) && atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
@@ -598,7 +593,7 @@ void MapQuery::getNearestObjects(const CoordinateConverter& conv, const MapLayer
 
       for(int id : helipadCache.keys())
       {
-        QList<MapHelipad> *helipads = helipadCache.object(id);
+        const QList<MapHelipad> *helipads = helipadCache.peek(id);
         for(const MapHelipad& p : *helipads)
         {
           if(conv.wToS(p.position, x, y) && atools::geo::manhattanDistance(x, y, xs, ys) < screenDistance)
@@ -612,6 +607,7 @@ void MapQuery::getNearestObjects(const CoordinateConverter& conv, const MapLayer
 const QList<map::MapAirport> *MapQuery::getAirports(const Marble::GeoDataLatLonBox& rect,
                                                     const MapLayer *mapLayer, bool lazy)
 {
+  QueryTimer queryTimer(queryTimeNs);
   airportCache.updateCache(rect, mapLayer, lazy,
                            [] (const MapLayer * curLayer, const MapLayer * newLayer)->bool
                            {
@@ -639,6 +635,7 @@ const QList<map::MapAirport> *MapQuery::getAirports(const Marble::GeoDataLatLonB
 const QList<map::MapWaypoint> *MapQuery::getWaypoints(const GeoDataLatLonBox& rect,
                                                       const MapLayer *mapLayer, bool lazy)
 {
+  QueryTimer queryTimer(queryTimeNs);
   waypointCache.updateCache(rect, mapLayer, lazy,
                             [] (const MapLayer * curLayer, const MapLayer * newLayer)->bool
                             {
@@ -654,7 +651,7 @@ const QList<map::MapWaypoint> *MapQuery::getWaypoints(const GeoDataLatLonBox& re
       while(waypointsByRectQuery->next())
       {
         map::MapWaypoint wp;
-        mapTypesFactory->fillWaypoint(waypointsByRectQuery->record(), wp);
+        mapTypesFactory->fillWaypoint(recordBinding(waypointsByRectQuery), wp);
         waypointCache.list.append(wp);
       }
     }
@@ -663,9 +660,77 @@ const QList<map::MapWaypoint> *MapQuery::getWaypoints(const GeoDataLatLonBox& re
   return &waypointCache.list;
 }
 
+const QList<map::MapObjectCluster> *MapQuery::getAirportClusters(float cellSizeDeg, map::MapObjectTypes types,
+                                                                 int minRunwayLength)
+{
+  QueryTimer queryTimer(queryTimeNs);
+  // Only airport related flags are relevant for the filter
+  types &= map::AIRPORT_ALL;
+
+  // Airport visibility also depends on the empty airport option
+  bool emptyAirports = OptionData::instance().getFlags() & opts::MAP_EMPTY_AIRPORTS;
+
+  if(!airportClusterCache.isValid(airportCache.version, airportCache.list.size(), cellSizeDeg, types,
+                                  minRunwayLength) || airportClusterCache.emptyAirports != emptyAirports)
+  {
+    maptools::clusterObjects<MapAirport>(airportCache.list, cellSizeDeg, airportClusterCache.list,
+                                         [types, minRunwayLength](const MapAirport& airport) -> bool
+                                         {
+                                           return airport.isVisible(types) &&
+                                           airport.longestRunwayLength >= minRunwayLength;
+                                         },
+                                         [](const MapAirport& airport) -> int
+                                         {
+                                           return airport.longestRunwayLength;
+                                         });
+
+    airportClusterCache.sourceVersion = airportCache.version;
+    airportClusterCache.sourceSize = airportCache.list.size();
+    airportClusterCache.cellSizeDeg = cellSizeDeg;
+    airportClusterCache.types = types;
+    airportClusterCache.minRunwayLength = minRunwayLength;
+    airportClusterCache.emptyAirports = emptyAirports;
+    airportClusterCache.valid = true;
+  }
+  return &airportClusterCache.list;
+}
+
+const QList<map::MapObjectCluster> *MapQuery::getWaypointClusters(float cellSizeDeg, map::MapObjectTypes types)
+{
+  QueryTimer queryTimer(queryTimeNs);
+
+  // Only waypoint and airway flags are relevant for the filter
+  types &= map::WAYPOINT | map::AIRWAYV | map::AIRWAYJ;
+
+  if(!waypointClusterCache.isValid(waypointCache.version, waypointCache.list.size(), cellSizeDeg, types, 0))
+  {
+    maptools::clusterObjects<MapWaypoint>(waypointCache.list, cellSizeDeg, waypointClusterCache.list,
+                                          [types](const MapWaypoint& waypoint) -> bool
+                                          {
+                                            // Same filter as used for drawing single waypoints
+                                            return types.testFlag(map::WAYPOINT) ||
+                                            (types.testFlag(map::AIRWAYV) && waypoint.hasVictorAirways) ||
+                                            (types.testFlag(map::AIRWAYJ) && waypoint.hasJetAirways);
+                                          },
+                                          [](const MapWaypoint& waypoint) -> int
+                                          {
+                                            // Prefer airway waypoints as representatives
+                                            return waypoint.hasJetAirways * 2 + waypoint.hasVictorAirways;
+                                          });
+
+    waypointClusterCache.sourceVersion = waypointCache.version;
+    waypointClusterCache.sourceSize = waypointCache.list.size();
+    waypointClusterCache.cellSizeDeg = cellSizeDeg;
+    waypointClusterCache.types = types;
+    waypointClusterCache.valid = true;
+  }
+  return &waypointClusterCache.list;
+}
+
 const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                             bool lazy)
 {
+  QueryTimer queryTimer(queryTimeNs);
   vorCache.updateCache(rect, mapLayer, lazy,
                        [] (const MapLayer * curLayer, const MapLayer * newLayer)->bool
                        {
@@ -681,7 +746,7 @@ const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const
       while(vorsByRectQuery->next())
       {
         map::MapVor vor;
-        mapTypesFactory->fillVor(vorsByRectQuery->record(), vor);
+        mapTypesFactory->fillVor(recordBinding(vorsByRectQuery), vor);
         vorCache.list.append(vor);
       }
     }
@@ -693,6 +758,7 @@ const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const
 const QList<map::MapNdb> *MapQuery::getNdbs(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                             bool lazy)
 {
+  QueryTimer queryTimer(queryTimeNs);
   ndbCache.updateCache(rect, mapLayer, lazy,
                        [] (const MapLayer * curLayer, const MapLayer * newLayer)->bool
                        {
@@ -708,7 +774,7 @@ const QList<map::MapNdb> *MapQuery::getNdbs(const GeoDataLatLonBox& rect, const
       while(ndbsByRectQuery->next())
       {
         map::MapNdb ndb;
-        mapTypesFactory->fillNdb(ndbsByRectQuery->record(), ndb);
+        mapTypesFactory->fillNdb(recordBinding(ndbsByRectQuery), ndb);
         ndbCache.list.append(ndb);
       }
     }
@@ -720,6 +786,7 @@ const QList<map::MapNdb> *MapQuery::getNdbs(const GeoDataLatLonBox& rect, const
 const QList<map::MapMarker> *MapQuery::getMarkers(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                                   bool lazy)
 {
+  QueryTimer queryTimer(queryTimeNs);
   markerCache.updateCache(rect, mapLayer, lazy,
                           [] (const MapLayer * curLayer, const MapLayer * newLayer)->bool
                           {
@@ -735,7 +802,7 @@ const QList<map::MapMarker> *MapQuery::getMarkers(const GeoDataLatLonBox& rect,
       while(markersByRectQuery->next())
       {
         map::MapMarker marker;
-        mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
+        mapTypesFactory->fillMarker(recordBinding(markersByRectQuery), marker);
         markerCache.list.append(marker);
       }
     }
@@ -746,6 +813,7 @@ const QList<map::MapMarker> *MapQuery::getMarkers(const GeoDataLatLonBox& rect,
 
 const QList<map::MapIls> *MapQuery::getIls(const GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy)
 {
+  QueryTimer queryTimer(queryTimeNs);
   ilsCache.updateCache(rect, mapLayer, lazy,
                        [] (const MapLayer * curLayer, const MapLayer * newLayer)->bool
                        {
@@ -761,7 +829,7 @@ const QList<map::MapIls> *MapQuery::getIls(const GeoDataLatLonBox& rect, const M
       while(ilsByRectQuery->next())
       {
         map::MapIls ils;
-        mapTypesFactory->fillIls(ilsByRectQuery->record(), ils);
+        mapTypesFactory->fillIls(recordBinding(ilsByRectQuery), ils);
         ilsCache.list.append(ils);
       }
     }
@@ -772,6 +840,7 @@ const QList<map::MapIls> *MapQuery::getIls(const GeoDataLatLonBox& rect, const M
 
 const QList<map::MapAirway> *MapQuery::getAirways(const GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy)
 {
+  QueryTimer queryTimer(queryTimeNs);
   airwayCache.updateCache(rect, mapLayer, lazy,
                           [] (const MapLayer * curLayer, const MapLayer * newLayer)->bool
                           {
@@ -787,7 +856,7 @@ const QList<map::MapAirway> *MapQuery::getAirways(const GeoDataLatLonBox& rect,
       while(airwayByRectQuery->next())
       {
         map::MapAirway airway;
-        mapTypesFactory->fillAirway(airwayByRectQuery->record(), airway);
+        mapTypesFactory->fillAirway(recordBinding(airwayByRectQuery), airway);
         airwayCache.list.append(airway);
       }
     }
@@ -799,6 +868,7 @@ const QList<map::MapAirway> *MapQuery::getAirways(const GeoDataLatLonBox& rect,
 const QList<map::MapAirspace> *MapQuery::getAirspaces(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                                       map::MapAirspaceTypes types, float flightPlanAltitude, bool lazy)
 {
+  QueryTimer queryTimer(queryTimeNs);
   airspaceCache.updateCache(rect, mapLayer, lazy,
                             [] (const MapLayer * curLayer, const MapLayer * newLayer)->bool
                             {
@@ -880,7 +950,7 @@ const QList<map::MapAirspace> *MapQuery::getAirspaces(const GeoDataLatLonBox& re
           while(query->next())
           {
             map::MapAirspace airspace;
-            mapTypesFactory->fillAirspace(query->record(), airspace);
+            mapTypesFactory->fillAirspace(recordBinding(query), airspace);
             airspaceCache.list.append(airspace);
           }
         }
@@ -900,8 +970,10 @@ const QList<map::MapAirspace> *MapQuery::getAirspaces(const GeoDataLatLonBox& re
 
 const LineString *MapQuery::getAirspaceGeometry(int boundaryId)
 {
-  if(airspaceLineCache.contains(boundaryId))
-    return airspaceLineCache.object(boundaryId);
+  QueryTimer queryTimer(queryTimeNs);
+  const LineString *cached = airspaceLineCache.object(boundaryId);
+  if(cached != nullptr)
+    return cached;
   else
   {
     LineString *lines = new LineString;
@@ -925,7 +997,8 @@ const LineString *MapQuery::getAirspaceGeometry(int boundaryId)
       }
     }
 
-    airspaceLineCache.insert(boundaryId, lines);
+    airspaceLineCache.insert(boundaryId, lines,
+                             static_cast<qint64>(sizeof(LineString) + lines->size() * sizeof(Pos)));
 
     return lines;
   }
@@ -953,9 +1026,9 @@ const QList<map::MapAirport> *MapQuery::fetchAirports(const Marble::GeoDataLatLo
         map::MapAirport ap;
         if(overview)
           // Fill only a part of the object
-          mapTypesFactory->fillAirportForOverview(query->record(), ap);
+          mapTypesFactory->fillAirportForOverview(recordBinding(query), ap);
         else
-          mapTypesFactory->fillAirport(query->record(), ap, true);
+          mapTypesFactory->fillAirport(recordBinding(query), ap, true);
 
         if(reverse)
           airportCache.list.prepend(ap);
@@ -970,8 +1043,10 @@ const QList<map::MapAirport> *MapQuery::fetchAirports(const Marble::GeoDataLatLo
 
 const QList<map::MapRunway> *MapQuery::getRunwaysForOverview(int airportId)
 {
-  if(runwayOverwiewCache.contains(airportId))
-    return runwayOverwiewCache.object(airportId);
+  QueryTimer queryTimer(queryTimeNs);
+  const QList<map::MapRunway> *cached = runwayOverwiewCache.object(airportId);
+  if(cached != nullptr)
+    return cached;
   else
   {
     using atools::geo::Pos;
@@ -983,18 +1058,20 @@ const QList<map::MapRunway> *MapQuery::getRunwaysForOverview(int airportId)
     while(runwayOverviewQuery->next())
     {
       map::MapRunway runway;
-      mapTypesFactory->fillRunway(runwayOverviewQuery->record(), runway, true);
+      mapTypesFactory->fillRunway(recordBinding(runwayOverviewQuery), runway, true);
       rws->append(runway);
     }
-    runwayOverwiewCache.insert(airportId, rws);
+    runwayOverwiewCache.insert(airportId, rws, memcache::listBytes(*rws));
     return rws;
   }
 }
 
 const QList<map::MapApron> *MapQuery::getAprons(int airportId)
 {
-  if(apronCache.contains(airportId))
-    return apronCache.object(airportId);
+  QueryTimer queryTimer(queryTimeNs);
+  const QList<map::MapApron> *cached = apronCache.object(airportId);
+  if(cached != nullptr)
+    return cached;
   else
   {
     apronQuery->bindValue(":airportId", airportId);
@@ -1024,15 +1101,20 @@ const QList<map::MapApron> *MapQuery::getAprons(int airportId)
       }
       aprons->append(ap);
     }
-    apronCache.insert(airportId, aprons);
+    qint64 bytes = memcache::listBytes(*aprons);
+    for(const map::MapApron& apron : *aprons)
+      bytes += static_cast<qint64>(apron.vertices.size() * sizeof(Pos));
+    apronCache.insert(airportId, aprons, bytes);
     return aprons;
   }
 }
 
 const QList<map::MapParking> *MapQuery::getParkingsForAirport(int airportId)
 {
-  if(parkingCache.contains(airportId))
-    return parkingCache.object(airportId);
+  QueryTimer queryTimer(queryTimeNs);
+  const QList<map::MapParking> *cached = parkingCache.object(airportId);
+  if(cached != nullptr)
+    return cached;
   else
   {
     parkingQuery->bindValue(":airportId", airportId);
@@ -1044,18 +1126,19 @@ const QList<map::MapParking> *MapQuery::getParkingsForAirport(int airportId)
       map::MapParking p;
 
       // Vehicle paths are filtered out in the compiler
-      mapTypesFactory->fillParking(parkingQuery->record(), p);
+      mapTypesFactory->fillParking(recordBinding(parkingQuery), p);
       ps->append(p);
     }
-    parkingCache.insert(airportId, ps);
+    parkingCache.insert(airportId, ps, memcache::listBytes(*ps));
     return ps;
   }
 }
 
 const QList<map::MapStart> *MapQuery::getStartPositionsForAirport(int airportId)
 {
-  if(startCache.contains(airportId))
-    return startCache.object(airportId);
+  const QList<map::MapStart> *cached = startCache.object(airportId);
+  if(cached != nullptr)
+    return cached;
   else
   {
     startQuery->bindValue(":airportId", airportId);
@@ -1065,10 +1148,10 @@ const QList<map::MapStart> *MapQuery::getStartPositionsForAirport(int airportId)
     while(startQuery->next())
     {
       map::MapStart p;
-      mapTypesFactory->fillStart(startQuery->record(), p);
+      mapTypesFactory->fillStart(recordBinding(startQuery), p);
       ps->append(p);
     }
-    startCache.insert(airportId, ps);
+    startCache.insert(airportId, ps, memcache::listBytes(*ps));
     return ps;
   }
 }
@@ -1184,8 +1267,10 @@ void MapQuery::getParkingByNameAndNumber(QList<map::MapParking>& parkings, int a
 
 const QList<map::MapHelipad> *MapQuery::getHelipads(int airportId)
 {
-  if(helipadCache.contains(airportId))
-    return helipadCache.object(airportId);
+  QueryTimer queryTimer(queryTimeNs);
+  const QList<map::MapHelipad> *cached = helipadCache.object(airportId);
+  if(cached != nullptr)
+    return cached;
   else
   {
     helipadQuery->bindValue(":airportId", airportId);
@@ -1214,15 +1299,17 @@ const QList<map::MapHelipad> *MapQuery::getHelipads(int airportId)
 
       hs->append(hp);
     }
-    helipadCache.insert(airportId, hs);
+    helipadCache.insert(airportId, hs, memcache::listBytes(*hs));
     return hs;
   }
 }
 
 const QList<map::MapTaxiPath> *MapQuery::getTaxiPaths(int airportId)
 {
-  if(taxipathCache.contains(airportId))
-    return taxipathCache.object(airportId);
+  QueryTimer queryTimer(queryTimeNs);
+  const QList<map::MapTaxiPath> *cached = taxipathCache.object(airportId);
+  if(cached != nullptr)
+    return cached;
   else
   {
     taxiparthQuery->bindValue(":airportId", airportId);
@@ -1243,15 +1330,17 @@ const QList<map::MapTaxiPath> *MapQuery::getTaxiPaths(int airportId)
 
       tps->append(tp);
     }
-    taxipathCache.insert(airportId, tps);
+    taxipathCache.insert(airportId, tps, memcache::listBytes(*tps));
     return tps;
   }
 }
 
 const QList<map::MapRunway> *MapQuery::getRunways(int airportId)
 {
-  if(runwayCache.contains(airportId))
-    return runwayCache.object(airportId);
+  QueryTimer queryTimer(queryTimeNs);
+  const QList<map::MapRunway> *cached = runwayCache.object(airportId);
+  if(cached != nullptr)
+    return cached;
   else
   {
     runwaysQuery->bindValue(":airportId", airportId);
@@ -1261,7 +1350,7 @@ const QList<map::MapRunway> *MapQuery::getRunways(int airportId)
     while(runwaysQuery->next())
     {
       map::MapRunway runway;
-      mapTypesFactory->fillRunway(runwaysQuery->record(), runway, false);
+      mapTypesFactory->fillRunway(recordBinding(runwaysQuery), runway, false);
       rs->append(runway);
     }
 
@@ -1269,7 +1358,7 @@ const QList<map::MapRunway> *MapQuery::getRunways(int airportId)
     using namespace std::placeholders;
     std::sort(rs->begin(), rs->end(), std::bind(&MapQuery::runwayCompare, this, _1, _2));
 
-    runwayCache.insert(airportId, rs);
+    runwayCache.insert(airportId, rs, memcache::listBytes(*rs));
     return rs;
   }
 }
@@ -1633,10 +1722,69 @@ void MapQuery::initQueries()
   airspaceLinesByIdQuery = new SqlQuery(db);
   airspaceLinesByIdQuery->prepare("select geometry from boundary where boundary_id = :id");
 
+  if(recordBindingBenchmark)
+    benchmarkRecordBinding("select " + airportQueryBase + " from airport",
+                           "select " + waypointQueryBase + " from waypoint");
+}
+
+const SqlRecordBinding& MapQuery::recordBinding(atools::sql::SqlQuery *query)
+{
+  auto it = recordBindings.find(query);
+  if(it == recordBindings.end())
+    it = recordBindings.insert(query, SqlRecordBinding(query));
+  return it.value();
+}
+
+void MapQuery::benchmarkRecordBinding(const QString& airportSql, const QString& waypointSql)
+{
+  // Loads all rows and fills the objects using either column name lookups or a binding
+  auto measure = [this](const QString& sql, const QString& name, bool bound)
+                 {
+                   SqlQuery query(db);
+                   query.exec(sql);
+
+                   SqlRecordBinding binding(&query);
+                   QElapsedTimer timer;
+                   timer.start();
+                   int rows = 0;
+                   bool airport = name == "airport";
+                   while(query.next())
+                   {
+                     if(airport)
+                     {
+                       map::MapAirport ap;
+                       if(bound)
+                         mapTypesFactory->fillAirport(binding, ap, true);
+                       else
+                         mapTypesFactory->fillAirport(query.record(), ap, true);
+                     }
+                     else
+                     {
+                       map::MapWaypoint waypoint;
+                       if(bound)
+                         mapTypesFactory->fillWaypoint(binding, waypoint);
+                       else
+                         mapTypesFactory->fillWaypoint(query.record(), waypoint);
+                     }
+                     rows++;
+                   }
+
+                   qint64 ms = std::max(timer.elapsed(), static_cast<qint64>(1));
+                   qInfo() << "Benchmark" << name << (bound ? "with binding" : "without binding")
+                           << rows << "rows in" << ms << "ms" << (rows * 1000 / ms) << "rows/s";
+                 };
+
+  measure(airportSql, "airport", false);
+  measure(airportSql, "airport", true);
+  measure(waypointSql, "waypoint", false);
+  measure(waypointSql, "waypoint", true);
 }
 
 void MapQuery::deInitQueries()
 {
+  memcache::CacheBudget::instance().logStatistics();
+
+  recordBindings.clear();
   airportCache.clear();
   waypointCache.clear();
   vorCache.clear();
@@ -1645,6 +1793,8 @@ void MapQuery::deInitQueries()
   ilsCache.clear();
   airwayCache.clear();
   airspaceCache.clear();
+  airportClusterCache.clear();
+  waypointClusterCache.clear();
   airspaceLineCache.clear();
   runwayCache.clear();
   runwayOverwiewCache.clear();
@@ -19,9 +19,12 @@
 #define LITTLENAVMAP_MAPQUERY_H
 
 #include "common/maptypes.h"
+#include "common/memorycache.h"
+#include "common/sqlrecordbinding.h"
 #include "mapgui/maplayer.h"
+#include "atools.h"
 
-#include <QCache>
+#include <QElapsedTimer>
 #include <QList>
 
 #include <functional>
@@ -181,6 +184,23 @@ public:
   /* Similar to getAirports */
   const QList<map::MapAirway> *getAirways(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, bool lazy);
 
+  /*
+   * Get grid clusters for the current airport cache as filled by the last call to getAirports.
+   * Airports are grouped into cells of cellSizeDeg and each cluster refers to the airport with the longest
+   * runway by index into the airport cache. Result is cached until the airport cache or the parameters change.
+   * @param types object types used to filter the airports
+   * @param minRunwayLength airports having shorter runways are ignored
+   */
+  const QList<map::MapObjectCluster> *getAirportClusters(float cellSizeDeg, map::MapObjectTypes types,
+                                                         int minRunwayLength);
+
+  /*
+   * Similar to getAirportClusters. Waypoints on jet airways are preferred as representatives.
+   * @param types WAYPOINT includes all waypoints. Otherwise only waypoints on airways of type AIRWAYV or AIRWAYJ
+   * are clustered.
+   */
+  const QList<map::MapObjectCluster> *getWaypointClusters(float cellSizeDeg, map::MapObjectTypes types);
+
   const QList<map::MapAirspace> *getAirspaces(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                               map::MapAirspaceTypes types, float flightPlanAltitude, bool lazy);
   const atools::geo::LineString *getAirspaceGeometry(int boundaryId);
@@ -208,7 +228,35 @@ public:
   /* Create and prepare all queries */
   void deInitQueries();
 
+  /* Get the time spent in map object queries since the last call and reset it */
+  qint64 takeQueryTimeNs()
+  {
+    qint64 retval = queryTimeNs;
+    queryTimeNs = 0;
+    return retval;
+  }
+
+private:
+  /* Adds the time spent in a query method to a sum */
+  class QueryTimer
+  {
+public:
+    QueryTimer(qint64& timeSum)
+      : sum(timeSum)
+    {
+      timer.start();
+    }
+
+    ~QueryTimer()
+    {
+      sum += timer.nsecsElapsed();
+    }
+
 private:
+    qint64& sum;
+    QElapsedTimer timer;
+  };
+
   /* Simple spatial cache that deals with objects in a bounding rectangle but does not run any queries to load data */
   template<typename TYPE>
   struct SimpleRectCache
@@ -229,6 +277,34 @@ private:
     Marble::GeoDataLatLonBox curRect;
     const MapLayer *curMapLayer = nullptr;
     QList<TYPE> list;
+
+    /* Incremented each time the list is cleared to allow dependent caches to detect changes */
+    quint32 version = 0;
+  };
+
+  /* Cluster list for one of the rectangle caches. Valid as long as the source cache and parameters are unchanged. */
+  struct ClusterCache
+  {
+    bool isValid(quint32 version, int size, float cellSize, map::MapObjectTypes objectTypes, int minLength) const
+    {
+      return valid && sourceVersion == version && sourceSize == size && atools::almostEqual(cellSizeDeg, cellSize) &&
+             types == objectTypes && minRunwayLength == minLength;
+    }
+
+    void clear()
+    {
+      list.clear();
+      valid = false;
+    }
+
+    QList<map::MapObjectCluster> list;
+    quint32 sourceVersion = 0;
+    int sourceSize = 0;
+    float cellSizeDeg = 0.f;
+    map::MapObjectTypes types = map::NONE;
+    int minRunwayLength = 0;
+    bool emptyAirports = false; /* Option state for empty airports used to build the airport clusters */
+    bool valid = false;
   };
 
   const QList<map::MapAirport> *fetchAirports(const Marble::GeoDataLatLonBox& rect,
@@ -242,11 +318,23 @@ private:
 
   static void inflateRect(Marble::GeoDataLatLonBox& rect, double width, double height);
 
+  /* Get the column binding reading from the current row of the query */
+  const SqlRecordBinding& recordBinding(atools::sql::SqlQuery *query);
+
+  /* Log rows per second for bulk airport and waypoint loads with and without column binding */
+  void benchmarkRecordBinding(const QString& airportSql, const QString& waypointSql);
+
   bool runwayCompare(const map::MapRunway& r1, const map::MapRunway& r2);
 
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *db;
 
+  /* Column positions for the bulk loading queries */
+  QHash<atools::sql::SqlQuery *, SqlRecordBinding> recordBindings;
+
+  /* Time spent in painter queries. Read and reset by the paint layer profiler. */
+  qint64 queryTimeNs = 0;
+
   /* Simple bounding rectangle caches */
   SimpleRectCache<map::MapAirport> airportCache;
   SimpleRectCache<map::MapWaypoint> waypointCache;
@@ -256,24 +344,31 @@ private:
   SimpleRectCache<map::MapIls> ilsCache;
   SimpleRectCache<map::MapAirway> airwayCache;
   SimpleRectCache<map::MapAirspace> airspaceCache;
+
+  /* Clusters built from airportCache and waypointCache */
+  ClusterCache airportClusterCache, waypointClusterCache;
+
   map::MapAirspaceTypes lastAirspaceTypes = map::AIRSPACE_NONE;
   float lastFlightplanAltitude = 0.f;
 
   /* ID/object caches */
-  QCache<int, QList<map::MapRunway> > runwayCache;
-  QCache<int, QList<map::MapRunway> > runwayOverwiewCache;
-  QCache<int, QList<map::MapApron> > apronCache;
-  QCache<int, QList<map::MapTaxiPath> > taxipathCache;
-  QCache<int, QList<map::MapParking> > parkingCache;
-  QCache<int, QList<map::MapStart> > startCache;
-  QCache<int, QList<map::MapHelipad> > helipadCache;
-  QCache<int, atools::geo::LineString> airspaceLineCache;
+  memcache::MemoryCache<int, QList<map::MapRunway> > runwayCache{"MapQuery Runway"};
+  memcache::MemoryCache<int, QList<map::MapRunway> > runwayOverwiewCache{"MapQuery Runway Overview"};
+  memcache::MemoryCache<int, QList<map::MapApron> > apronCache{"MapQuery Apron"};
+  memcache::MemoryCache<int, QList<map::MapTaxiPath> > taxipathCache{"MapQuery Taxipath"};
+  memcache::MemoryCache<int, QList<map::MapParking> > parkingCache{"MapQuery Parking"};
+  memcache::MemoryCache<int, QList<map::MapStart> > startCache{"MapQuery Start"};
+  memcache::MemoryCache<int, QList<map::MapHelipad> > helipadCache{"MapQuery Helipad"};
+  memcache::MemoryCache<int, atools::geo::LineString> airspaceLineCache{"MapQuery Airspace Line"};
 
   /* Inflate bounding rectangle before passing it to query */
   static double queryRectInflationFactor;
   static double queryRectInflationIncrement;
   static int queryRowLimit;
 
+  /* Log a bulk load benchmark after each initQueries call. Set "Settings/MapQueryRecordBindingBenchmark" to enable. */
+  bool recordBindingBenchmark = false;
+
   /* Database queries */
   atools::sql::SqlQuery *airportByRectQuery = nullptr, *airportMediumByRectQuery = nullptr,
   *airportLargeByRectQuery = nullptr;
@@ -323,6 +418,7 @@ bool MapQuery::SimpleRectCache<TYPE>::updateCache(const Marble::GeoDataLatLonBox
   {
     // Rectangle not covered by loaded data or new layer selected
     list.clear();
+    version++;
     curRect = rect;
     curMapLayer = mapLayer;
     return true;
@@ -344,6 +440,7 @@ template<typename TYPE>
 void MapQuery::SimpleRectCache<TYPE>::clear()
 {
   list.clear();
+  version++;
   curRect.clear();
   curMapLayer = nullptr;
 }
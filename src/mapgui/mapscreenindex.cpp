@@ -28,10 +28,12 @@
 #include "common/maptools.h"
 #include "mapgui/mapquery.h"
 #include "common/coordinateconverter.h"
+#include "common/greatcirclecache.h"
 #include "common/constants.h"
 #include "settings/settings.h"
 
 #include <marble/GeoDataLineString.h>
+#include <marble/ViewportParams.h>
 
 using atools::geo::Pos;
 using atools::geo::Line;
@@ -50,6 +52,41 @@ MapScreenIndex::~MapScreenIndex()
 
 }
 
+void MapScreenIndex::updateSimData(const atools::fs::sc::SimConnectData& data)
+{
+  const Pos& pos = data.getUserAircraft().getPosition();
+  const Pos& lastPos = simData.getUserAircraft().getPosition();
+
+  if(pos.isValid())
+  {
+    simDataStationary = lastPos.isValid() && pos == lastPos;
+
+    if(simDataTimer.isValid())
+      simDataIntervalMs = simDataTimer.restart();
+    else
+      simDataTimer.start();
+  }
+  else
+  {
+    // Disconnected
+    simDataTimer.invalidate();
+    simDataIntervalMs = 0;
+    simDataStationary = false;
+  }
+
+  simData = data;
+  aiIndex.update(simData.getAiAircraft());
+}
+
+float MapScreenIndex::getSimDataExtrapolationSec() const
+{
+  if(!simDataTimer.isValid() || simDataStationary || simDataIntervalMs <= 0)
+    return 0.f;
+
+  qint64 maxMs = std::min(simDataIntervalMs * MAX_EXTRAPOLATION_INTERVALS, MAX_EXTRAPOLATION_MS);
+  return std::min(simDataTimer.elapsed(), maxMs) / 1000.f;
+}
+
 void MapScreenIndex::updateAirspaceScreenGeometry(const Marble::GeoDataLatLonAltBox& curBox)
 {
   airspacePolygons.clear();
@@ -78,16 +115,9 @@ void MapScreenIndex::updateAirspaceScreenGeometry(const Marble::GeoDataLatLonAlt
 
         if(airspacebox.intersects(curBox))
         {
-          QPolygon polygon;
-          int x, y;
-
-          const atools::geo::LineString *lines = mapQuery->getAirspaceGeometry(airspace.id);
-
-          for(const Pos& pos : *lines)
-          {
-            conv.wToS(pos, x, y);
-            polygon.append(QPoint(x, y));
-          }
+          QPolygonF polygonF;
+          conv.wToS(*mapQuery->getAirspaceGeometry(airspace.id), polygonF);
+          QPolygon polygon = polygonF.toPolygon();
 
           // polygon = polygon.intersected(QPolygon(mapWidget->geometry()));
           airspacePolygons.append(std::make_pair(airspace.id, polygon));
@@ -123,30 +153,45 @@ void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonAltBo
                                          Marble::GeoDataCoordinates::Degree);
 
       if(airwaybox.intersects(curBox))
-      {
         // Airway segment intersects with view rectangle
-        float distanceMeter = airway.from.distanceMeterTo(airway.to);
-        // Approximate the needed number of line segments
-        float numSegments = std::min(std::max(scale->getPixelIntForMeter(distanceMeter) / 40.f, 2.f), 72.f);
-        float step = 1.f / numSegments;
+        appendGreatCircleLines(conv, airway.from, airway.to, mapGeo, airway.id, airwayLines);
+    }
+  }
+}
 
-        // Split the segments into smaller lines and add them only if visible
-        for(int j = 0; j < numSegments; j++)
-        {
-          float cur = step * static_cast<float>(j);
-          int xs1, ys1, xs2, ys2;
-          conv.wToS(airway.from.interpolate(airway.to, distanceMeter, cur), xs1, ys1);
-          conv.wToS(airway.from.interpolate(airway.to, distanceMeter, cur + step), xs2, ys2);
-
-          QRect rect(QPoint(xs1, ys1), QPoint(xs2, ys2));
-          rect = rect.normalized();
-          // Avoid points or flat rectangles (lines)
-          rect.adjust(-1, -1, 1, 1);
-
-          if(mapGeo.intersects(rect))
-            airwayLines.append(std::make_pair(airway.id, QLine(xs1, ys1, xs2, ys2)));
-        }
-      }
+void MapScreenIndex::appendGreatCircleLines(const CoordinateConverter& conv, const Pos& pos1, const Pos& pos2,
+                                            const QRect& mapGeo, int id,
+                                            QList<std::pair<int, QLine> >& lines) const
+{
+  QPolygonF points;
+  QVector<bool> hidden;
+
+  // Jumps larger than half of the world width are caused by Mercator repetitions
+  bool mercator = conv.getViewport()->projection() == Marble::Mercator;
+  int maxJump = static_cast<int>(2. * conv.getViewport()->radius());
+
+  // Use the same densified points as the painters
+  for(const atools::geo::LineString& part : GreatCircleCache::instance().getLine(pos1, pos2))
+  {
+    conv.wToS(part, points, nullptr, CoordinateConverter::DEFAULT_WTOS_SIZE, &hidden);
+
+    // Add the smaller lines only if visible
+    for(int j = 1; j < points.size(); j++)
+    {
+      if(hidden.at(j - 1) || hidden.at(j))
+        continue;
+
+      QLine line(points.at(j - 1).toPoint(), points.at(j).toPoint());
+      if(mercator && std::abs(line.dx()) > maxJump)
+        continue;
+
+      QRect rect(line.p1(), line.p2());
+      rect = rect.normalized();
+      // Avoid points or flat rectangles (lines)
+      rect.adjust(-1, -1, 1, 1);
+
+      if(mapGeo.intersects(rect))
+        lines.append(std::make_pair(id, line));
     }
   }
 }
@@ -167,6 +212,9 @@ void MapScreenIndex::restoreState()
 
 void MapScreenIndex::updateRouteScreenGeometry(const Marble::GeoDataLatLonAltBox& curBox)
 {
+  // Visibility is checked per screen line
+  Q_UNUSED(curBox);
+
   const Route& route = NavApp::getRoute();
 
   routeLines.clear();
@@ -206,46 +254,7 @@ void MapScreenIndex::updateRouteScreenGeometry(const Marble::GeoDataLatLonAltBox
 
       if(p1.isValid())
       {
-        GeoDataLineString coords;
-        coords.setTessellate(true);
-        coords << GeoDataCoordinates(p1.getLonX(), p1.getLatY(), 0., GeoDataCoordinates::Degree)
-               << GeoDataCoordinates(p2.getLonX(), p2.getLatY(), 0., GeoDataCoordinates::Degree);
-
-        QVector<Marble::GeoDataLineString *> coordsCorrected = coords.toDateLineCorrected();
-        for(const Marble::GeoDataLineString *ls : coordsCorrected)
-        {
-          if(curBox.intersects(ls->latLonAltBox()))
-          {
-            Pos pos1(ls->first().longitude(), ls->first().latitude());
-            pos1.toDeg();
-
-            Pos pos2(ls->last().longitude(), ls->last().latitude());
-            pos2.toDeg();
-
-            float distanceMeter = pos2.distanceMeterTo(pos1);
-            // Approximate the needed number of line segments
-            float numSegments = std::min(std::max(scale->getPixelIntForMeter(distanceMeter) / 140.f, 4.f), 288.f);
-            float step = 1.f / numSegments;
-
-            // Split the legs into smaller lines and add them only if visible
-            for(int j = 0; j < numSegments; j++)
-            {
-              float cur = step * static_cast<float>(j);
-              int xs1, ys1, xs2, ys2;
-              conv.wToS(pos1.interpolate(pos2, distanceMeter, cur), xs1, ys1);
-              conv.wToS(pos1.interpolate(pos2, distanceMeter, cur + step), xs2, ys2);
-
-              QRect rect(QPoint(xs1, ys1), QPoint(xs2, ys2));
-              rect = rect.normalized();
-              // Avoid points or flat rectangles (lines)
-              rect.adjust(-1, -1, 1, 1);
-
-              if(mapGeo.intersects(rect))
-                routeLines.append(std::make_pair(i - 1, QLine(xs1, ys1, xs2, ys2)));
-            }
-          }
-        }
-        qDeleteAll(coordsCorrected);
+        appendGreatCircleLines(conv, p1, p2, mapGeo, i - 1, routeLines);
       }
       p1 = p2;
     }
@@ -255,6 +264,40 @@ void MapScreenIndex::updateRouteScreenGeometry(const Marble::GeoDataLatLonAltBox
   }
 }
 
+void MapScreenIndex::getNearestAiIndexes(const CoordinateConverter& conv, int xs, int ys, int maxDistance,
+                                         QVector<int>& indexes) const
+{
+  indexes.clear();
+
+  // Get bounding rectangle of the search area
+  float west = 180.f, east = -180.f, north = -90.f, south = 90.f;
+  bool valid = true;
+  for(const QPoint& corner : {QPoint(xs - maxDistance, ys - maxDistance), QPoint(xs + maxDistance, ys - maxDistance),
+                              QPoint(xs - maxDistance, ys + maxDistance), QPoint(xs + maxDistance, ys + maxDistance)})
+  {
+    Pos pos = conv.sToW(corner);
+    if(!pos.isValid())
+    {
+      valid = false;
+      break;
+    }
+    west = std::min(west, pos.getLonX());
+    east = std::max(east, pos.getLonX());
+    north = std::max(north, pos.getLatY());
+    south = std::min(south, pos.getLatY());
+  }
+
+  if(valid && east - west < 180.f)
+    aiIndex.getIndexes(west, north, east, south, indexes);
+  else
+  {
+    // Area is not completely on the globe or crosses the anti-meridian - check all
+    indexes.reserve(simData.getAiAircraft().size());
+    for(int i = 0; i < simData.getAiAircraft().size(); i++)
+      indexes.append(i);
+  }
+}
+
 void MapScreenIndex::getAllNearest(int xs, int ys, int maxDistance, map::MapSearchResult& result,
                                    QList<proc::MapProcedurePoint>& procPoints)
 {
@@ -281,10 +324,18 @@ void MapScreenIndex::getAllNearest(int xs, int ys, int maxDistance, map::MapSear
     using maptools::insertSortedByDistance;
     int x, y;
 
+    // Candidates from the grid index
+    const QVector<atools::fs::sc::SimConnectAircraft>& aiAircraft = simData.getAiAircraft();
+    QVector<int> aiIndexes;
+    if((shown & map::AIRCRAFT_AI_SHIP && mapLayer->isAiShipLarge()) ||
+       (shown & map::AIRCRAFT_AI && mapLayer->isAiAircraftLarge()))
+      getNearestAiIndexes(conv, xs, ys, maxDistance, aiIndexes);
+
     if(shown & map::AIRCRAFT_AI_SHIP && mapLayer->isAiShipLarge())
     {
-      for(const atools::fs::sc::SimConnectAircraft& obj : simData.getAiAircraft())
+      for(int index : aiIndexes)
       {
+        const atools::fs::sc::SimConnectAircraft& obj = aiAircraft.at(index);
         if(obj.getCategory() == atools::fs::sc::BOAT &&
            (obj.getModelRadius() * 2 > layer::LARGE_SHIP_SIZE || mapLayer->isAiShipSmall()))
         {
@@ -297,8 +348,9 @@ void MapScreenIndex::getAllNearest(int xs, int ys, int maxDistance, map::MapSear
 
     if(shown & map::AIRCRAFT_AI && mapLayer->isAiAircraftLarge())
     {
-      for(const atools::fs::sc::SimConnectAircraft& obj : simData.getAiAircraft())
+      for(int index : aiIndexes)
       {
+        const atools::fs::sc::SimConnectAircraft& obj = aiAircraft.at(index);
         if(obj.getCategory() != atools::fs::sc::BOAT &&
            (obj.getModelRadius() * 2 > layer::LARGE_AIRCRAFT_SIZE || mapLayer->isAiAircraftSmall()) &&
            (!obj.isOnGround() || mapLayer->isAiAircraftGround()))
@@ -19,9 +19,12 @@
 #define LITTLENAVMAP_MAPSCREENINDEX_H
 
 #include "fs/sc/simconnectdata.h"
+#include "common/aiaircraftindex.h"
 
 #include "route/route.h"
 
+#include <QElapsedTimer>
+
 namespace map {
 struct MapSearchResult;
 
@@ -33,6 +36,7 @@ class GeoDataLatLonAltBox;
 
 class MapWidget;
 class MapPaintLayer;
+class CoordinateConverter;
 
 /*
  * Keeps an indes of certain map objects like flight plan lines, airway lines in screen coordinates
@@ -151,11 +155,20 @@ public:
     return simData.getAiAircraft();
   }
 
-  void updateSimData(const atools::fs::sc::SimConnectData& data)
+  /* Grid index of the current AI vehicle positions */
+  const AiAircraftIndex& getAiAircraftIndex() const
   {
-    simData = data;
+    return aiIndex;
   }
 
+  /* Also measures the time between packets which is needed for extrapolation */
+  void updateSimData(const atools::fs::sc::SimConnectData& data);
+
+  /* Time in seconds which positions have to be extrapolated from the last packet.
+   * Limited to a few packet intervals to avoid runaway aircraft if packets stop.
+   * 0 if the simulator is paused or no data is available. */
+  float getSimDataExtrapolationSec() const;
+
   void updateLastSimData(const atools::fs::sc::SimConnectData& data)
   {
     lastSimData = data;
@@ -172,6 +185,15 @@ public:
   }
 
 private:
+  /* Get indexes of AI vehicles close to the screen position from the grid index */
+  void getNearestAiIndexes(const CoordinateConverter& conv, int xs, int ys, int maxDistance,
+                           QVector<int>& indexes) const;
+
+  /* Append visible screen lines of the cached great circle between pos1 and pos2 to lines using id */
+  void appendGreatCircleLines(const CoordinateConverter& conv, const atools::geo::Pos& pos1,
+                              const atools::geo::Pos& pos2, const QRect& mapGeo, int id,
+                              QList<std::pair<int, QLine> >& lines) const;
+
   void getNearestAirways(int xs, int ys, int maxDistance, map::MapSearchResult& result);
   void getNearestAirspaces(int xs, int ys, map::MapSearchResult& result);
   void getNearestHighlights(int xs, int ys, int maxDistance, map::MapSearchResult& result);
@@ -179,6 +201,17 @@ private:
                                      QList<proc::MapProcedurePoint>& procPoints);
 
   atools::fs::sc::SimConnectData simData, lastSimData;
+  AiAircraftIndex aiIndex;
+
+  /* Started when the last packet arrived */
+  QElapsedTimer simDataTimer;
+  qint64 simDataIntervalMs = 0;
+  /* User aircraft did not move between the last two packets - paused or slewing */
+  bool simDataStationary = false;
+
+  /* Extrapolate for at most this number of packet intervals or MAX_EXTRAPOLATION_MS */
+  static Q_DECL_CONSTEXPR int MAX_EXTRAPOLATION_INTERVALS = 2;
+  static Q_DECL_CONSTEXPR qint64 MAX_EXTRAPOLATION_MS = 5000;
   MapWidget *mapWidget;
   MapQuery *mapQuery;
   MapPaintLayer *paintLayer;
@@ -21,6 +21,7 @@
 #include "navapp.h"
 #include "common/constants.h"
 #include "mapgui/mappaintlayer.h"
+#include "mapgui/mappaintervehicle.h"
 #include "settings/settings.h"
 #include "common/elevationprovider.h"
 #include "gui/mainwindow.h"
@@ -29,6 +30,7 @@
 #include "common/maptools.h"
 #include "common/mapcolors.h"
 #include "connect/connectclient.h"
+#include "connect/simdatahub.h"
 #include "fs/sc/simconnectuseraircraft.h"
 #include "route/route.h"
 #include "route/routecontroller.h"
@@ -62,6 +64,12 @@ const int DEFAULT_MAP_DISTANCE = 7000;
 // Get elevation when mouse is still
 const int ALTITUDE_UPDATE_TIMEOUT = 200;
 
+/* Wait time before painting a frame again that was cut short by the time budget */
+const int REFINEMENT_TIMEOUT = 100;
+
+/* Added to each side of the repainted region around the user aircraft to cover label width changes */
+const int USER_AIRCRAFT_UPDATE_MARGIN = 20;
+
 // Update rates defined by delta values
 const static QHash<opts::SimUpdateRate, MapWidget::SimUpdateDelta> SIM_UPDATE_DELTA_MAP(
 {
@@ -132,6 +140,15 @@ MapWidget::MapWidget(MainWindow *parent)
   elevationDisplayTimer.setInterval(ALTITUDE_UPDATE_TIMEOUT);
   elevationDisplayTimer.setSingleShot(true);
   connect(&elevationDisplayTimer, &QTimer::timeout, this, &MapWidget::elevationDisplayTimerTimeout);
+
+  refinementTimer.setInterval(REFINEMENT_TIMEOUT);
+  refinementTimer.setSingleShot(true);
+  connect(&refinementTimer, &QTimer::timeout, this, &MapWidget::refinementTimerTimeout);
+
+  // Disabled by default - set to a value larger than 0 to paint the user aircraft between packets
+  extrapolationMs = atools::settings::Settings::instance().getAndStoreValue(
+    lnm::OPTIONS_SIM_EXTRAPOLATION_MS, 0).toInt();
+  connect(&extrapolationTimer, &QTimer::timeout, this, &MapWidget::extrapolationTimerTimeout);
 }
 
 MapWidget::~MapWidget()
@@ -197,6 +214,7 @@ void MapWidget::setTheme(const QString& theme, int index)
   }
 
   setMapThemeId(theme);
+  paintLayer->invalidateStaticLayers();
   updateMapObjectsShown();
 
   // atools::gui::Application::processEventsExtended();
@@ -210,9 +228,45 @@ void MapWidget::optionsChanged()
   screenSearchDistanceTooltip = OptionData::instance().getMapTooltipSensitivity();
 
   updateCacheSizes();
+  paintLayer->invalidateStaticLayers();
+  paintLayer->clearAirportDiagramCache();
+  paintLayer->clearAiLabelCache();
+  update();
+}
+
+void MapWidget::scheduleRefinement()
+{
+  refinementTimer.start();
+}
+
+void MapWidget::refinementTimerTimeout()
+{
+  if(viewContext() == Marble::Still)
+  {
+    paintLayer->setRefinementPass();
+    update();
+  }
+  else
+    // Still scrolling - try again later
+    refinementTimer.start();
+}
+
+void MapWidget::setShowPaintStatistics(bool show)
+{
+  paintLayer->setShowPaintStatistics(show);
   update();
 }
 
+bool MapWidget::savePaintStatistics(const QString& filename) const
+{
+  return paintLayer->getPaintProfiler().saveCsv(filename);
+}
+
+QStringList MapWidget::getPaintStatisticsText() const
+{
+  return paintLayer->getPaintProfiler().getOverlayText();
+}
+
 void MapWidget::updateCacheSizes()
 {
   quint64 volCacheKb = OptionData::instance().getCacheSizeMemoryMb() * 1000L;
@@ -852,6 +906,7 @@ void MapWidget::changeHome()
 void MapWidget::changeRouteHighlights(const QList<int>& routeHighlight)
 {
   screenIndex->setRouteHighlights(routeHighlight);
+  paintLayer->invalidateStaticLayers();
   update();
 }
 
@@ -863,6 +918,9 @@ void MapWidget::routeChanged(bool geometryChanged)
   {
     cancelDragAll();
     screenIndex->updateRouteScreenGeometry(currentViewBoundingBox);
+
+    // Airports of the route are painted by the route painter
+    paintLayer->invalidateStaticLayers();
     update();
   }
 }
@@ -876,6 +934,9 @@ void MapWidget::routeAltitudeChanged(float altitudeFeet)
 
   qDebug() << Q_FUNC_INFO;
   screenIndex->updateAirspaceScreenGeometry(currentViewBoundingBox);
+
+  // Airspaces are filtered by cruise altitude
+  paintLayer->invalidateStaticLayers();
   update();
 }
 
@@ -886,6 +947,14 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
     return;
 
   screenIndex->updateSimData(simulatorData);
+
+  if(extrapolationMs > 0 && !extrapolationTimer.isActive() && isExtrapolationUpdatePossible())
+  {
+    // Do not repaint faster than the update rate selected in options
+    const SimUpdateDelta& deltas = SIM_UPDATE_DELTA_MAP.value(OptionData::instance().getSimUpdateRate());
+    extrapolationTimer.start(std::max(extrapolationMs, static_cast<int>(deltas.timeDeltaMs)));
+  }
+
   const atools::fs::sc::SimConnectUserAircraft& lastUserAircraft = screenIndex->getLastUserAircraft();
 
   CoordinateConverter conv(viewport());
@@ -917,21 +986,8 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
     {
       lastSimUpdateMs = now;
 
-      // Check if any AI aircraft are visible
-      bool aiVisible = false;
-      if(paintLayer->getShownMapObjects() & map::AIRCRAFT_AI)
-      {
-        for(const atools::fs::sc::SimConnectAircraft& ai : simulatorData.getAiAircraft())
-        {
-          if(currentViewBoundingBox.contains(
-               Marble::GeoDataCoordinates(ai.getPosition().getLonX(), ai.getPosition().getLatY(), 0,
-                                          Marble::GeoDataCoordinates::Degree)))
-          {
-            aiVisible = true;
-            break;
-          }
-        }
-      }
+      // Check if any AI aircraft are visible using the grid index
+      bool aiVisible = isAiAircraftVisible();
 
       using atools::almostNotEqual;
       if(!lastUserAircraft.getPosition().isValid() ||
@@ -965,7 +1021,7 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
              centerAircraft) // Centering wanted
             centerOn(userAircraft.getPosition().getLonX(), userAircraft.getPosition().getLatY(), false);
           else
-            update();
+            updateUserAircraftRegion();
         }
       }
     }
@@ -976,11 +1032,110 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
     if(!lastUserAircraft.getPosition().isValid() || diff.manhattanLength() > 4)
     {
       screenIndex->updateLastSimData(simulatorData);
-      update();
+      updateUserAircraftRegion();
     }
   }
 }
 
+bool MapWidget::isAiAircraftVisible() const
+{
+  if(!(paintLayer->getShownMapObjects() & map::AIRCRAFT_AI))
+    return false;
+
+  using Marble::GeoDataCoordinates;
+  return screenIndex->getAiAircraftIndex().hasAircraft(
+    static_cast<float>(currentViewBoundingBox.west(GeoDataCoordinates::Degree)),
+    static_cast<float>(currentViewBoundingBox.north(GeoDataCoordinates::Degree)),
+    static_cast<float>(currentViewBoundingBox.east(GeoDataCoordinates::Degree)),
+    static_cast<float>(currentViewBoundingBox.south(GeoDataCoordinates::Degree)));
+}
+
+void MapWidget::extrapolationTimerTimeout()
+{
+  // Map is repainted anyway while scrolling or dragging
+  if(databaseLoadStatus || mouseState != mw::NONE || viewContext() != Marble::Still)
+    return;
+
+  if(!isExtrapolationUpdatePossible())
+  {
+    // Nothing moving in view or full repaint needed - started again by the next simulator packet
+    extrapolationTimer.stop();
+    return;
+  }
+
+  if(screenIndex->getSimDataExtrapolationSec() > 0.f)
+    updateUserAircraftRegion();
+}
+
+bool MapWidget::isFullUpdateNeeded() const
+{
+  const VehiclePaintBounds& bounds = paintLayer->getVehiclePaintBounds();
+
+  return (bounds.userAircraft.isNull() && paintLayer->getShownMapObjects() & map::AIRCRAFT) || // Not painted
+         (!aircraftTrack.isEmpty() && bounds.trackGeneration != aircraftTrack.getGeneration()) || // Track pruned
+         isAiAircraftVisible() || paintLayer->isShowPaintStatistics();
+}
+
+bool MapWidget::isExtrapolationUpdatePossible() const
+{
+  if(!(paintLayer->getShownMapObjects() & map::AIRCRAFT) || isFullUpdateNeeded())
+    return false;
+
+  const atools::fs::sc::SimConnectUserAircraft& userAircraft = screenIndex->getUserAircraft();
+  CoordinateConverter conv(viewport());
+  int x, y;
+  return userAircraft.getGroundSpeedKts() > 0.f && conv.wToS(userAircraft.getPosition(), x, y) &&
+         rect().contains(x, y);
+}
+
+void MapWidget::updateUserAircraftRegion()
+{
+  const VehiclePaintBounds& bounds = paintLayer->getVehiclePaintBounds();
+  map::MapObjectTypes shown = paintLayer->getShownMapObjects();
+
+  // Active leg is highlighted by the route painter
+  int activeLeg = NavApp::getRoute().getActiveLegIndexCorrected();
+  bool activeLegChanged = activeLeg != lastActiveLegIndex;
+  lastActiveLegIndex = activeLeg;
+
+  if(activeLegChanged || isFullUpdateNeeded())
+  {
+    update();
+    return;
+  }
+
+  CoordinateConverter conv(viewport());
+  const atools::fs::sc::SimConnectUserAircraft& userAircraft = screenIndex->getUserAircraft();
+
+  // Position where the next frame will paint the aircraft
+  QPointF pos = conv.wToSF(MapPainterVehicle::extrapolatePosition(userAircraft, userAircraft.getTrackDegTrue(),
+                                                                  getSimDataExtrapolationSec()));
+
+  // Area of the last frame and the same area moved to the new position
+  QRect region = bounds.userAircraft;
+  if(!region.isNull() && !pos.isNull())
+    region |= bounds.userAircraft.translated((pos - bounds.userAircraftPos).toPoint());
+
+  if(shown & map::AIRCRAFT_TRACK && !aircraftTrack.isEmpty())
+  {
+    // New track segments are attached to the end of the last painted one
+    QPolygonF track;
+    if(!bounds.trackTail.isNull())
+      track.append(bounds.trackTail);
+    for(int i = std::max(bounds.trackSize - 1, 0); i < aircraftTrack.size(); i++)
+      track.append(conv.wToSF(aircraftTrack.at(i).pos));
+    if(!pos.isNull())
+      track.append(pos);
+    region |= track.boundingRect().toAlignedRect();
+  }
+
+  if(region.isNull())
+    update();
+  else
+    update(region.adjusted(-USER_AIRCRAFT_UPDATE_MARGIN, -USER_AIRCRAFT_UPDATE_MARGIN,
+                           USER_AIRCRAFT_UPDATE_MARGIN, USER_AIRCRAFT_UPDATE_MARGIN));
+}
+
 void MapWidget::highlightProfilePoint(const atools::geo::Pos& pos)
 {
   if(pos.isValid())
@@ -1020,6 +1175,7 @@ void MapWidget::disconnectedFromSimulator()
 {
   qDebug() << Q_FUNC_INFO;
   // Clear all data on disconnect
+  extrapolationTimer.stop();
   screenIndex->updateSimData(atools::fs::sc::SimConnectData());
   updateVisibleObjectsStatusBar();
   update();
@@ -1066,18 +1222,23 @@ void MapWidget::changeApproachHighlight(const proc::MapProcedureLegs& approach)
   cancelDragAll();
   screenIndex->getProcedureHighlight() = approach;
   screenIndex->updateRouteScreenGeometry(currentViewBoundingBox);
+
+  // Selection changes are rare - render all layers again so that no painter shows an outdated highlight
+  paintLayer->invalidateStaticLayers();
   update();
 }
 
 void MapWidget::changeSearchHighlights(const map::MapSearchResult& positions)
 {
   screenIndex->getSearchHighlights() = positions;
+  paintLayer->invalidateStaticLayers();
   update();
 }
 
 void MapWidget::changeProcedureLegHighlights(const proc::MapProcedureLeg *leg)
 {
   screenIndex->setApproachLegHighlights(leg);
+  paintLayer->invalidateStaticLayers();
   update();
 }
 
@@ -1981,7 +2142,7 @@ void MapWidget::mouseMoveEvent(QMouseEvent *event)
       atools::fs::sc::SimConnectData data = atools::fs::sc::SimConnectData::buildDebugForPosition(pos, lastPos);
       data.setPacketId(packetId++);
 
-      emit NavApp::getConnectClient()->dataPacketReceived(data);
+      NavApp::getConnectClient()->getSimDataHub()->post(data);
       lastPos = pos;
       lastPoint = event->pos();
     }
@@ -2345,6 +2506,16 @@ const QVector<atools::fs::sc::SimConnectAircraft>& MapWidget::getAiAircraft() co
   return screenIndex->getAiAircraft();
 }
 
+const AiAircraftIndex& MapWidget::getAiAircraftIndex() const
+{
+  return screenIndex->getAiAircraftIndex();
+}
+
+float MapWidget::getSimDataExtrapolationSec() const
+{
+  return extrapolationMs > 0 ? screenIndex->getSimDataExtrapolationSec() : 0.f;
+}
+
 void MapWidget::deleteAircraftTrack()
 {
   aircraftTrack.clearTrack();
@@ -46,6 +46,7 @@ class MapQuery;
 class RouteController;
 class MapTooltip;
 class QRubberBand;
+class AiAircraftIndex;
 class MapScreenIndex;
 class Route;
 
@@ -189,6 +190,19 @@ public:
 
   void optionsChanged();
 
+  /* Repaint the map without time budget as soon as it is still. Called by the paint layer if a frame was
+   * cut short. */
+  void scheduleRefinement();
+
+  /* Show or hide the painter timing overlay */
+  void setShowPaintStatistics(bool show);
+
+  /* Write collected frame timings to a CSV file. Returns false on error. */
+  bool savePaintStatistics(const QString& filename) const;
+
+  /* Average and maximum paint times of the latest frames */
+  QStringList getPaintStatisticsText() const;
+
   /* Update map */
   void postDatabaseLoad();
 
@@ -237,6 +251,11 @@ public:
   const atools::fs::sc::SimConnectUserAircraft& getUserAircraft() const;
 
   const QVector<atools::fs::sc::SimConnectAircraft>& getAiAircraft() const;
+  const AiAircraftIndex& getAiAircraftIndex() const;
+
+  /* Seconds that vehicle positions have to be extrapolated beyond the last simulator packet.
+   * 0 if extrapolation is disabled. */
+  float getSimDataExtrapolationSec() const;
 
   MainWindow *getParentWindow() const
   {
@@ -360,6 +379,22 @@ private:
   void cancelDragDistance();
   void cancelDragRoute();
   void elevationDisplayTimerTimeout();
+  void refinementTimerTimeout();
+  void extrapolationTimerTimeout();
+
+  /* true if any AI vehicle is within the current view */
+  bool isAiAircraftVisible() const;
+
+  /* Repaint only the region covered by the user aircraft in the last frame and at its new position
+   * including new track segments. Falls back to a full update if AI vehicles are visible or the region
+   * is not known. */
+  void updateUserAircraftRegion();
+
+  /* true if updateUserAircraftRegion cannot use a partial update. Does not check the active leg. */
+  bool isFullUpdateNeeded() const;
+
+  /* true if the user aircraft moves within the view and can be repainted using a partial update */
+  bool isExtrapolationUpdatePossible() const;
 
   /* Defines amount of objects and other attributes on the map. min 5, max 15, default 10. */
   int mapDetailLevel;
@@ -425,6 +460,19 @@ private:
 
   /* Delay display of elevation display to avoid lagging mouse movements */
   QTimer elevationDisplayTimer;
+
+  /* Delay refinement pass to avoid repainting while still scrolling */
+  QTimer refinementTimer;
+
+  /* Repaints the user aircraft between simulator packets if only a partial update is needed.
+   * Runs only while the aircraft moves in view and not faster than the simulator update rate. */
+  QTimer extrapolationTimer;
+
+  /* Minimum extrapolation interval from settings. 0 disables extrapolation. */
+  int extrapolationMs = 0;
+
+  /* Active flight plan leg of the last aircraft update. A change needs a full repaint. */
+  int lastActiveLegIndex = -1;
 };
 
 Q_DECLARE_TYPEINFO(MapWidget::SimUpdateDelta, Q_PRIMITIVE_TYPE);
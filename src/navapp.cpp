@@ -19,6 +19,7 @@
 
 #include "common/infoquery.h"
 #include "common/procedurequery.h"
+#include "common/stringpool.h"
 #include "connect/connectclient.h"
 #include "mapgui/mapquery.h"
 #include "db/databasemanager.h"
@@ -140,6 +141,9 @@ void NavApp::preDatabaseLoad()
   mapQuery->deInitQueries();
   procedureQuery->deInitQueries();
 
+  // Caches and route networks are cleared - drop strings of the old database
+  StringPool::instance().clear();
+
   delete databaseMeta;
   databaseMeta = nullptr;
 }
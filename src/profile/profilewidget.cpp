@@ -215,14 +215,18 @@ bool ProfileWidget::aircraftTrackValid()
     int minTrackX = std::numeric_limits<int>::max(), maxTrackX = 0;
     if(!NavApp::getRoute().isFlightplanEmpty() && showAircraftTrack)
     {
-      for(const at::AircraftTrackPos& trackPos : NavApp::getMapWidget()->getAircraftTrack())
+      const AircraftTrack& aircraftTrack = NavApp::getMapWidget()->getAircraftTrack();
+      for(int chunk = 0; chunk < aircraftTrack.getNumChunks(); chunk++)
       {
-        float distFromStart = legList.route.getDistanceFromStart(trackPos.pos);
-        if(distFromStart < map::INVALID_DISTANCE_VALUE)
+        for(const at::AircraftTrackPos& trackPos : aircraftTrack.getChunk(chunk))
         {
-          int x = X0 + static_cast<int>(distFromStart * horizontalScale);
-          minTrackX = std::min(x, minTrackX);
-          maxTrackX = std::max(x, maxTrackX);
+          float distFromStart = legList.route.getDistanceFromStart(trackPos.pos);
+          if(distFromStart < map::INVALID_DISTANCE_VALUE)
+          {
+            int x = X0 + static_cast<int>(distFromStart * horizontalScale);
+            minTrackX = std::min(x, minTrackX);
+            maxTrackX = std::max(x, maxTrackX);
+          }
         }
       }
     }
@@ -302,18 +306,21 @@ void ProfileWidget::updateScreenCoords()
     const Route& route = legList.route;
     const AircraftTrack& aircraftTrack = mapWidget->getAircraftTrack();
 
-    for(int i = 0; i < aircraftTrack.size(); i++)
+    for(int chunk = 0; chunk < aircraftTrack.getNumChunks(); chunk++)
     {
-      const Pos& aircraftPos = aircraftTrack.at(i).pos;
-      float distFromStart = route.getDistanceFromStart(aircraftPos);
-
-      if(distFromStart < map::INVALID_DISTANCE_VALUE)
+      for(const at::AircraftTrackPos& trackPos : aircraftTrack.getChunk(chunk))
       {
-        QPoint pt(X0 + static_cast<int>(distFromStart * horizontalScale),
-                  Y0 + static_cast<int>(rect().height() - Y0 - aircraftPos.getAltitude() * verticalScale));
+        const Pos& aircraftPos = trackPos.pos;
+        float distFromStart = route.getDistanceFromStart(aircraftPos);
 
-        if(aircraftTrackPoints.isEmpty() || (aircraftTrackPoints.last() - pt).manhattanLength() > 3)
-          aircraftTrackPoints.append(pt);
+        if(distFromStart < map::INVALID_DISTANCE_VALUE)
+        {
+          QPoint pt(X0 + static_cast<int>(distFromStart * horizontalScale),
+                    Y0 + static_cast<int>(rect().height() - Y0 - aircraftPos.getAltitude() * verticalScale));
+
+          if(aircraftTrackPoints.isEmpty() || (aircraftTrackPoints.last() - pt).manhattanLength() > 3)
+            aircraftTrackPoints.append(pt);
+        }
       }
     }
   }
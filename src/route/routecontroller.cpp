@@ -825,11 +825,16 @@ bool RouteController::saveFlighplanAsGpx(const QString& filename)
   const AircraftTrack& aircraftTrack = NavApp::getAircraftTrack();
   atools::geo::LineString track;
   QVector<quint32> timestamps;
+  track.reserve(aircraftTrack.size());
+  timestamps.reserve(aircraftTrack.size());
 
-  for(const at::AircraftTrackPos& pos : aircraftTrack)
+  for(int chunk = 0; chunk < aircraftTrack.getNumChunks(); chunk++)
   {
-    track.append(pos.pos);
-    timestamps.append(pos.timestamp);
+    for(const at::AircraftTrackPos& pos : aircraftTrack.getChunk(chunk))
+    {
+      track.append(pos.pos);
+      timestamps.append(pos.timestamp);
+    }
   }
 
   try
@@ -2776,30 +2781,25 @@ void RouteController::disconnectedFromSimulator()
   emit routeChanged(false);
 }
 
+/* Called by the SimDataHub not more often than MIN_SIM_UPDATE_TIME_MS */
 void RouteController::simDataChanged(const atools::fs::sc::SimConnectData& simulatorData)
 {
-  if(atools::almostNotEqual(QDateTime::currentDateTime().toMSecsSinceEpoch(),
-                            lastSimUpdate, static_cast<qint64>(MIN_SIM_UPDATE_TIME_MS)))
+  const atools::fs::sc::SimConnectUserAircraft& aircraft = simulatorData.getUserAircraft();
+
+  // Sequence only for airborne airplanes
+  if(!aircraft.isOnGround())
   {
-    const atools::fs::sc::SimConnectUserAircraft& aircraft = simulatorData.getUserAircraft();
+    map::PosCourse position(aircraft.getPosition(), aircraft.getTrackDegTrue());
+    int previousRouteLeg = route.getActiveLegIndexCorrected();
+    route.updateActiveLegAndPos(position);
+    int routeLeg = route.getActiveLegIndexCorrected();
 
-    // Sequence only for airborne airplanes
-    if(!aircraft.isOnGround())
+    if(routeLeg != previousRouteLeg)
     {
-      map::PosCourse position(aircraft.getPosition(), aircraft.getTrackDegTrue());
-      int previousRouteLeg = route.getActiveLegIndexCorrected();
-      route.updateActiveLegAndPos(position);
-      int routeLeg = route.getActiveLegIndexCorrected();
-
-      if(routeLeg != previousRouteLeg)
-      {
-        // Use corrected indexes to highlight initial fix
-        qDebug() << "new route leg" << previousRouteLeg << routeLeg;
-        highlightNextWaypoint(routeLeg);
-      }
+      // Use corrected indexes to highlight initial fix
+      qDebug() << "new route leg" << previousRouteLeg << routeLeg;
+      highlightNextWaypoint(routeLeg);
     }
-
-    lastSimUpdate = QDateTime::currentDateTime().toMSecsSinceEpoch();
   }
 }
 
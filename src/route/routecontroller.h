@@ -64,6 +64,9 @@ class RouteController :
   Q_OBJECT
 
 public:
+  /* Do not update aircraft information more than every 0.1 seconds */
+  static Q_DECL_CONSTEXPR int MIN_SIM_UPDATE_TIME_MS = 100;
+
   RouteController(QMainWindow *parent, QTableView *tableView);
   virtual ~RouteController();
 
@@ -381,10 +384,7 @@ private:
   QUndoStack *undoStack = nullptr;
   FlightplanEntryBuilder *entryBuilder = nullptr;
 
-  /* Do not update aircraft information more than every 0.1 seconds */
-  static Q_DECL_CONSTEXPR int MIN_SIM_UPDATE_TIME_MS = 100;
   static Q_DECL_CONSTEXPR int ROUTE_ALT_CHANGE_DELAY_MS = 1000;
-  qint64 lastSimUpdate = 0;
 
   QIcon ndbIcon, waypointIcon, userpointIcon, invalidIcon, procedureIcon;
   SymbolPainter *symbolPainter = nullptr;
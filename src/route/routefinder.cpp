@@ -16,6 +16,7 @@
 *****************************************************************************/
 
 #include "route/routefinder.h"
+#include "common/stringpool.h"
 #include "geo/calculations.h"
 #include "atools.h"
 
@@ -30,7 +31,7 @@ RouteFinder::RouteFinder(RouteNetwork *routeNetwork)
   nodeCosts.reserve(10000);
   nodePredecessor.reserve(10000);
   nodeAirwayId.reserve(10000);
-  nodeAirwayName.reserve(10000);
+  nodeAirwayNameHandle.reserve(10000);
 
   successorNodes.reserve(500);
   successorEdges.reserve(500);
@@ -124,9 +125,9 @@ void RouteFinder::expandNode(const nw::Node& currentNode, const nw::Node& destNo
   successorEdges.clear();
   network->getNeighbours(currentNode, successorNodes, successorEdges);
 
-  QString currentNodeAirway;
+  int currentNodeAirway = StringPool::INVALID_HANDLE;
   if(network->isAirwayRouting())
-    currentNodeAirway = nodeAirwayName[currentNode.id];
+    currentNodeAirway = nodeAirwayNameHandle.value(currentNode.id, StringPool::INVALID_HANDLE);
 
   for(int i = 0; i < successorNodes.size(); i++)
   {
@@ -151,7 +152,8 @@ void RouteFinder::expandNode(const nw::Node& currentNode, const nw::Node& destNo
     float successorEdgeCosts = calculateEdgeCost(currentNode, successor, lengthMeter);
 
     // Avoid jumping between equal airways
-    if(!currentNodeAirway.isEmpty() && !edge.airwayName.isEmpty() && currentNodeAirway != edge.airwayName)
+    if(currentNodeAirway != StringPool::INVALID_HANDLE && edge.airwayNameHandle != StringPool::INVALID_HANDLE &&
+       currentNodeAirway != edge.airwayNameHandle)
       successorEdgeCosts *= COST_FACTOR_AIRWAY_CHANGE;
 
     float successorNodeCosts = nodeCosts.value(currentNode.id) + successorEdgeCosts;
@@ -163,7 +165,7 @@ void RouteFinder::expandNode(const nw::Node& currentNode, const nw::Node& destNo
     // New path is cheaper - update node
     nodeAirwayId[successor.id] = successorEdges.at(i).airwayId;
     if(network->isAirwayRouting())
-      nodeAirwayName[successor.id] = successorEdges.at(i).airwayName;
+      nodeAirwayNameHandle[successor.id] = successorEdges.at(i).airwayNameHandle;
     nodePredecessor[successor.id] = currentNode.id;
     nodeCosts[successor.id] = successorNodeCosts;
 
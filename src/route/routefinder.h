@@ -122,7 +122,8 @@ private:
   QHash<int, int> nodePredecessor;
   /* Maps node id to predecessor airway id */
   QHash<int, int> nodeAirwayId;
-  QHash<int, QString> nodeAirwayName;
+  /* Maps node id to predecessor airway name handle from StringPool */
+  QHash<int, int> nodeAirwayNameHandle;
 
   /* For RouteNetwork::getNeighbours to avoid instantiations */
   QVector<nw::Node> successorNodes;
@@ -17,6 +17,8 @@
 
 #include "routenetwork.h"
 
+#include "common/stringpool.h"
+
 #include "sql/sqldatabase.h"
 #include "sql/sqlquery.h"
 #include "sql/sqlrecord.h"
@@ -486,7 +488,7 @@ nw::Edge RouteNetwork::createEdge(const atools::sql::SqlRecord& rec, int toNodeI
   if(edgeAirwayIdIndex != -1)
     edge.airwayId = rec.valueInt(edgeAirwayIdIndex);
   if(edgeAirwayNameIndex != -1)
-    edge.airwayName = rec.valueStr(edgeAirwayNameIndex);
+    edge.airwayNameHandle = StringPool::instance().handle(rec.valueStr(edgeAirwayNameIndex));
   if(edgeDistanceIndex != -1)
     edge.lengthMeter = rec.valueInt(edgeDistanceIndex);
   return edge;
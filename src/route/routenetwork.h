@@ -19,6 +19,7 @@
 #define LITTLENAVMAP_ROUTENETWORK_H
 
 #include "common/maptypes.h"
+#include "common/stringpool.h"
 #include "geo/calculations.h"
 
 #include <QHash>
@@ -89,7 +90,8 @@ struct Edge
 
   int toNodeId /* database "node_id" */, lengthMeter, minAltFt, airwayId;
   nw::EdgeType type;
-  QString airwayName;
+  /* Airway name handle in StringPool. Resolve for display only. */
+  int airwayNameHandle = StringPool::INVALID_HANDLE;
 
   bool operator==(const nw::Edge& other) const
   {